@@ -0,0 +1,40 @@
+#include "ArgumentStack.h"
+#include <algorithm>
+
+
+ArgumentStack::Frame::Frame(ArgumentStack &stack, size_t count) : stack(stack), previousBlock(stack.currentBlock), previousTop(stack.top) {
+    arguments = LoxArguments(stack.allocate(count), count);
+}
+
+ArgumentStack::Frame::~Frame() {
+    //Arguments are usually moved into the callee's environment, this drops whatever is left so the slots don't keep objects alive
+    for (LoxObject &argument : arguments){
+        argument = LoxObject::Nil();
+    }
+
+    stack.currentBlock = previousBlock;
+    stack.top = previousTop;
+}
+
+LoxObject* ArgumentStack::allocate(size_t count) {
+    if (blocks.empty()){
+        blocks.push_back({std::make_unique<LoxObject[]>(BLOCK_SIZE), BLOCK_SIZE});
+    }
+
+    if (top + count > blocks[currentBlock].size){
+        //Doesn't fit in the current block, continue in the next one. The rest of the current block stays unused until this frame is released.
+        currentBlock++;
+        top = 0;
+        if (currentBlock == blocks.size()){
+            size_t size = std::max(BLOCK_SIZE, count);
+            blocks.push_back({std::make_unique<LoxObject[]>(size), size});
+        } else if (blocks[currentBlock].size < count){
+            size_t size = std::max(BLOCK_SIZE, count);
+            blocks[currentBlock] = {std::make_unique<LoxObject[]>(size), size};
+        }
+    }
+
+    LoxObject* slots = blocks[currentBlock].slots.get() + top;
+    top += count;
+    return slots;
+}
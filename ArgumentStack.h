@@ -0,0 +1,48 @@
+#ifndef JLOX_ARGUMENTSTACK_H
+#define JLOX_ARGUMENTSTACK_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "LoxCallable.h"
+#include "LoxObject.h"
+
+/*Reusable storage for the arguments of calls. Instead of building a std::vector<LoxObject> for every call, the arguments are evaluated
+ * into slots of this stack and passed to the callee as a span, so a call doesn't touch the heap once the stack has warmed up.
+ * The stack is made of fixed blocks that are never moved or freed. The arguments of one call are always contiguous inside one block,
+ * so a span stays valid while nested calls push their own arguments on top of it.
+ * */
+class ArgumentStack {
+public:
+    //Reserves the slots for the arguments of one call and releases them (in LIFO order) when it goes out of scope, even if the call throws.
+    class Frame {
+    public:
+        Frame(ArgumentStack &stack, size_t count);
+        ~Frame();
+        Frame(const Frame&) = delete;
+        Frame& operator=(const Frame&) = delete;
+
+        LoxArguments arguments;
+
+    private:
+        ArgumentStack &stack;
+        size_t previousBlock, previousTop;
+    };
+
+private:
+    //The parser doesn't allow more than 255 arguments, so a block can always hold the arguments of at least one call
+    static constexpr size_t BLOCK_SIZE = 256;
+
+    struct Block {
+        std::unique_ptr<LoxObject[]> slots;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+    size_t currentBlock = 0, top = 0;
+
+    LoxObject* allocate(size_t count);
+};
+
+
+#endif //JLOX_ARGUMENTSTACK_H
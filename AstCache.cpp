@@ -0,0 +1,69 @@
+#include "AstCache.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <sys/stat.h>
+#include "AstSerializer.h"
+#include "tools/BinaryStream.h"
+
+namespace {
+    constexpr char MAGIC[8] = {'L', 'O', 'X', 'A', 'S', 'T', '\0', '\0'};
+}
+
+AstCache::AstCache(std::string directory) : directory(std::move(directory)) {}
+
+std::shared_ptr<const Program> AstCache::load(const std::string &source) {
+    uint64_t hash = binary::fnv1a(source);
+    binary::MappedFile file(entryPath(hash));
+    if (!file.isOpen()) return nullptr;
+
+    try {
+        binary::Reader in(file.data(), file.size());
+        if (std::memcmp(in.raw(sizeof(MAGIC)), MAGIC, sizeof(MAGIC)) != 0) return nullptr;
+        if (in.u32() != FORMAT_VERSION) return nullptr;
+        //Guards against hash collisions (and entries renamed by hand) as far as it is cheap to do so
+        if (in.u64() != hash || in.u64() != source.size()) return nullptr;
+
+        uint64_t payloadHash = in.u64();
+        size_t payloadSize = in.varint();
+        const uint8_t* payload = in.raw(payloadSize);
+        if (!in.atEnd() || binary::fnv1a(std::string_view(reinterpret_cast<const char*>(payload), payloadSize)) != payloadHash){
+            return nullptr; //Truncated or corrupted entry
+        }
+
+        binary::Reader payloadReader(payload, payloadSize);
+        AstDeserializer deserializer;
+        auto program = std::make_shared<const Program>(deserializer.deserialize(payloadReader));
+        if (!payloadReader.atEnd()) return nullptr;
+        return program;
+    } catch (const binary::FormatError &error) {
+        return nullptr;
+    }
+}
+
+void AstCache::store(const std::string &source, const std::shared_ptr<const Program> &program) {
+    binary::Writer payload;
+    AstSerializer serializer;
+    serializer.serialize(*program, payload);
+
+    uint64_t hash = binary::fnv1a(source);
+    binary::Writer out;
+    out.raw(MAGIC, sizeof(MAGIC));
+    out.u32(FORMAT_VERSION);
+    out.u64(hash);
+    out.u64(source.size());
+    out.u64(binary::fnv1a(payload.bytes));
+    out.varint(payload.bytes.size());
+    out.raw(payload.bytes.data(), payload.bytes.size());
+
+    mkdir(directory.c_str(), 0755); //Fails if it already exists, which is fine
+    binary::writeFileAtomically(entryPath(hash), out.bytes);
+}
+
+std::string AstCache::entryPath(uint64_t hash) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.loxast", (unsigned long long) hash);
+    return directory + "/" + name;
+}
@@ -0,0 +1,35 @@
+#ifndef JLOX_ASTCACHE_H
+#define JLOX_ASTCACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "Program.h"
+#include "ProgramCache.h"
+
+/*Cache of resolved programs, so running the same script again skips the Scanner, the Parser and the Resolver.
+ * Every entry is a file called <hash of the source>.loxast inside the cache directory, which contains a small header
+ * (magic, format version, hash and size of the source, checksum of the payload) followed by the program written by AstSerializer. Entries that don't match
+ * the source or were written by a different version of the format are ignored and overwritten.
+ * Loading still builds a new AST on the heap: the entry is mapped, checked and deserialized, which is much cheaper than scanning,
+ * parsing and resolving but not free (the nodes aren't laid out so they could be used in place). Entries are written atomically, so
+ * concurrent runs never see a partial entry.
+ * */
+class AstCache : public ProgramCache {
+public:
+    //Bump it whenever the AST, TokenType or the serialization format change
+    static constexpr uint32_t FORMAT_VERSION = 4;
+
+    explicit AstCache(std::string directory);
+
+    std::shared_ptr<const Program> load(const std::string &source) override;
+    void store(const std::string &source, const std::shared_ptr<const Program> &program) override;
+
+private:
+    std::string directory;
+
+    std::string entryPath(uint64_t hash) const;
+};
+
+
+#endif //JLOX_ASTCACHE_H
@@ -0,0 +1,678 @@
+#include "AstSerializer.h"
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include "Environment.h"
+#include "TokenType.h"
+
+namespace {
+    enum class NodeTag : uint8_t {
+        NONE, //nullptr or empty optional
+
+        BINARY, GROUPING, UNARY, LITERAL, VARIABLE, ASSIGNMENT, OR, AND, CALL, INCREMENT, DECREMENT, LAMBDA, GET, SET, THIS, SUPER, LIST,
+
+        EXPRESSION_STMT, PRINT, VAR_DECLARATION, BLOCK, IF, WHILE, BREAK, CONTINUE, FOR, FUNCTION, RETURN, CLASS, FOR_IN
+    };
+
+    //Upper bound for the length of vectors read from the data, so a corrupted count can't make us allocate gigabytes
+    constexpr uint64_t MAX_COUNT = 1 << 24;
+}
+
+
+void AstSerializer::serialize(const Program &program, binary::Writer &out, std::unordered_map<const void*, uint64_t>* nodeIds) {
+    body = binary::Writer();
+    this->nodeIds = nodeIds;
+    stringIndices.clear();
+    strings.clear();
+
+    write(program.statements);
+
+    out.varint(strings.size());
+    for (const std::string* string : strings){
+        out.string(*string);
+    }
+    out.raw(body.bytes.data(), body.bytes.size());
+}
+
+void AstSerializer::addNode(const void *node) {
+    if (nodeIds != nullptr){
+        nodeIds->emplace(node, nodeIds->size());
+    }
+}
+
+void AstSerializer::write(Expr *expr) {
+    if (expr == nullptr){
+        body.u8((uint8_t) NodeTag::NONE);
+        return;
+    }
+
+    addNode(expr);
+    expr->accept(*this);
+}
+
+void AstSerializer::write(Stmt *stmt) {
+    if (stmt == nullptr){
+        body.u8((uint8_t) NodeTag::NONE);
+        return;
+    }
+
+    addNode(stmt);
+    stmt->accept(*this);
+}
+
+void AstSerializer::write(const std::optional<UniqueExprPtr> &expr) {
+    write(expr.has_value() ? expr.value().get() : nullptr);
+}
+
+void AstSerializer::write(const std::optional<UniqueStmtPtr> &stmt) {
+    write(stmt.has_value() ? stmt.value().get() : nullptr);
+}
+
+void AstSerializer::write(const std::vector<UniqueExprPtr> &exprs) {
+    body.varint(exprs.size());
+    for (const UniqueExprPtr &expr : exprs){
+        write(expr.get());
+    }
+}
+
+void AstSerializer::write(const std::vector<UniqueStmtPtr> &stmts) {
+    body.varint(stmts.size());
+    for (const UniqueStmtPtr &stmt : stmts){
+        write(stmt.get());
+    }
+}
+
+void AstSerializer::write(const Token &token) {
+    body.varint(token.type);
+    write(token.lexeme);
+    body.varint((uint32_t) token.line);
+}
+
+//0 if the resolver didn't find the variable in a local scope (it's global), distance + 1 otherwise
+void AstSerializer::writeDistance(const std::optional<int> &distance) {
+    body.varint(distance.has_value() ? (uint64_t) distance.value() + 1 : 0);
+}
+
+void AstSerializer::write(const std::vector<Token> &tokens) {
+    body.varint(tokens.size());
+    for (const Token &token : tokens){
+        write(token);
+    }
+}
+
+void AstSerializer::write(const LoxObject &literal) {
+    body.u8((uint8_t) literal.type);
+    switch (literal.type) {
+        case LoxType::NIL:
+            break;
+        case LoxType::BOOL:
+            body.u8(literal.getBoolean());
+            break;
+        case LoxType::NUMBER:
+            body.number(literal.getNumber());
+            break;
+        case LoxType::STRING:
+            write(literal.getString());
+            break;
+        default:
+            throw std::runtime_error("Literal of type " + loxTypeToString(literal.type) + " cannot be serialized");
+    }
+}
+
+void AstSerializer::write(const std::string &string) {
+    auto [it, inserted] = stringIndices.try_emplace(string, strings.size());
+    if (inserted){
+        strings.push_back(&it->first);
+    }
+    body.varint(it->second);
+}
+
+void AstSerializer::writeFunction(const FunctionDeclStmt *functionStmt) {
+    write(functionStmt->name);
+    write(functionStmt->params);
+    write(functionStmt->body);
+}
+
+
+LoxObject AstSerializer::visit(const BinaryExpr *binaryExpr) {
+    body.u8((uint8_t) NodeTag::BINARY);
+    write(binaryExpr->left.get());
+    write(binaryExpr->right.get());
+    write(binaryExpr->op);
+    return LoxObject::Nil();
+}
+
+LoxObject AstSerializer::visit(const GroupingExpr *groupingExpr) {
+    body.u8((uint8_t) NodeTag::GROUPING);
+    write(groupingExpr->expr.get());
+    return LoxObject::Nil();
+}
+
+LoxObject AstSerializer::visit(const UnaryExpr *unaryExpr) {
+    body.u8((uint8_t) NodeTag::UNARY);
+    write(unaryExpr->op);
+    write(unaryExpr->expr.get());
+    return LoxObject::Nil();
+}
+
+LoxObject AstSerializer::visit(const LiteralExpr *literalExpr) {
+    body.u8((uint8_t) NodeTag::LITERAL);
+    write(literalExpr->literal);
+    return LoxObject::Nil();
+}
+
+LoxObject AstSerializer::visit(const VariableExpr *variableExpr) {
+    body.u8((uint8_t) NodeTag::VARIABLE);
+    write(variableExpr->identifier);
+    writeDistance(variableExpr->distance);
+    return LoxObject::Nil();
+}
+
+LoxObject AstSerializer::visit(const AssignmentExpr *assignmentExpr) {
+    body.u8((uint8_t) NodeTag::ASSIGNMENT);
+    write(assignmentExpr->identifier);
+    writeDistance(assignmentExpr->distance);
+    write(assignmentExpr->value.get());
+    return LoxObject::Nil();
+}
+
+LoxObject AstSerializer::visit(const OrExpr *orExpr) {
+    body.u8((uint8_t) NodeTag::OR);
+    write(orExpr->left.get());
+    write(orExpr->right.get());
+    return LoxObject::Nil();
+}
+
+LoxObject AstSerializer::visit(const AndExpr *andExpr) {
+    body.u8((uint8_t) NodeTag::AND);
+    write(andExpr->left.get());
+    write(andExpr->right.get());
+    return LoxObject::Nil();
+}
+
+LoxObject AstSerializer::visit(const CallExpr *callExpr) {
+    body.u8((uint8_t) NodeTag::CALL);
+    write(callExpr->callee.get());
+    write(callExpr->closingParen);
+    write(callExpr->arguments);
+    return LoxObject::Nil();
+}
+
+LoxObject AstSerializer::visit(const IncrementExpr *incrementExpr) {
+    body.u8((uint8_t) NodeTag::INCREMENT);
+    write(incrementExpr->variable.get());
+    body.u8((uint8_t) incrementExpr->type);
+    return LoxObject::Nil();
+}
+
+LoxObject AstSerializer::visit(const DecrementExpr *decrementExpr) {
+    body.u8((uint8_t) NodeTag::DECREMENT);
+    write(decrementExpr->variable.get());
+    body.u8((uint8_t) decrementExpr->type);
+    return LoxObject::Nil();
+}
+
+LoxObject AstSerializer::visit(const LambdaExpr *lambdaExpr) {
+    body.u8((uint8_t) NodeTag::LAMBDA);
+    write(lambdaExpr->params);
+    write(lambdaExpr->body.get());
+    return LoxObject::Nil();
+}
+
+LoxObject AstSerializer::visit(const GetExpr *getExpr) {
+    body.u8((uint8_t) NodeTag::GET);
+    write(getExpr->expr.get());
+    write(getExpr->identifier);
+    return LoxObject::Nil();
+}
+
+LoxObject AstSerializer::visit(const SetExpr *setExpr) {
+    body.u8((uint8_t) NodeTag::SET);
+    write(setExpr->object.get());
+    write(setExpr->identifier);
+    write(setExpr->value.get());
+    return LoxObject::Nil();
+}
+
+LoxObject AstSerializer::visit(const ThisExpr *thisExpr) {
+    body.u8((uint8_t) NodeTag::THIS);
+    write(thisExpr->keyword);
+    writeDistance(thisExpr->distance);
+    return LoxObject::Nil();
+}
+
+LoxObject AstSerializer::visit(const SuperExpr *superExpr) {
+    body.u8((uint8_t) NodeTag::SUPER);
+    write(superExpr->keyword);
+    write(superExpr->identifier);
+    writeDistance(superExpr->distance);
+    return LoxObject::Nil();
+}
+
+LoxObject AstSerializer::visit(const ListExpr *listExpr) {
+    body.u8((uint8_t) NodeTag::LIST);
+    write(listExpr->openingBracket);
+    write(listExpr->items);
+    return LoxObject::Nil();
+}
+
+void AstSerializer::visit(const ExpressionStmt *expressionStmt) {
+    body.u8((uint8_t) NodeTag::EXPRESSION_STMT);
+    write(expressionStmt->expr.get());
+}
+
+void AstSerializer::visit(const PrintStmt *printStmt) {
+    body.u8((uint8_t) NodeTag::PRINT);
+    write(printStmt->expr);
+}
+
+void AstSerializer::visit(const VarDeclarationStmt *varDeclarationStmt) {
+    body.u8((uint8_t) NodeTag::VAR_DECLARATION);
+    write(varDeclarationStmt->identifier);
+    write(varDeclarationStmt->expr);
+}
+
+void AstSerializer::visit(const BlockStmt *blockStmt) {
+    body.u8((uint8_t) NodeTag::BLOCK);
+    write(blockStmt->statements);
+}
+
+void AstSerializer::visit(const IfStmt *ifStmt) {
+    body.u8((uint8_t) NodeTag::IF);
+    write(ifStmt->mainBranch.condition.get());
+    write(ifStmt->mainBranch.statement.get());
+    body.varint(ifStmt->elifBranches.size());
+    for (const IfBranch &branch : ifStmt->elifBranches){
+        write(branch.condition.get());
+        write(branch.statement.get());
+    }
+    write(ifStmt->elseBranch);
+}
+
+void AstSerializer::visit(const WhileStmt *whileStmt) {
+    body.u8((uint8_t) NodeTag::WHILE);
+    write(whileStmt->condition.get());
+    write(whileStmt->body.get());
+}
+
+void AstSerializer::visit(const BreakStmt *breakStmt) {
+    body.u8((uint8_t) NodeTag::BREAK);
+    write(breakStmt->keyword);
+}
+
+void AstSerializer::visit(const ContinueStmt *continueStmt) {
+    body.u8((uint8_t) NodeTag::CONTINUE);
+    write(continueStmt->keyword);
+}
+
+void AstSerializer::visit(const ForStmt *forStmt) {
+    body.u8((uint8_t) NodeTag::FOR);
+    write(forStmt->initializer);
+    write(forStmt->condition);
+    write(forStmt->increment);
+    write(forStmt->body.get());
+}
+
+void AstSerializer::visit(const ForInStmt *forInStmt) {
+    body.u8((uint8_t) NodeTag::FOR_IN);
+    write(forInStmt->name);
+    write(forInStmt->iterable.get());
+    write(forInStmt->body.get());
+}
+
+void AstSerializer::visit(const FunctionDeclStmt *functionStmt) {
+    body.u8((uint8_t) NodeTag::FUNCTION);
+    writeFunction(functionStmt);
+}
+
+void AstSerializer::visit(const ReturnStmt *returnStmt) {
+    body.u8((uint8_t) NodeTag::RETURN);
+    write(returnStmt->keyword);
+    write(returnStmt->expr);
+}
+
+void AstSerializer::visit(const ClassDeclStmt *classDeclStmt) {
+    body.u8((uint8_t) NodeTag::CLASS);
+    write(classDeclStmt->identifier);
+    write(classDeclStmt->superclass.has_value() ? classDeclStmt->superclass.value().get() : nullptr);
+    body.varint(classDeclStmt->methods.size());
+    for (const auto &method : classDeclStmt->methods){
+        addNode(method.get());
+        writeFunction(method.get());
+    }
+}
+
+
+Program AstDeserializer::deserialize(binary::Reader &in, std::vector<const void*>* nodes) {
+    this->in = &in;
+    this->nodes = nodes;
+    Program program;
+
+    size_t stringCount = readCount();
+    strings.clear();
+    strings.reserve(stringCount);
+    for (size_t i = 0; i < stringCount; i++){
+        strings.emplace_back(in.string());
+    }
+
+    program.statements = readStmts();
+    return program;
+}
+
+UniqueExprPtr AstDeserializer::readExpr() {
+    auto tag = (NodeTag) in->u8();
+
+    if (tag == NodeTag::NONE){
+        return nullptr;
+    }
+
+    size_t id = reserveNode(); //Children are read (and numbered) before the node itself can be created
+    UniqueExprPtr expr;
+    switch (tag) {
+        case NodeTag::BINARY: {
+            UniqueExprPtr left = readExpr();
+            UniqueExprPtr right = readExpr();
+            expr = std::make_unique<BinaryExpr>(std::move(left), std::move(right), readToken());
+            break;
+        }
+        case NodeTag::GROUPING:
+            expr = std::make_unique<GroupingExpr>(readExpr());
+            break;
+        case NodeTag::UNARY: {
+            Token op = readToken();
+            expr = std::make_unique<UnaryExpr>(op, readExpr());
+            break;
+        }
+        case NodeTag::LITERAL:
+            expr = std::make_unique<LiteralExpr>(readLiteral());
+            break;
+        case NodeTag::VARIABLE: {
+            auto variable = std::make_unique<VariableExpr>(readToken());
+            variable->distance = readDistance();
+            if (!variable->distance) variable->globalSymbol = GlobalEnvironment::symbol(variable->identifier.lexeme);
+            expr = std::move(variable);
+            break;
+        }
+        case NodeTag::ASSIGNMENT: {
+            Token identifier = readToken();
+            std::optional<int> distance = readDistance();
+            auto assignment = std::make_unique<AssignmentExpr>(identifier, readExpr());
+            assignment->distance = distance;
+            if (!distance) assignment->globalSymbol = GlobalEnvironment::symbol(identifier.lexeme);
+            expr = std::move(assignment);
+            break;
+        }
+        case NodeTag::OR: {
+            UniqueExprPtr left = readExpr();
+            expr = std::make_unique<OrExpr>(std::move(left), readExpr());
+            break;
+        }
+        case NodeTag::AND: {
+            UniqueExprPtr left = readExpr();
+            expr = std::make_unique<AndExpr>(std::move(left), readExpr());
+            break;
+        }
+        case NodeTag::CALL: {
+            UniqueExprPtr callee = readExpr();
+            Token closingParen = readToken();
+            expr = std::make_unique<CallExpr>(std::move(callee), closingParen, readExprs());
+            break;
+        }
+        case NodeTag::INCREMENT: {
+            std::unique_ptr<VariableExpr> variable = readVariable();
+            expr = std::make_unique<IncrementExpr>(std::move(variable), (IncrementExpr::Type) in->u8());
+            break;
+        }
+        case NodeTag::DECREMENT: {
+            std::unique_ptr<VariableExpr> variable = readVariable();
+            expr = std::make_unique<DecrementExpr>(std::move(variable), (DecrementExpr::Type) in->u8());
+            break;
+        }
+        case NodeTag::LAMBDA: {
+            std::vector<Token> params = readTokens();
+            expr = std::make_unique<LambdaExpr>(params, readExpr());
+            break;
+        }
+        case NodeTag::GET: {
+            UniqueExprPtr object = readExpr();
+            expr = std::make_unique<GetExpr>(std::move(object), readToken());
+            break;
+        }
+        case NodeTag::SET: {
+            UniqueExprPtr object = readExpr();
+            Token identifier = readToken();
+            expr = std::make_unique<SetExpr>(std::move(object), identifier, readExpr());
+            break;
+        }
+        case NodeTag::THIS: {
+            auto thisExpr = std::make_unique<ThisExpr>(readToken());
+            thisExpr->distance = readDistance();
+            expr = std::move(thisExpr);
+            break;
+        }
+        case NodeTag::SUPER: {
+            Token keyword = readToken();
+            auto superExpr = std::make_unique<SuperExpr>(keyword, readToken());
+            superExpr->distance = readDistance();
+            expr = std::move(superExpr);
+            break;
+        }
+        case NodeTag::LIST: {
+            Token openingBracket = readToken();
+            expr = std::make_unique<ListExpr>(openingBracket, readExprs());
+            break;
+        }
+        default:
+            throw binary::FormatError("Invalid expression tag");
+    }
+
+    setNode(id, expr.get());
+    return expr;
+}
+
+UniqueStmtPtr AstDeserializer::readStmt() {
+    auto tag = (NodeTag) in->u8();
+    if (tag == NodeTag::NONE){
+        return nullptr;
+    }
+
+    size_t id = reserveNode();
+    UniqueStmtPtr stmt = readStmt((uint8_t) tag);
+    setNode(id, stmt.get());
+    return stmt;
+}
+
+UniqueStmtPtr AstDeserializer::readStmt(uint8_t tagByte) {
+    auto tag = (NodeTag) tagByte;
+    switch (tag) {
+        case NodeTag::EXPRESSION_STMT:
+            return std::make_unique<ExpressionStmt>(readExpr());
+        case NodeTag::PRINT:
+            return std::make_unique<PrintStmt>(readOptionalExpr());
+        case NodeTag::VAR_DECLARATION: {
+            Token identifier = readToken();
+            return std::make_unique<VarDeclarationStmt>(identifier, readOptionalExpr());
+        }
+        case NodeTag::BLOCK:
+            return std::make_unique<BlockStmt>(readStmts());
+        case NodeTag::IF: {
+            UniqueExprPtr condition = readExpr();
+            IfBranch mainBranch(std::move(condition), readStmt());
+            size_t elifCount = readCount();
+            std::vector<IfBranch> elifBranches;
+            elifBranches.reserve(elifCount);
+            for (size_t i = 0; i < elifCount; i++){
+                UniqueExprPtr elifCondition = readExpr();
+                elifBranches.emplace_back(std::move(elifCondition), readStmt());
+            }
+            return std::make_unique<IfStmt>(std::move(mainBranch), std::move(elifBranches), readOptionalStmt());
+        }
+        case NodeTag::WHILE: {
+            UniqueExprPtr condition = readExpr();
+            return std::make_unique<WhileStmt>(std::move(condition), readStmt());
+        }
+        case NodeTag::BREAK:
+            return std::make_unique<BreakStmt>(readToken());
+        case NodeTag::CONTINUE:
+            return std::make_unique<ContinueStmt>(readToken());
+        case NodeTag::FOR: {
+            std::optional<UniqueStmtPtr> initializer = readOptionalStmt();
+            std::optional<UniqueExprPtr> condition = readOptionalExpr();
+            std::optional<UniqueStmtPtr> increment = readOptionalStmt();
+            return std::make_unique<ForStmt>(std::move(initializer), std::move(condition), std::move(increment), readStmt());
+        }
+        case NodeTag::FOR_IN: {
+            Token name = readToken();
+            UniqueExprPtr iterable = readExpr();
+            return std::make_unique<ForInStmt>(name, std::move(iterable), readStmt());
+        }
+        case NodeTag::FUNCTION:
+            return readFunction();
+        case NodeTag::RETURN: {
+            Token keyword = readToken();
+            return std::make_unique<ReturnStmt>(keyword, readOptionalExpr());
+        }
+        case NodeTag::CLASS: {
+            Token identifier = readToken();
+            std::optional<std::unique_ptr<VariableExpr>> superclass = std::nullopt;
+            if (std::unique_ptr<VariableExpr> variable = readVariable()){
+                superclass = std::move(variable);
+            }
+            size_t methodCount = readCount();
+            std::vector<std::unique_ptr<FunctionDeclStmt>> methods;
+            methods.reserve(methodCount);
+            for (size_t i = 0; i < methodCount; i++){
+                size_t methodId = reserveNode();
+                methods.push_back(readFunction());
+                setNode(methodId, methods.back().get());
+            }
+            return std::make_unique<ClassDeclStmt>(identifier, std::move(methods), std::move(superclass));
+        }
+        default:
+            throw binary::FormatError("Invalid statement tag");
+    }
+}
+
+std::optional<UniqueExprPtr> AstDeserializer::readOptionalExpr() {
+    UniqueExprPtr expr = readExpr();
+    if (expr == nullptr) return std::nullopt;
+    return expr;
+}
+
+std::optional<UniqueStmtPtr> AstDeserializer::readOptionalStmt() {
+    UniqueStmtPtr stmt = readStmt();
+    if (stmt == nullptr) return std::nullopt;
+    return stmt;
+}
+
+std::vector<UniqueExprPtr> AstDeserializer::readExprs() {
+    size_t count = readCount();
+    std::vector<UniqueExprPtr> exprs;
+    exprs.reserve(count);
+    for (size_t i = 0; i < count; i++){
+        exprs.push_back(readExpr());
+    }
+    return exprs;
+}
+
+std::vector<UniqueStmtPtr> AstDeserializer::readStmts() {
+    size_t count = readCount();
+    std::vector<UniqueStmtPtr> stmts;
+    stmts.reserve(count);
+    for (size_t i = 0; i < count; i++){
+        stmts.push_back(readStmt());
+    }
+    return stmts;
+}
+
+//Reads an expression that must be a VariableExpr (or nullptr)
+std::unique_ptr<VariableExpr> AstDeserializer::readVariable() {
+    UniqueExprPtr expr = readExpr();
+    if (expr == nullptr) return nullptr;
+
+    auto* variable = dynamic_cast<VariableExpr*>(expr.get());
+    if (variable == nullptr){
+        throw binary::FormatError("Expected a variable expression");
+    }
+
+    expr.release();
+    return std::unique_ptr<VariableExpr>(variable);
+}
+
+std::unique_ptr<FunctionDeclStmt> AstDeserializer::readFunction() {
+    Token name = readToken();
+    std::vector<Token> params = readTokens();
+    return std::make_unique<FunctionDeclStmt>(name, params, readStmts());
+}
+
+Token AstDeserializer::readToken() {
+    uint64_t type = in->varint();
+    if (type > TokenType::END_OF_FILE){
+        throw binary::FormatError("Invalid token type");
+    }
+
+    const std::string &lexeme = readString();
+    int line = (int) (uint32_t) in->varint();
+    return Token((TokenType) type, lexeme, line);
+}
+
+std::optional<int> AstDeserializer::readDistance() {
+    uint64_t distance = in->varint();
+    if (distance == 0){
+        return std::nullopt;
+    }
+    return (int) (uint32_t) (distance - 1);
+}
+
+std::vector<Token> AstDeserializer::readTokens() {
+    size_t count = readCount();
+    std::vector<Token> tokens;
+    tokens.reserve(count);
+    for (size_t i = 0; i < count; i++){
+        tokens.push_back(readToken());
+    }
+    return tokens;
+}
+
+LoxObject AstDeserializer::readLiteral() {
+    auto type = (LoxType) in->u8();
+    switch (type) {
+        case LoxType::NIL:
+            return LoxObject::Nil();
+        case LoxType::BOOL:
+            return LoxObject((bool) in->u8());
+        case LoxType::NUMBER:
+            return LoxObject(in->number());
+        case LoxType::STRING:
+            return LoxObject(readString());
+        default:
+            throw binary::FormatError("Invalid literal type");
+    }
+}
+
+const std::string &AstDeserializer::readString() {
+    uint64_t index = in->varint();
+    if (index >= strings.size()){
+        throw binary::FormatError("Invalid string index");
+    }
+    return strings[index];
+}
+
+size_t AstDeserializer::readCount() {
+    uint64_t count = in->varint();
+    if (count > MAX_COUNT){
+        throw binary::FormatError("Invalid count");
+    }
+    return count;
+}
+
+size_t AstDeserializer::reserveNode() {
+    if (nodes == nullptr) return 0;
+    nodes->push_back(nullptr);
+    return nodes->size() - 1;
+}
+
+void AstDeserializer::setNode(size_t id, const void *node) {
+    if (nodes == nullptr) return;
+    (*nodes)[id] = node;
+}
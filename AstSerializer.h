@@ -0,0 +1,111 @@
+#ifndef JLOX_ASTSERIALIZER_H
+#define JLOX_ASTSERIALIZER_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Expr.h"
+#include "LoxObject.h"
+#include "Program.h"
+#include "Stmt.h"
+#include "Token.h"
+#include "tools/BinaryStream.h"
+
+/*Compact binary form of a resolved Program, used by the AstCache. The nodes are written in preorder, each one as a tag followed by
+ * its fields and children. Variables, assignments, this and super carry the distance the Resolver stored in them, so a loaded
+ * program can run without resolving it again. Lexemes are stored once in a string table and referenced by index.
+ * */
+class AstSerializer : public ExprVisitor, public StmtVisitor {
+public:
+    /*If nodeIds is not null every node (Expr or Stmt) gets the next free id, in the order in which it is written. AstDeserializer
+     * numbers the nodes it reads in the same order, which lets other data (e.g. a Snapshot) refer to AST nodes. The ids keep
+     * counting across calls that share the same map.*/
+    void serialize(const Program &program, binary::Writer &out, std::unordered_map<const void*, uint64_t>* nodeIds = nullptr);
+
+    LoxObject visit(const BinaryExpr *binaryExpr) override;
+    LoxObject visit(const GroupingExpr *groupingExpr) override;
+    LoxObject visit(const UnaryExpr *unaryExpr) override;
+    LoxObject visit(const LiteralExpr *literalExpr) override;
+    LoxObject visit(const VariableExpr *variableExpr) override;
+    LoxObject visit(const AssignmentExpr *assignmentExpr) override;
+    LoxObject visit(const OrExpr *orExpr) override;
+    LoxObject visit(const AndExpr *andExpr) override;
+    LoxObject visit(const CallExpr *callExpr) override;
+    LoxObject visit(const IncrementExpr *incrementExpr) override;
+    LoxObject visit(const DecrementExpr *decrementExpr) override;
+    LoxObject visit(const LambdaExpr *lambdaExpr) override;
+    LoxObject visit(const GetExpr *getExpr) override;
+    LoxObject visit(const SetExpr *setExpr) override;
+    LoxObject visit(const ThisExpr *thisExpr) override;
+    LoxObject visit(const SuperExpr *superExpr) override;
+    LoxObject visit(const ListExpr *listExpr) override;
+
+    void visit(const ExpressionStmt *expressionStmt) override;
+    void visit(const PrintStmt *printStmt) override;
+    void visit(const VarDeclarationStmt *varDeclarationStmt) override;
+    void visit(const BlockStmt *blockStmt) override;
+    void visit(const IfStmt *ifStmt) override;
+    void visit(const WhileStmt *whileStmt) override;
+    void visit(const BreakStmt *breakStmt) override;
+    void visit(const ContinueStmt *continueStmt) override;
+    void visit(const ForStmt *forStmt) override;
+    void visit(const ForInStmt *forInStmt) override;
+    void visit(const FunctionDeclStmt *functionStmt) override;
+    void visit(const ReturnStmt *returnStmt) override;
+    void visit(const ClassDeclStmt *classDeclStmt) override;
+
+private:
+    //The nodes are written into body while the string table is being built, serialize() then writes the table followed by body
+    binary::Writer body;
+    std::unordered_map<std::string, uint64_t> stringIndices;
+    std::vector<const std::string*> strings;
+    std::unordered_map<const void*, uint64_t>* nodeIds = nullptr;
+
+    void addNode(const void* node);
+    void write(Expr* expr);
+    void write(Stmt* stmt);
+    void write(const std::optional<UniqueExprPtr> &expr);
+    void write(const std::optional<UniqueStmtPtr> &stmt);
+    void write(const std::vector<UniqueExprPtr> &exprs);
+    void write(const std::vector<UniqueStmtPtr> &stmts);
+    void write(const Token &token);
+    void writeDistance(const std::optional<int> &distance);
+    void write(const std::vector<Token> &tokens);
+    void write(const LoxObject &literal);
+    void write(const std::string &string);
+    void writeFunction(const FunctionDeclStmt *functionStmt);
+};
+
+class AstDeserializer {
+public:
+    //Throws binary::FormatError if the data isn't a program written by AstSerializer. See AstSerializer::serialize for nodes.
+    Program deserialize(binary::Reader &in, std::vector<const void*>* nodes = nullptr);
+
+private:
+    binary::Reader* in = nullptr;
+    std::vector<const void*>* nodes = nullptr;
+    std::vector<std::string> strings;
+
+    UniqueExprPtr readExpr();
+    UniqueStmtPtr readStmt();
+    UniqueStmtPtr readStmt(uint8_t tag);
+    std::optional<UniqueExprPtr> readOptionalExpr();
+    std::optional<UniqueStmtPtr> readOptionalStmt();
+    std::vector<UniqueExprPtr> readExprs();
+    std::vector<UniqueStmtPtr> readStmts();
+    std::unique_ptr<VariableExpr> readVariable();
+    std::unique_ptr<FunctionDeclStmt> readFunction();
+    Token readToken();
+    std::optional<int> readDistance();
+    std::vector<Token> readTokens();
+    LoxObject readLiteral();
+    const std::string& readString();
+    size_t readCount();
+    size_t reserveNode();
+    void setNode(size_t id, const void* node);
+};
+
+
+#endif //JLOX_ASTSERIALIZER_H
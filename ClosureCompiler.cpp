@@ -0,0 +1,591 @@
+#include "ClosureCompiler.h"
+#include <cassert>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "Interpreter.h"
+#include "LoxCallable.h"
+#include "LoxClass.h"
+#include "LoxError.h"
+#include "LoxFunction.h"
+#include "LoxIterator.h"
+#include "LoxList.h"
+#include "Token.h"
+#include "TokenType.h"
+
+namespace {
+    /*Binary and unary operators in LoxObject throw std::runtime_error because LoxObject has no knowledge of the current line.
+     * The operator is picked at compile time and the line is baked into the closure so the error can be rethrown with it.*/
+    template<typename Operator>
+    CompiledExpr binaryClosure(CompiledExpr left, CompiledExpr right, int line, Operator op) {
+        return [left = std::move(left), right = std::move(right), line, op](Interpreter &interpreter) {
+            LoxObject lhs = left(interpreter), rhs = right(interpreter);
+            try {
+                return op(lhs, rhs);
+            } catch (const std::runtime_error &error) {
+                throw LoxRuntimeError(error.what(), line);
+            }
+        };
+    }
+
+    template<typename Operator>
+    CompiledExpr unaryClosure(CompiledExpr expr, int line, Operator op) {
+        return [expr = std::move(expr), line, op](Interpreter &interpreter) {
+            LoxObject value = expr(interpreter);
+            try {
+                return op(value);
+            } catch (const std::runtime_error &error) {
+                throw LoxRuntimeError(error.what(), line);
+            }
+        };
+    }
+}
+
+ClosureCompiler::ClosureCompiler(GlobalEnvironment &globals) : globals(globals) {}
+
+CompiledBlock ClosureCompiler::compile(const std::vector<UniqueStmtPtr> &stmts, bool replMode) {
+    if (replMode){
+        assert(stmts.size() == 1);
+        auto* exprStmt = dynamic_cast<ExpressionStmt*>(stmts[0].get());
+        if (exprStmt){ //If we are dealing with an expression statement such as "1+2" evaluate the expression and output it.
+            CompiledExpr expr = compile(exprStmt->expr.get());
+            CompiledStmt print = [expr = std::move(expr)](Interpreter &interpreter) {
+                LoxObject result = expr(interpreter);
+                if (!result.isNil()){ //don't output anything if the statement had no output
+                    interpreter.print(result);
+                }
+            };
+
+            return {print};
+        }
+    }
+
+    return compileBlock(stmts);
+}
+
+CompiledExpr ClosureCompiler::compile(Expr *expr) {
+    expr->accept(*this);
+    return std::move(compiledExpr);
+}
+
+CompiledStmt ClosureCompiler::compile(Stmt *stmt) {
+    stmt->accept(*this);
+    return std::move(compiledStmt);
+}
+
+CompiledBlock ClosureCompiler::compileBlock(const std::vector<UniqueStmtPtr> &stmts) {
+    CompiledBlock block;
+    block.reserve(stmts.size());
+    for (auto const &stmt : stmts){
+        block.push_back(compile(stmt.get()));
+    }
+
+    return block;
+}
+
+SharedCompiledBlock ClosureCompiler::compileFunctionBody(const FunctionDeclStmt *functionStmt) {
+    return std::make_shared<const CompiledBlock>(compileBlock(functionStmt->body));
+}
+
+SharedCompiledExpr ClosureCompiler::compileLambdaBody(const LambdaExpr *lambdaExpr) {
+    return std::make_shared<const CompiledExpr>(compile(lambdaExpr->body.get()));
+}
+
+CompiledExpr ClosureCompiler::compileLookup(const std::optional<int> &hops, const Token &identifier) {
+    if (hops.has_value()){
+        return [identifier, hops = hops.value()](Interpreter &interpreter) {
+            return interpreter.environment->getAt(identifier, hops);
+        };
+    }
+
+    GlobalEnvironment::Cell* cell = globals.cell(identifier.lexeme);
+    return [identifier, cell](Interpreter &/*interpreter*/) {
+        return GlobalEnvironment::get(cell, identifier);
+    };
+}
+
+ClosureCompiler::CompiledStore ClosureCompiler::compileStore(const std::optional<int> &hops, const Token &identifier) {
+    if (hops.has_value()){
+        return [identifier, hops = hops.value()](Interpreter &interpreter, const LoxObject &value) {
+            interpreter.environment->assignAt(identifier, value, hops);
+        };
+    }
+
+    GlobalEnvironment::Cell* cell = globals.cell(identifier.lexeme);
+    return [identifier, cell](Interpreter &/*interpreter*/, const LoxObject &value) {
+        GlobalEnvironment::assign(cell, identifier, value);
+    };
+}
+
+//STATEMENTS
+
+void ClosureCompiler::visit(const ExpressionStmt *expressionStmt) {
+    CompiledExpr expr = compile(expressionStmt->expr.get());
+    compiledStmt = [expr = std::move(expr)](Interpreter &interpreter) {
+        expr(interpreter);
+    };
+}
+
+void ClosureCompiler::visit(const PrintStmt *printStmt) {
+    if (!printStmt->expr.has_value()){
+        compiledStmt = [](Interpreter &interpreter) {
+            interpreter.printNewline();
+        };
+        return;
+    }
+
+    CompiledExpr expr = compile(printStmt->expr.value().get());
+    compiledStmt = [expr = std::move(expr)](Interpreter &interpreter) {
+        LoxObject result = expr(interpreter);
+        interpreter.print(result);
+    };
+}
+
+void ClosureCompiler::visit(const VarDeclarationStmt *varDeclarationStmt) {
+    Token identifier = varDeclarationStmt->identifier;
+    if (!varDeclarationStmt->expr.has_value()){
+        compiledStmt = [identifier](Interpreter &interpreter) {
+            interpreter.define(identifier, LoxObject::Nil());
+        };
+        return;
+    }
+
+    CompiledExpr initializer = compile(varDeclarationStmt->expr.value().get());
+    compiledStmt = [identifier, initializer = std::move(initializer)](Interpreter &interpreter) {
+        LoxObject value = initializer(interpreter);
+        interpreter.define(identifier, value);
+    };
+}
+
+void ClosureCompiler::visit(const BlockStmt *blockStmt) {
+    CompiledBlock block = compileBlock(blockStmt->statements);
+    compiledStmt = [block = std::move(block)](Interpreter &interpreter) {
+        interpreter.executeBlock(block, std::make_shared<Environment>(interpreter.environment));
+    };
+}
+
+void ClosureCompiler::visit(const IfStmt *ifStmt) {
+    //The main branch is stored as the first elif branch, they are evaluated in the same way.
+    std::vector<std::pair<CompiledExpr, CompiledStmt>> branches;
+    branches.emplace_back(compile(ifStmt->mainBranch.condition.get()), compile(ifStmt->mainBranch.statement.get()));
+    for (const IfBranch &branch : ifStmt->elifBranches){
+        branches.emplace_back(compile(branch.condition.get()), compile(branch.statement.get()));
+    }
+
+    std::optional<CompiledStmt> elseBranch = std::nullopt;
+    if (ifStmt->elseBranch.has_value()){
+        elseBranch = compile(ifStmt->elseBranch.value().get());
+    }
+
+    compiledStmt = [branches = std::move(branches), elseBranch = std::move(elseBranch)](Interpreter &interpreter) {
+        for (const auto &branch : branches){
+            if (branch.first(interpreter).truthy()){
+                branch.second(interpreter);
+                return;
+            }
+        }
+
+        if (elseBranch.has_value()){
+            elseBranch.value()(interpreter);
+        }
+    };
+}
+
+void ClosureCompiler::visit(const WhileStmt *whileStmt) {
+    CompiledExpr condition = compile(whileStmt->condition.get());
+    CompiledStmt body = compile(whileStmt->body.get());
+    compiledStmt = [condition = std::move(condition), body = std::move(body)](Interpreter &interpreter) {
+        while (condition(interpreter).truthy()){
+            try {
+                body(interpreter);
+            //We use special exceptions to unwind the stack when a break/continue statement is encountered.
+            } catch (const BreakException &exception) {
+                return;
+            } catch (const ContinueException &exception) {
+                //empty
+            }
+        }
+    };
+}
+
+void ClosureCompiler::visit(const ForStmt *forStmt) {
+    std::optional<CompiledStmt> initializer = std::nullopt, increment = std::nullopt;
+    std::optional<CompiledExpr> condition = std::nullopt;
+    if (forStmt->initializer.has_value()) initializer = compile(forStmt->initializer.value().get());
+    if (forStmt->condition.has_value()) condition = compile(forStmt->condition.value().get());
+    if (forStmt->increment.has_value()) increment = compile(forStmt->increment.value().get());
+    CompiledStmt body = compile(forStmt->body.get());
+
+    compiledStmt = [initializer = std::move(initializer), condition = std::move(condition), increment = std::move(increment),
+                    body = std::move(body)](Interpreter &interpreter) {
+        Environment::SharedPtr newEnv = std::make_shared<Environment>(interpreter.environment);
+        ScopedEnvironment scoped(interpreter.environment, newEnv);
+
+        if (initializer.has_value()){
+            initializer.value()(interpreter);
+        }
+
+        while (!condition.has_value() || condition.value()(interpreter).truthy()){
+            try {
+                body(interpreter);
+            } catch (const BreakException &exception) {
+                return;
+            } catch (const ContinueException &exception) {
+                //empty
+            }
+
+            if (increment.has_value()){
+                increment.value()(interpreter);
+            }
+        }
+    };
+}
+
+void ClosureCompiler::visit(const ForInStmt *forInStmt) {
+    CompiledExpr iterable = compile(forInStmt->iterable.get());
+    CompiledStmt body = compile(forInStmt->body.get());
+
+    compiledStmt = [forInStmt, iterable = std::move(iterable), body = std::move(body)](Interpreter &interpreter) {
+        LoxObject iterableValue = iterable(interpreter);
+        Environment::SharedPtr newEnv = std::make_shared<Environment>(interpreter.environment);
+        ScopedEnvironment scoped(interpreter.environment, newEnv);
+        LoxObject &variable = newEnv->defineSlot(forInStmt->name);
+
+        LoxIterator::forEach(interpreter, iterableValue, forInStmt->name.line, [&](const LoxObject &item) {
+            variable = item;
+            try {
+                body(interpreter);
+            } catch (const BreakException &exception) {
+                return false;
+            } catch (const ContinueException &exception) {
+                //empty
+            }
+            return true;
+        });
+    };
+}
+
+void ClosureCompiler::visit(const BreakStmt * /*breakStmt*/) {
+    //Break, continue and return use the same exceptions as the tree walker, see Interpreter.cpp
+    compiledStmt = [](Interpreter &/*interpreter*/) {
+        throw BreakException();
+    };
+}
+
+void ClosureCompiler::visit(const ContinueStmt * /*continueStmt*/) {
+    compiledStmt = [](Interpreter &/*interpreter*/) {
+        throw ContinueException();
+    };
+}
+
+void ClosureCompiler::visit(const FunctionDeclStmt *functionStmt) {
+    SharedCompiledBlock body = compileFunctionBody(functionStmt);
+    compiledStmt = [functionStmt, body = std::move(body)](Interpreter &interpreter) {
+        SharedCallablePtr function = std::make_shared<LoxFunction>(functionStmt, interpreter.environment, false, body);
+        interpreter.define(functionStmt->name, LoxObject(function));
+    };
+}
+
+void ClosureCompiler::visit(const ReturnStmt *returnStmt) {
+    if (!returnStmt->expr.has_value()){
+        compiledStmt = [](Interpreter &/*interpreter*/) {
+            throw ReturnException(LoxObject::Nil());
+        };
+        return;
+    }
+
+    CompiledExpr expr = compile(returnStmt->expr.value().get());
+    compiledStmt = [expr = std::move(expr)](Interpreter &interpreter) {
+        throw ReturnException(expr(interpreter));
+    };
+}
+
+void ClosureCompiler::visit(const ClassDeclStmt *classDeclStmt) {
+    std::optional<CompiledExpr> superclassExpr = std::nullopt;
+    if (classDeclStmt->superclass.has_value()){
+        superclassExpr = compile(classDeclStmt->superclass.value().get());
+    }
+
+    std::vector<std::pair<const FunctionDeclStmt*, SharedCompiledBlock>> methodBodies;
+    for (const auto& method : classDeclStmt->methods){
+        methodBodies.emplace_back(method.get(), compileFunctionBody(method.get()));
+    }
+
+    compiledStmt = [classDeclStmt, superclassExpr = std::move(superclassExpr), methodBodies = std::move(methodBodies)](Interpreter &interpreter) {
+        interpreter.define(classDeclStmt->identifier, LoxObject::Nil());
+
+        std::optional<SharedCallablePtr> superclassPtr = std::nullopt;
+        if (superclassExpr.has_value()){
+            LoxObject superclass = superclassExpr.value()(interpreter);
+            interpreter.checkSuperclass(superclass, classDeclStmt);
+            superclassPtr = superclass.getCallable();
+            //create a new environment that binds "super" to the superclass
+            interpreter.environment = std::make_shared<Environment>(interpreter.environment);
+            interpreter.environment->define("super", superclass);
+        }
+
+        std::unordered_map<std::string, std::shared_ptr<LoxFunction>> methods;
+        for (const auto& [method, body] : methodBodies){
+            bool isConstructor = method->name.lexeme == "init";
+            methods[method->name.lexeme] = std::make_shared<LoxFunction>(method, interpreter.environment, isConstructor, body);
+        }
+
+        if (superclassPtr.has_value()){
+            //pop latest environment
+            interpreter.environment = interpreter.environment->parent();
+        }
+
+        SharedCallablePtr klass = std::make_shared<LoxClass>(classDeclStmt->identifier.lexeme, methods, superclassPtr);
+        interpreter.assignInCurrentScope(classDeclStmt->identifier, LoxObject(klass));
+    };
+}
+
+//EXPRESSIONS
+
+LoxObject ClosureCompiler::visit(const BinaryExpr *binaryExpr) {
+    CompiledExpr left = compile(binaryExpr->left.get()), right = compile(binaryExpr->right.get());
+    int line = binaryExpr->op.line;
+    using Lox = const LoxObject&;
+    switch (binaryExpr->op.type){
+        case TokenType::PLUS:
+            compiledExpr = binaryClosure(std::move(left), std::move(right), line, [](Lox lhs, Lox rhs) { return lhs + rhs; });
+            break;
+        case TokenType::MINUS:
+            compiledExpr = binaryClosure(std::move(left), std::move(right), line, [](Lox lhs, Lox rhs) { return lhs - rhs; });
+            break;
+        case TokenType::STAR:
+            compiledExpr = binaryClosure(std::move(left), std::move(right), line, [](Lox lhs, Lox rhs) { return lhs * rhs; });
+            break;
+        case TokenType::SLASH:
+            compiledExpr = binaryClosure(std::move(left), std::move(right), line, [](Lox lhs, Lox rhs) { return lhs / rhs; });
+            break;
+        case TokenType::GREATER:
+            compiledExpr = binaryClosure(std::move(left), std::move(right), line, [](Lox lhs, Lox rhs) { return LoxObject(lhs > rhs); });
+            break;
+        case TokenType::GREATER_EQUAL:
+            compiledExpr = binaryClosure(std::move(left), std::move(right), line, [](Lox lhs, Lox rhs) { return LoxObject(lhs >= rhs); });
+            break;
+        case TokenType::LESS:
+            compiledExpr = binaryClosure(std::move(left), std::move(right), line, [](Lox lhs, Lox rhs) { return LoxObject(lhs < rhs); });
+            break;
+        case TokenType::LESS_EQUAL:
+            compiledExpr = binaryClosure(std::move(left), std::move(right), line, [](Lox lhs, Lox rhs) { return LoxObject(lhs <= rhs); });
+            break;
+        case TokenType::BANG_EQUAL:
+            compiledExpr = binaryClosure(std::move(left), std::move(right), line, [](Lox lhs, Lox rhs) { return LoxObject(lhs != rhs); });
+            break;
+        case TokenType::EQUAL_EQUAL:
+            compiledExpr = binaryClosure(std::move(left), std::move(right), line, [](Lox lhs, Lox rhs) { return LoxObject(lhs == rhs); });
+            break;
+        default:
+            //unreachable but just in case
+            throw std::runtime_error("Invalid binary operand");
+    }
+
+    return LoxObject::Nil();
+}
+
+LoxObject ClosureCompiler::visit(const GroupingExpr *groupingExpr) {
+    //Groupings only matter for the parser, at runtime they are just the inner expression
+    compiledExpr = compile(groupingExpr->expr.get());
+    return LoxObject::Nil();
+}
+
+LoxObject ClosureCompiler::visit(const UnaryExpr *unaryExpr) {
+    CompiledExpr expr = compile(unaryExpr->expr.get());
+    int line = unaryExpr->op.line;
+    switch (unaryExpr->op.type){
+        case TokenType::MINUS:
+            compiledExpr = unaryClosure(std::move(expr), line, [](const LoxObject &value) { return -value; });
+            break;
+        case TokenType::BANG:
+            compiledExpr = unaryClosure(std::move(expr), line, [](const LoxObject &value) { return !value; });
+            break;
+        default:
+            //unreachable
+            throw std::runtime_error("Invalid unary operand");
+    }
+
+    return LoxObject::Nil();
+}
+
+LoxObject ClosureCompiler::visit(const LiteralExpr *literalExpr) {
+    compiledExpr = [literal = literalExpr->literal](Interpreter &/*interpreter*/) {
+        return literal;
+    };
+    return LoxObject::Nil();
+}
+
+LoxObject ClosureCompiler::visit(const VariableExpr *variableExpr) {
+    compiledExpr = compileLookup(variableExpr->distance, variableExpr->identifier);
+    return LoxObject::Nil();
+}
+
+LoxObject ClosureCompiler::visit(const AssignmentExpr *assignmentExpr) {
+    CompiledExpr value = compile(assignmentExpr->value.get());
+    CompiledStore store = compileStore(assignmentExpr->distance, assignmentExpr->identifier);
+    compiledExpr = [value = std::move(value), store = std::move(store)](Interpreter &interpreter) {
+        LoxObject result = value(interpreter);
+        store(interpreter, result);
+        return result;
+    };
+    return LoxObject::Nil();
+}
+
+LoxObject ClosureCompiler::visit(const OrExpr *orExpr) {
+    CompiledExpr left = compile(orExpr->left.get()), right = compile(orExpr->right.get());
+    compiledExpr = [left = std::move(left), right = std::move(right)](Interpreter &interpreter) {
+        if (left(interpreter).truthy()){
+            return LoxObject(true);
+        }
+
+        return LoxObject(right(interpreter).truthy());
+    };
+    return LoxObject::Nil();
+}
+
+LoxObject ClosureCompiler::visit(const AndExpr *andExpr) {
+    CompiledExpr left = compile(andExpr->left.get()), right = compile(andExpr->right.get());
+    compiledExpr = [left = std::move(left), right = std::move(right)](Interpreter &interpreter) {
+        if (!left(interpreter).truthy()){
+            return LoxObject(false);
+        }
+
+        return LoxObject(right(interpreter).truthy());
+    };
+    return LoxObject::Nil();
+}
+
+LoxObject ClosureCompiler::visit(const CallExpr *callExpr) {
+    CompiledExpr callee = compile(callExpr->callee.get());
+    std::vector<CompiledExpr> arguments;
+    arguments.reserve(callExpr->arguments.size());
+    for (const UniqueExprPtr &arg : callExpr->arguments){
+        arguments.push_back(compile(arg.get()));
+    }
+
+    compiledExpr = [callee = std::move(callee), arguments = std::move(arguments), closingParen = callExpr->closingParen](Interpreter &interpreter) {
+        LoxObject function = callee(interpreter);
+        ArgumentStack::Frame frame(interpreter.argumentStack, arguments.size());
+        for (size_t i = 0; i < arguments.size(); i++){
+            frame.arguments[i] = arguments[i](interpreter);
+        }
+
+        return interpreter.call(function, frame.arguments, closingParen);
+    };
+    return LoxObject::Nil();
+}
+
+LoxObject ClosureCompiler::visit(const IncrementExpr *incrementExpr) {
+    const VariableExpr *variableExpr = incrementExpr->variable.get();
+    CompiledExpr lookup = compileLookup(variableExpr->distance, variableExpr->identifier);
+    CompiledStore store = compileStore(variableExpr->distance, variableExpr->identifier);
+    bool postfix = incrementExpr->type == IncrementExpr::Type::POSTFIX;
+
+    compiledExpr = [lookup = std::move(lookup), store = std::move(store), postfix](Interpreter &interpreter) {
+        LoxObject prev = lookup(interpreter);
+        LoxObject inc = prev + LoxObject(1.0);
+        store(interpreter, inc);
+        return postfix ? prev : inc;
+    };
+    return LoxObject::Nil();
+}
+
+LoxObject ClosureCompiler::visit(const DecrementExpr *decrementExpr) {
+    const VariableExpr *variableExpr = decrementExpr->variable.get();
+    CompiledExpr lookup = compileLookup(variableExpr->distance, variableExpr->identifier);
+    CompiledStore store = compileStore(variableExpr->distance, variableExpr->identifier);
+    bool postfix = decrementExpr->type == DecrementExpr::Type::POSTFIX;
+
+    compiledExpr = [lookup = std::move(lookup), store = std::move(store), postfix](Interpreter &interpreter) {
+        LoxObject prev = lookup(interpreter);
+        LoxObject dec = prev - LoxObject(1.0);
+        store(interpreter, dec);
+        return postfix ? prev : dec;
+    };
+    return LoxObject::Nil();
+}
+
+LoxObject ClosureCompiler::visit(const LambdaExpr *lambdaExpr) {
+    SharedCompiledExpr body = compileLambdaBody(lambdaExpr);
+    compiledExpr = [lambdaExpr, body = std::move(body)](Interpreter &interpreter) {
+        SharedCallablePtr function = std::make_shared<LoxLambdaWrapper>(lambdaExpr, interpreter.environment, body);
+        return LoxObject(function);
+    };
+    return LoxObject::Nil();
+}
+
+LoxObject ClosureCompiler::visit(const GetExpr *getExpr) {
+    CompiledExpr object = compile(getExpr->expr.get());
+    compiledExpr = [object = std::move(object), identifier = getExpr->identifier](Interpreter &interpreter) {
+        LoxObject obj = object(interpreter);
+        if (!obj.isClassInstance()){
+            throw LoxRuntimeError("Only instances have properties", identifier.line);
+        }
+
+        return obj.getClassInstance()->getProperty(identifier);
+    };
+    return LoxObject::Nil();
+}
+
+LoxObject ClosureCompiler::visit(const SetExpr *setExpr) {
+    CompiledExpr object = compile(setExpr->object.get()), value = compile(setExpr->value.get());
+    compiledExpr = [object = std::move(object), value = std::move(value), identifier = setExpr->identifier](Interpreter &interpreter) {
+        LoxObject obj = object(interpreter);
+        if (!obj.isClassInstance()){
+            throw LoxRuntimeError("Cannot access a field on something that isn't an object instance", identifier.line);
+        }
+
+        LoxObject result = value(interpreter);
+        obj.getClassInstance()->setProperty(identifier, result);
+        return result;
+    };
+    return LoxObject::Nil();
+}
+
+LoxObject ClosureCompiler::visit(const ThisExpr *thisExpr) {
+    compiledExpr = compileLookup(thisExpr->distance, thisExpr->keyword);
+    return LoxObject::Nil();
+}
+
+LoxObject ClosureCompiler::visit(const SuperExpr *superExpr) {
+    std::optional<int> hops = superExpr->distance;
+    assert(hops.has_value()); //The resolver always resolves super, it can only be used inside of a subclass
+
+    compiledExpr = [superExpr, hops = hops.value()](Interpreter &interpreter) {
+        LoxObject superclassObj = interpreter.environment->getAt("super", hops);
+        assert(superclassObj.getCallable()->type == LoxCallable::CallableType::CLASS); //checked when the class was declared
+        LoxClass* superclass = static_cast<LoxClass*>(superclassObj.getCallable().get());
+
+        LoxFunction* method = superclass->findMethod(superExpr->identifier.lexeme);
+        if (!method){
+            throw LoxRuntimeError("Undefined property " + superExpr->identifier.lexeme, superExpr->keyword.line);
+        }
+
+        LoxObject instanceObj = interpreter.environment->getAt("this", hops - 1); // "this" is always one level nearer than "super"'s environment.
+        SharedCallablePtr bindedMethod = method->bindThis(instanceObj.getClassInstance());
+        return LoxObject(bindedMethod);
+    };
+    return LoxObject::Nil();
+}
+
+LoxObject ClosureCompiler::visit(const ListExpr *listExpr) {
+    std::vector<CompiledExpr> items;
+    items.reserve(listExpr->items.size());
+    for (const auto& item : listExpr->items){
+        items.push_back(compile(item.get()));
+    }
+
+    compiledExpr = [listExpr, items = std::move(items)](Interpreter &interpreter) {
+        std::vector<LoxObject> values;
+        values.reserve(items.size());
+        for (const CompiledExpr &item : items){
+            values.push_back(item(interpreter));
+        }
+
+        SharedListPtr list = std::make_shared<LoxList>(listExpr, values);
+        return LoxObject(list);
+    };
+    return LoxObject::Nil();
+}
@@ -0,0 +1,83 @@
+#ifndef JLOX_CLOSURECOMPILER_H
+#define JLOX_CLOSURECOMPILER_H
+
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include "Environment.h"
+#include "Expr.h"
+#include "LoxObject.h"
+#include "Stmt.h"
+#include "typedefs.h"
+
+/*Alternative backend to the tree walking interpreter. Instead of walking the AST with accept()/visit() every time a node
+ * is executed (two virtual calls plus a lookup in the distances table for every variable), the compiler walks the resolved AST once
+ * and turns every node into a native closure. Everything that can be known before running the code (resolved distances, which operator
+ * to apply, literal values, lines for error reporting) is baked into the closure, so executing a node is a single indirect call.
+ *
+ * The compiled code runs on top of the same Interpreter state (environments, LoxObject, LoxFunction, LoxClass) as the tree walker, so
+ * both backends have the same semantics. Like the Resolver, the visitor methods only return dummy values, the result of compiling a
+ * node is stored in compiledExpr/compiledStmt.
+ * */
+class ClosureCompiler : public ExprVisitor, public StmtVisitor {
+public:
+    /*References to global variables are bound to their cell in globals at compile time, so the compiled code can only be run
+     * by the interpreter that owns globals.*/
+    explicit ClosureCompiler(GlobalEnvironment &globals);
+
+    //In repl mode an expression statement prints its value, see Interpreter::interpretReplMode
+    CompiledBlock compile(const std::vector<UniqueStmtPtr> &stmts, bool replMode = false);
+    //Bodies of functions and lambdas that were created without the compiler (e.g. loaded from a Snapshot)
+    SharedCompiledBlock compileFunctionBody(const FunctionDeclStmt *functionStmt);
+    SharedCompiledExpr compileLambdaBody(const LambdaExpr *lambdaExpr);
+
+    LoxObject visit(const BinaryExpr *binaryExpr) override;
+    LoxObject visit(const GroupingExpr *groupingExpr) override;
+    LoxObject visit(const UnaryExpr *unaryExpr) override;
+    LoxObject visit(const LiteralExpr *literalExpr) override;
+    LoxObject visit(const VariableExpr *variableExpr) override;
+    LoxObject visit(const AssignmentExpr *assignmentExpr) override;
+    LoxObject visit(const OrExpr *orExpr) override;
+    LoxObject visit(const AndExpr *andExpr) override;
+    LoxObject visit(const CallExpr *callExpr) override;
+    LoxObject visit(const IncrementExpr *incrementExpr) override;
+    LoxObject visit(const DecrementExpr *decrementExpr) override;
+    LoxObject visit(const LambdaExpr *lambdaExpr) override;
+    LoxObject visit(const GetExpr *getExpr) override;
+    LoxObject visit(const SetExpr *setExpr) override;
+    LoxObject visit(const ThisExpr *thisExpr) override;
+    LoxObject visit(const SuperExpr *superExpr) override;
+    LoxObject visit(const ListExpr *listExpr) override;
+
+    void visit(const ExpressionStmt *expressionStmt) override;
+    void visit(const PrintStmt *printStmt) override;
+    void visit(const VarDeclarationStmt *varDeclarationStmt) override;
+    void visit(const BlockStmt *blockStmt) override;
+    void visit(const IfStmt *ifStmt) override;
+    void visit(const WhileStmt *whileStmt) override;
+    void visit(const BreakStmt *breakStmt) override;
+    void visit(const ContinueStmt *continueStmt) override;
+    void visit(const ForStmt *forStmt) override;
+    void visit(const ForInStmt *forInStmt) override;
+    void visit(const FunctionDeclStmt *functionStmt) override;
+    void visit(const ReturnStmt *returnStmt) override;
+    void visit(const ClassDeclStmt *classDeclStmt) override;
+
+private:
+    //Writes a value into a resolved variable
+    using CompiledStore = std::function<void(Interpreter&, const LoxObject&)>;
+
+    GlobalEnvironment &globals;
+    //Result of the last visit() call
+    CompiledExpr compiledExpr;
+    CompiledStmt compiledStmt;
+
+    CompiledExpr compile(Expr* expr);
+    CompiledStmt compile(Stmt* stmt);
+    CompiledBlock compileBlock(const std::vector<UniqueStmtPtr> &stmts);
+    CompiledExpr compileLookup(const std::optional<int> &hops, const Token &identifier);
+    CompiledStore compileStore(const std::optional<int> &hops, const Token &identifier);
+};
+
+
+#endif //JLOX_CLOSURECOMPILER_H
@@ -1,5 +1,6 @@
 #include "Environment.h"
 #include <cassert>
+#include <mutex>
 #include <stdexcept>
 #include <utility>
 #include "LoxError.h"
@@ -7,12 +8,19 @@
 #include "Token.h"
 
 
+namespace {
+    [[noreturn]] void throwFrozen(const std::string &key, int line) {
+        throw LoxRuntimeError("Cannot assign variable '" + key + "' inside a task, tasks can only modify their own variables", line);
+    }
+}
+
 Environment::Environment(Environment::SharedPtr parent) : parentEnv(std::move(parent)) {}
 
 LoxObject Environment::get(const Token &identifier) {
-    std::string key = identifier.lexeme;
-    if (variables.count(key) == 1){
-        return variables[key];
+    const std::string &key = identifier.lexeme;
+    auto it = variables.find(key);
+    if (it != variables.end()){
+        return it->second;
     }
 
     if (parentEnv == nullptr){ //This is the outermost environment
@@ -28,34 +36,49 @@ LoxObject Environment::getAt(const Token &identifier, int distance) {
 
 LoxObject Environment::getAt(const std::string &key, int distance) {
     Environment* env = ancestor(distance);
-    if (env->variables.count(key) == 0){
+    auto it = env->variables.find(key);
+    if (it == env->variables.end()){
         throw std::runtime_error("Variable does not exist. Bug in resolver, this should not be happening");
     }
 
-    return env->variables[key];
+    return it->second;
 }
 
 void Environment::define(const Token &identifier, const LoxObject &val) {
-    std::string key = identifier.lexeme;
-    if (variables.count(key) == 1){
+    const std::string &key = identifier.lexeme;
+    if (!variables.try_emplace(key, val).second){
+        throw LoxRuntimeError("Cannot redefine a variable. Variable '" + key + "' has already been defined", identifier.line);
+    }
+}
+
+void Environment::define(const Token &identifier, LoxObject &&val) {
+    const std::string &key = identifier.lexeme;
+    if (!variables.try_emplace(key, std::move(val)).second){
         throw LoxRuntimeError("Cannot redefine a variable. Variable '" + key + "' has already been defined", identifier.line);
     }
+}
 
-    variables[key] = val;
+LoxObject& Environment::defineSlot(const Token &identifier) {
+    const std::string &key = identifier.lexeme;
+    auto [it, inserted] = variables.try_emplace(key);
+    if (!inserted){
+        throw LoxRuntimeError("Cannot redefine a variable. Variable '" + key + "' has already been defined", identifier.line);
+    }
+    return it->second;
 }
 
 void Environment::define(const std::string &key, const LoxObject &val) {
-    if (variables.count(key) == 1){
+    if (!variables.try_emplace(key, val).second){
         throw LoxRuntimeError("Cannot redefine a variable. Variable '" + key + "' has already been defined");
     }
-
-    variables[key] = val;
 }
 
 void Environment::assign(const Token &identifier, const LoxObject &val) {
-    std::string key = identifier.lexeme;
-    if (variables.count(key) == 1){
-        variables[key] = val;
+    const std::string &key = identifier.lexeme;
+    auto it = variables.find(key);
+    if (it != variables.end()){
+        if (frozen) throwFrozen(key, identifier.line);
+        it->second = val;
         return;
     }
 
@@ -68,18 +91,29 @@ void Environment::assign(const Token &identifier, const LoxObject &val) {
 
 void Environment::assignAt(const Token &identifier, const LoxObject &val, int distance) {
     Environment* env = ancestor(distance);
-    std::string key = identifier.lexeme;
-    if (env->variables.count(key) == 0){
+    auto it = env->variables.find(identifier.lexeme);
+    if (it == env->variables.end()){
         throw std::runtime_error("Undefined variable when assigning. Bug in the Resolver, this should not be happening");
     }
+    if (env->frozen){
+        throwFrozen(identifier.lexeme, identifier.line);
+    }
 
-    env->variables[key] = val;
+    it->second = val;
 }
 
 Environment::SharedPtr Environment::parent() {
     return parentEnv;
 }
 
+const std::unordered_map<std::string, LoxObject> &Environment::getVariables() const {
+    return variables;
+}
+
+void Environment::freeze() {
+    frozen = true;
+}
+
 Environment* Environment::ancestor(int distance) {
     Environment* currentEnv = this;
     for (int i = 0; i < distance; i++){
@@ -91,6 +125,79 @@ Environment* Environment::ancestor(int distance) {
 }
 
 
+GlobalEnvironment::Cell* GlobalEnvironment::cell(const std::string &key) {
+    auto it = indices.find(key);
+    if (it != indices.end()){
+        return &cells[it->second];
+    }
+
+    indices.emplace(key, cells.size());
+    Cell &newCell = cells.emplace_back();
+    newCell.name = key;
+    return &newCell;
+}
+
+size_t GlobalEnvironment::symbol(const std::string &name) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, size_t> symbols;
+    std::lock_guard lock(mutex);
+    return symbols.emplace(name, symbols.size()).first->second;
+}
+
+GlobalEnvironment::Cell* GlobalEnvironment::bindSymbol(size_t symbol, const std::string &name) {
+    if (symbol >= symbolCells.size()){
+        symbolCells.resize(symbol + 1, nullptr);
+    }
+    return symbolCells[symbol] = cell(name);
+}
+
+const GlobalEnvironment::Cell* GlobalEnvironment::find(const std::string &key) const {
+    auto it = indices.find(key);
+    return it == indices.end() ? nullptr : &cells[it->second];
+}
+
+void GlobalEnvironment::define(const Token &identifier, const LoxObject &val) {
+    define(cell(identifier.lexeme), val, identifier.line);
+}
+
+void GlobalEnvironment::define(const std::string &key, const LoxObject &val) {
+    define(cell(key), val, -1);
+}
+
+void GlobalEnvironment::define(Cell *cell, const LoxObject &val, int line) {
+    if (cell->defined){
+        throw LoxRuntimeError("Cannot redefine a variable. Variable '" + cell->name + "' has already been defined", line);
+    }
+
+    cell->value = val;
+    cell->defined = true;
+}
+
+const LoxObject &GlobalEnvironment::get(const Cell *cell, const Token &identifier) {
+    if (!cell->defined){
+        throw LoxRuntimeError("Undefined variable '" + cell->name + "'", identifier.line);
+    }
+
+    return cell->value;
+}
+
+void GlobalEnvironment::assign(Cell *cell, const Token &identifier, const LoxObject &val) {
+    if (!cell->defined){
+        throw LoxRuntimeError("Undefined variable '" + cell->name + "'", identifier.line);
+    }
+    if (cell->readOnly){
+        throwFrozen(cell->name, identifier.line);
+    }
+
+    cell->value = val;
+}
+
+
+const std::deque<GlobalEnvironment::Cell> &GlobalEnvironment::getCells() const {
+    return cells;
+}
+
+
 ScopedEnvironment::ScopedEnvironment(Environment::SharedPtr &currentEnv, Environment::SharedPtr newEnv) : mainReference(currentEnv), copyOfPreviousEnv(currentEnv) {
     mainReference = std::move(newEnv);
 }
@@ -2,9 +2,12 @@
 #define JLOX_ENVIRONMENT_H
 
 
+#include <cstddef>
+#include <deque>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "LoxObject.h"
 
 struct Token;
@@ -17,7 +20,10 @@ public:
 
     //Use the Token overload because it can then report errors using the token's line. Only use the string overload when there's no token.
     void define(const Token &identifier, const LoxObject &val);
+    void define(const Token &identifier, LoxObject &&val);
     void define(const std::string &key, const LoxObject &val);
+    //Defines the variable and returns where its value is stored, for statements that overwrite it on every iteration (see ForInStmt)
+    LoxObject& defineSlot(const Token &identifier);
 
     LoxObject get(const Token &identifier);
 
@@ -29,14 +35,71 @@ public:
     void assignAt(const Token &identifier, const LoxObject &val, int distance);
 
     Environment::SharedPtr parent();
+    const std::unordered_map<std::string, LoxObject>& getVariables() const;
+    //Assigning a variable of a frozen environment throws. Used for the scopes captured by a task, see TaskPool.h
+    void freeze();
 
 private:
     Environment::SharedPtr parentEnv;
     std::unordered_map<std::string, LoxObject> variables;
+    bool frozen = false;
 
     Environment* ancestor(int distance);
 };
 
+/*Variables declared in the outermost scope (and the builtin functions) are never resolved by the Resolver, so every access to them
+ * used to hash the variable name. Instead they are stored in an indexed table of cells. The Resolver gives every global reference
+ * site the symbol of its name, a small integer shared by all the interpreters, and the tree walker finds the cell by indexing the
+ * table of symbols with it (the name is only hashed the first time a symbol is used). The ClosureCompiler looks the cell up once,
+ * when it compiles the site.
+ * A reference to a global that has not been defined yet (e.g. a function that uses a global declared after it) creates an undefined cell,
+ * accessing it throws "Undefined variable" until the global is defined.
+ * */
+class GlobalEnvironment {
+public:
+    struct Cell {
+        std::string name;
+        LoxObject value;
+        bool defined = false;
+        //Assigning it throws, see TaskPool.h
+        bool readOnly = false;
+    };
+
+    /*Symbol of a global name, the same in every interpreter. The table of symbols is the only state shared by all interpreters: it
+     * only grows and is locked, it is only used when programs are resolved or loaded*/
+    static size_t symbol(const std::string &name);
+
+    //Cells are never removed and std::deque never moves its elements when growing at the end, so the returned pointer is valid
+    //for the lifetime of the table.
+    Cell* cell(const std::string &key);
+    //Same as cell(name), symbol must be symbol(name)
+    Cell* cell(size_t symbol, const std::string &name) {
+        if (symbol < symbolCells.size() && symbolCells[symbol] != nullptr) return symbolCells[symbol];
+        return bindSymbol(symbol, name);
+    }
+    //Same as cell without creating it, nullptr if no reference site or definition created it
+    const Cell* find(const std::string &key) const;
+
+    //Use the Token overload because it can then report errors using the token's line. Only use the string overload when there's no token.
+    void define(const Token &identifier, const LoxObject &val);
+    void define(const std::string &key, const LoxObject &val);
+
+    static const LoxObject& get(const Cell* cell, const Token &identifier);
+    static void assign(Cell* cell, const Token &identifier, const LoxObject &val);
+
+    //Every cell in the order in which it was created, including the undefined ones
+    const std::deque<Cell>& getCells() const;
+
+private:
+    std::unordered_map<std::string, size_t> indices;
+    std::deque<Cell> cells;
+    //Cell of every symbol used so far, indexed by symbol
+    std::vector<Cell*> symbolCells;
+
+    Cell* bindSymbol(size_t symbol, const std::string &name);
+    void define(Cell* cell, const LoxObject &val, int line);
+};
+
 //This class uses a little bit of magic with references to set the environment of the caller to
 //a new environment and then restore it to the previous environment when it goes out of scope.
 class ScopedEnvironment {
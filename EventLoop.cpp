@@ -0,0 +1,160 @@
+#include "EventLoop.h"
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include "FileReader.h"
+#include "Interpreter.h"
+#include "LoxError.h"
+#include "Token.h"
+
+namespace {
+    //Both fds are only used to wake epoll_wait up, what they count doesn't matter
+    void drain(int fd) {
+        uint64_t count;
+        while (::read(fd, &count, sizeof(count)) < 0 && errno == EINTR) {}
+    }
+}
+
+
+EventLoop::EventLoop() {
+    epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    timerFd = ::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    wakeFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (epollFd < 0 || timerFd < 0 || wakeFd < 0){
+        std::string reason = std::strerror(errno);
+        for (int fd : {epollFd, timerFd, wakeFd}){
+            if (fd >= 0) ::close(fd);
+        }
+        throw LoxRuntimeError("Could not create the event loop: " + reason);
+    }
+
+    for (int fd : {timerFd, wakeFd}){
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+EventLoop::~EventLoop() {
+    //The reads that weren't waited for (the program failed) still have to finish before their FileRead goes away
+    for (const std::unique_ptr<FileRead> &read : reads){
+        read->thread.join();
+    }
+    for (int fd : {epollFd, timerFd, wakeFd}){
+        if (fd >= 0) ::close(fd);
+    }
+}
+
+EventLoop& EventLoop::of(Interpreter &interpreter) {
+    if (!interpreter.eventLoop){
+        interpreter.eventLoop = std::make_shared<EventLoop>();
+    }
+    return *interpreter.eventLoop;
+}
+
+void EventLoop::run(Interpreter &interpreter) {
+    //Callbacks can't destroy the loop, but keep it alive anyway while it runs
+    if (std::shared_ptr<EventLoop> eventLoop = interpreter.eventLoop){
+        eventLoop->loop(interpreter);
+    }
+}
+
+double EventLoop::setTimeout(const SharedCallablePtr &callback, double milliseconds) {
+    auto delay = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(std::max(milliseconds, 0.0)));
+    uint64_t id = nextTimerId++;
+    Clock::time_point deadline = Clock::now() + delay;
+    timers.emplace(TimerKey(deadline, id), callback);
+    deadlines.emplace(id, deadline);
+    return (double) id;
+}
+
+void EventLoop::clearTimeout(double id) {
+    auto it = deadlines.find((uint64_t) id);
+    if (it == deadlines.end()) return;
+
+    timers.erase(TimerKey(it->second, it->first));
+    deadlines.erase(it);
+}
+
+void EventLoop::readFile(const std::string &path, const SharedCallablePtr &callback) {
+    auto read = std::make_unique<FileRead>();
+    read->callback = callback;
+    FileRead* pending = read.get();
+    int fd = wakeFd;
+    read->thread = std::thread([pending, path, fd]() {
+        try {
+            FileReader reader(path);
+            pending->contents = reader.readAll();
+        } catch (const LoxError &exception) {
+            pending->error = exception.what();
+        }
+        pending->done.store(true);
+        uint64_t one = 1;
+        while (::write(fd, &one, sizeof(one)) < 0 && errno == EINTR) {}
+    });
+    reads.push_back(std::move(read));
+}
+
+void EventLoop::loop(Interpreter &interpreter) {
+    Token token(TokenType::IDENTIFIER, "event loop", -1);
+    epoll_event events[2];
+
+    while (!timers.empty() || !reads.empty()){
+        //One callback at a time, each of them can set or clear timers
+        if (!timers.empty() && timers.begin()->first.first <= Clock::now()){
+            auto first = timers.begin();
+            SharedCallablePtr callback = std::move(first->second);
+            deadlines.erase(first->first.second);
+            timers.erase(first);
+            interpreter.call(LoxObject(callback), {}, token);
+            continue;
+        }
+
+        armTimer();
+        int ready = ::epoll_wait(epollFd, events, 2, -1);
+        if (ready < 0 && errno != EINTR){
+            throw LoxRuntimeError(std::string("Event loop failed: ") + std::strerror(errno));
+        }
+        for (int i = 0; i < ready; i++){
+            drain(events[i].data.fd);
+            if (events[i].data.fd == wakeFd){
+                finishReads(interpreter);
+            }
+        }
+    }
+}
+
+//Absolute deadline of the earliest timer, or disarmed if there are no timers
+void EventLoop::armTimer() {
+    itimerspec spec{};
+    if (!timers.empty()){
+        auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(timers.begin()->first.first.time_since_epoch()).count();
+        spec.it_value.tv_sec = nanoseconds / 1000000000;
+        spec.it_value.tv_nsec = nanoseconds % 1000000000;
+        //A zero it_value would disarm it
+        if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) spec.it_value.tv_nsec = 1;
+    }
+    ::timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+//In the order the reads were started, not in the order they finished, so the callbacks run in a predictable order
+void EventLoop::finishReads(Interpreter &interpreter) {
+    Token token(TokenType::IDENTIFIER, "read_file", -1);
+    while (!reads.empty() && reads.front()->done.load()){
+        std::unique_ptr<FileRead> read = std::move(reads.front());
+        reads.erase(reads.begin());
+        read->thread.join();
+
+        std::vector<LoxObject> arguments(2);
+        if (read->contents.has_value()){
+            arguments[0] = LoxObject(std::move(read->contents.value()));
+        } else {
+            arguments[1] = LoxObject(read->error);
+        }
+        interpreter.call(LoxObject(read->callback), arguments, token);
+    }
+}
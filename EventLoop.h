@@ -0,0 +1,72 @@
+#ifndef JLOX_EVENTLOOP_H
+#define JLOX_EVENTLOOP_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "LoxObject.h"
+
+class Interpreter;
+
+/*Callbacks that run once the script is done, so a script can wait for many things at the same time on a single thread instead of
+ * blocking on each one (sleep() blocks the whole interpreter).
+ *   set_timeout(callback, ms) calls callback() after ms milliseconds and returns an id for clear_timeout(id).
+ *   read_file(path, callback) reads the file in the background and calls callback(contents, nil), or callback(nil, error).
+ * The loop waits on an epoll instance with a timerfd armed for the earliest timer and an eventfd the file reads signal when they
+ * finish, so waiting costs no CPU and the latency is bounded by the earliest timer. Timers with the same deadline run in the order in
+ * which they were set. Callbacks run on the thread of the interpreter, one at a time, and can set more timers.
+ *
+ * The loop of an interpreter is created by the first set_timeout or read_file call. The Runner (and an isolate, when its function
+ * returns) runs it after the program until nothing is pending. A runtime error in a callback stops the loop like any other error.
+ * */
+class EventLoop {
+public:
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    //Loop of interpreter, created if needed
+    static EventLoop& of(Interpreter &interpreter);
+    //Runs the loop of interpreter (if it has one) until there are no timers or reads left
+    static void run(Interpreter &interpreter);
+
+    double setTimeout(const SharedCallablePtr &callback, double milliseconds);
+    void clearTimeout(double id);
+    void readFile(const std::string &path, const SharedCallablePtr &callback);
+
+private:
+    using Clock = std::chrono::steady_clock;
+    //Ordered by deadline, then by id so timers with the same deadline keep their order
+    using TimerKey = std::pair<Clock::time_point, uint64_t>;
+
+    struct FileRead {
+        SharedCallablePtr callback;
+        //Written by thread before it sets done
+        std::optional<std::string> contents;
+        std::string error;
+        std::atomic<bool> done{false};
+        std::thread thread;
+    };
+
+    int epollFd = -1, timerFd = -1, wakeFd = -1;
+    std::map<TimerKey, SharedCallablePtr> timers;
+    std::unordered_map<uint64_t, Clock::time_point> deadlines;
+    uint64_t nextTimerId = 1;
+    std::vector<std::unique_ptr<FileRead>> reads;
+
+    void loop(Interpreter &interpreter);
+    void armTimer();
+    void finishReads(Interpreter &interpreter);
+};
+
+
+#endif //JLOX_EVENTLOOP_H
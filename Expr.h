@@ -1,7 +1,9 @@
 #ifndef JLOX_EXPR_H
 #define JLOX_EXPR_H
 
+#include <cstddef>
 #include <memory>
+#include <optional>
 #include <vector>
 #include "Token.h"
 #include "LoxObject.h"
@@ -47,6 +49,13 @@ public:
 };
 
 
+/*Nodes that refer to a variable (VariableExpr, AssignmentExpr, ThisExpr, SuperExpr) store where it is declared in "distance":
+ * the number of "hops" between the scope where the variable is used and the scope where it is declared, or nothing if it is a global.
+ * It is filled in by the Resolver (or the AstDeserializer) while the Program is being built, the only time they have non-const access
+ * to it, and never changes afterwards, so a resolved program is immutable and can be run by many interpreters at the same time, see
+ * Program.h. A VariableExpr or AssignmentExpr that refers to a global also stores the symbol of its name (see
+ * GlobalEnvironment::symbol), which indexes the cell of the global in every interpreter.
+ * */
 class Expr {
 public:
     virtual ~Expr() = default;
@@ -92,6 +101,8 @@ public:
 class VariableExpr : public Expr {
 public:
     Token identifier;
+    std::optional<int> distance;
+    size_t globalSymbol = 0;
 
     explicit VariableExpr(const Token &identifier);
     LoxObject accept(ExprVisitor& visitor) override;
@@ -102,6 +113,8 @@ class AssignmentExpr : public Expr {
 public:
     Token identifier;
     UniqueExprPtr value;
+    std::optional<int> distance;
+    size_t globalSymbol = 0;
 
     AssignmentExpr(const Token &identifier, UniqueExprPtr value);
     LoxObject accept(ExprVisitor &visitor) override;
@@ -200,6 +213,7 @@ public:
 class ThisExpr : public Expr {
 public:
     Token keyword;
+    std::optional<int> distance;
 
     explicit ThisExpr(const Token &keyword);
     LoxObject accept(ExprVisitor &visitor) override;
@@ -208,6 +222,7 @@ public:
 class SuperExpr : public Expr {
 public:
     Token keyword, identifier;
+    std::optional<int> distance;
 
     explicit SuperExpr(const Token &keyword, const Token &identifier);
     LoxObject accept(ExprVisitor &visitor) override;
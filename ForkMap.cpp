@@ -0,0 +1,226 @@
+#include "ForkMap.h"
+#include <algorithm>
+#include <cerrno>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "Interpreter.h"
+#include "LoxError.h"
+#include "LoxList.h"
+#include "TaskPool.h"
+#include "Token.h"
+#include "tools/BinaryStream.h"
+
+namespace {
+    //Every item a child maps is written as: status, output of the call, then the result or the error message
+    enum class Status : uint8_t { RESULT, ERROR };
+    enum class ValueTag : uint8_t { NIL, FALSE, TRUE, NUMBER, STRING, LIST };
+
+    struct Child {
+        int pid = -1;
+        int pipe = -1;
+        std::string data;
+        bool finished = false;
+        int killedBy = 0;
+    };
+
+    void writeValue(const LoxObject &value, binary::Writer &out) {
+        if (value.isNil()){
+            out.u8(static_cast<uint8_t>(ValueTag::NIL));
+        } else if (value.isBoolean()){
+            out.u8(static_cast<uint8_t>(value.getBoolean() ? ValueTag::TRUE : ValueTag::FALSE));
+        } else if (value.isNumber()){
+            out.u8(static_cast<uint8_t>(ValueTag::NUMBER));
+            out.number(value.getNumber());
+        } else if (value.isString()){
+            out.u8(static_cast<uint8_t>(ValueTag::STRING));
+            out.string(value.getString());
+        } else if (value.isList()){
+            const std::vector<LoxObject> &items = value.getList()->getItems();
+            out.u8(static_cast<uint8_t>(ValueTag::LIST));
+            out.varint(items.size());
+            for (const LoxObject &item : items){
+                writeValue(item, out);
+            }
+        } else {
+            throw LoxRuntimeError("fork_map results can only be nil, booleans, numbers, strings and lists of them");
+        }
+    }
+
+    LoxObject readValue(binary::Reader &in) {
+        switch (static_cast<ValueTag>(in.u8())){
+            case ValueTag::NIL: return LoxObject();
+            case ValueTag::FALSE: return LoxObject(false);
+            case ValueTag::TRUE: return LoxObject(true);
+            case ValueTag::NUMBER: return LoxObject(in.number());
+            case ValueTag::STRING: return LoxObject(std::string(in.string()));
+            case ValueTag::LIST: {
+                std::vector<LoxObject> items(in.varint());
+                for (LoxObject &item : items){
+                    item = readValue(in);
+                }
+                return LoxObject(std::make_shared<LoxList>(nullptr, items));
+            }
+        }
+        throw binary::FormatError("unknown value tag");
+    }
+
+    //Runs in the child, never returns
+    [[noreturn]] void mapItems(Interpreter &interpreter, const std::vector<LoxObject> &items, const SharedCallablePtr &function,
+                               size_t first, size_t step, int pipe) {
+        //The threads of the task pool weren't forked, a task() call in the child starts a new pool. The old one can't be destroyed
+        new std::shared_ptr<TaskPool>(std::move(interpreter.taskPool));
+
+        std::ostringstream output;
+        interpreter.getOutput().rdbuf(output.rdbuf());
+        Token token(TokenType::IDENTIFIER, "fork_map", -1);
+        binary::Writer out;
+        for (size_t i = first; i < items.size(); i += step){
+            std::vector<LoxObject> arguments{items[i]};
+            binary::Writer record;
+            try {
+                LoxObject result = interpreter.call(LoxObject(function), arguments, token);
+                record.u8(static_cast<uint8_t>(Status::RESULT));
+                record.string(output.str());
+                writeValue(result, record);
+            } catch (const LoxError &exception) {
+                record.bytes.clear();
+                record.u8(static_cast<uint8_t>(Status::ERROR));
+                record.string(output.str());
+                record.string(exception.what());
+            }
+            out.raw(record.bytes.data(), record.bytes.size());
+            output.str("");
+            if (static_cast<Status>(record.bytes[0]) == Status::ERROR) break;
+        }
+
+        const uint8_t* data = out.bytes.data();
+        size_t remaining = out.bytes.size();
+        while (remaining > 0){
+            ssize_t written = ::write(pipe, data, remaining);
+            if (written < 0 && errno == EINTR) continue;
+            if (written < 0) ::_exit(1);
+            data += written;
+            remaining -= written;
+        }
+        ::_exit(0); //Skips the destructors of the copy of the parent's heap
+    }
+
+    //Reads the pipes of the children until they are all closed, a child blocks if its pipe is full
+    void collect(std::vector<Child> &children) {
+        std::vector<pollfd> fds;
+        std::vector<Child*> running;
+        while (true){
+            fds.clear();
+            running.clear();
+            for (Child &child : children){
+                if (child.finished) continue;
+                fds.push_back({child.pipe, POLLIN, 0});
+                running.push_back(&child);
+            }
+            if (fds.empty()) break;
+            if (::poll(fds.data(), fds.size(), -1) < 0 && errno != EINTR) break;
+
+            for (size_t i = 0; i < fds.size(); i++){
+                if (fds[i].revents == 0) continue;
+
+                char buffer[1 << 16];
+                ssize_t received = ::read(fds[i].fd, buffer, sizeof(buffer));
+                if (received > 0){
+                    running[i]->data.append(buffer, received);
+                } else if (received == 0 || errno != EINTR){
+                    running[i]->finished = true;
+                }
+            }
+        }
+
+        for (Child &child : children){
+            ::close(child.pipe);
+            int status = 0;
+            while (::waitpid(child.pid, &status, 0) < 0 && errno == EINTR) {}
+            if (WIFSIGNALED(status)) child.killedBy = WTERMSIG(status);
+        }
+    }
+}
+
+
+LoxObject ForkMap::run(Interpreter &interpreter, const SharedListPtr &list, const SharedCallablePtr &function, int workers) {
+    if (workers < 1){
+        throw LoxRuntimeError("fork_map needs at least one worker, got " + std::to_string(workers));
+    }
+    if (TaskPool::onWorker()){
+        //Only the forking thread would exist in the children, the rest of the pool would be missing
+        throw LoxRuntimeError("fork_map can't be called inside a task");
+    }
+
+    const std::vector<LoxObject> &items = list->getItems();
+    size_t childCount = std::min(items.size(), static_cast<size_t>(workers));
+    //Anything still buffered would be written again by every child
+    interpreter.flushOutput();
+    std::cout.flush();
+
+    std::vector<Child> children(childCount);
+    for (size_t k = 0; k < childCount; k++){
+        int fds[2];
+        if (::pipe(fds) < 0){
+            children.resize(k);
+            collect(children);
+            throw LoxRuntimeError("fork_map could not create a pipe");
+        }
+
+        int pid = ::fork();
+        if (pid == 0){
+            ::close(fds[0]);
+            for (size_t j = 0; j < k; j++){
+                ::close(children[j].pipe);
+            }
+            mapItems(interpreter, items, function, k, childCount, fds[1]);
+        }
+
+        ::close(fds[1]);
+        if (pid < 0){
+            ::close(fds[0]);
+            children.resize(k);
+            collect(children);
+            throw LoxRuntimeError("fork_map could not start a worker");
+        }
+        children[k].pid = pid;
+        children[k].pipe = fds[0];
+    }
+    collect(children);
+
+    //Item i is the (i / childCount)th record of child i % childCount
+    std::vector<binary::Reader> readers;
+    readers.reserve(childCount);
+    for (const Child &child : children){
+        readers.emplace_back(reinterpret_cast<const uint8_t*>(child.data.data()), child.data.size());
+    }
+
+    std::vector<LoxObject> results;
+    results.reserve(items.size());
+    for (size_t i = 0; i < items.size(); i++){
+        binary::Reader &in = readers[i % childCount];
+        const Child &child = children[i % childCount];
+        if (in.atEnd()){
+            std::string reason = child.killedBy != 0 ? "was killed by signal " + std::to_string(child.killedBy) : "stopped";
+            throw LoxRuntimeError("fork_map worker " + reason + " before mapping item " + std::to_string(i));
+        }
+
+        try {
+            auto status = static_cast<Status>(in.u8());
+            interpreter.getOutput() << in.string();
+            if (status == Status::ERROR){
+                throw LoxRuntimeError("fork_map failed on item " + std::to_string(i) + ": " + std::string(in.string()));
+            }
+            results.push_back(readValue(in));
+        } catch (const binary::FormatError &) {
+            throw LoxRuntimeError("fork_map worker sent a truncated result for item " + std::to_string(i));
+        }
+    }
+    return LoxObject(std::make_shared<LoxList>(nullptr, results));
+}
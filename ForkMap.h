@@ -0,0 +1,24 @@
+#ifndef JLOX_FORKMAP_H
+#define JLOX_FORKMAP_H
+
+#include "LoxCallable.h"
+#include "LoxObject.h"
+
+class Interpreter;
+
+/*fork_map(list, function, workers): parallel map on processes instead of threads, for functions that can't run as tasks (they read
+ * global variables, modify captured state, ...). The interpreter forks workers times and every child starts from a copy-on-write copy
+ * of the whole heap, so the function sees everything it would see on the interpreter itself and nothing has to be copied up front.
+ * Child k maps the items k, k + workers, k + 2 * workers, ... and writes the results back through a pipe. Whatever a call modifies
+ * stays in its child.
+ *
+ * Results travel as data, so they can only be nil, booleans, numbers, strings and lists of them. Like parallel_map the output of the
+ * calls is written in the order of the items, and if several items fail the error of the first one is reported.
+ * */
+class ForkMap {
+public:
+    static LoxObject run(Interpreter &interpreter, const SharedListPtr &list, const SharedCallablePtr &function, int workers);
+};
+
+
+#endif //JLOX_FORKMAP_H
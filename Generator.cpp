@@ -0,0 +1,131 @@
+#include "Generator.h"
+#include <utility>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "Interpreter.h"
+#include "LoxError.h"
+#include "Token.h"
+
+namespace {
+    //Generator running on this thread, the innermost one if a generator resumes another one
+    thread_local Generator* running = nullptr;
+
+    constexpr size_t DEFAULT_STACK_SIZE = 8 * 1024 * 1024;
+}
+
+thread_local uintptr_t Generator::stackLimit = 0;
+
+
+LoxObject Generator::create(Interpreter &interpreter, const SharedCallablePtr &function, LoxArguments arguments) {
+    auto generator = std::make_shared<Generator>(interpreter, function, std::vector<LoxObject>(arguments.begin(), arguments.end()));
+    return LoxIterator::makeHandle(generator, "Generator");
+}
+
+Generator::Generator(Interpreter &interpreter, SharedCallablePtr function, std::vector<LoxObject> arguments)
+        : interpreter(interpreter), function(std::move(function)), arguments(std::move(arguments)), environment(interpreter.globalEnv) {}
+
+Generator::~Generator() {
+    if (state == State::SUSPENDED){
+        cancelled = true;
+        try {
+            resume();
+        } catch (...) {} //A destructor can't report it, and the generator is going away anyway
+    }
+    if (stack != nullptr){
+        ::munmap(stack, stackSize());
+    }
+}
+
+/*What the main thread gets, plus the guard page and STACK_MARGIN below it, so a script that recurses fine outside of a generator also
+ * does inside one*/
+size_t Generator::stackSize() {
+    static const size_t size = [] {
+        size_t usable = DEFAULT_STACK_SIZE;
+        rlimit limit{};
+        if (::getrlimit(RLIMIT_STACK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY){
+            usable = static_cast<size_t>(limit.rlim_cur);
+        }
+        size_t page = ::sysconf(_SC_PAGESIZE);
+        return (usable + page - 1) / page * page + page + STACK_MARGIN;
+    }();
+    return size;
+}
+
+bool Generator::produce(Interpreter &, LoxObject &item) {
+    if (!resume()) return false;
+    item = std::move(yielded.value());
+    yielded.reset();
+    return true;
+}
+
+bool Generator::resume() {
+    if (state == State::FINISHED) return false;
+    if (state == State::RUNNING){
+        throw LoxRuntimeError("Generator is already running, it can't resume itself");
+    }
+
+    if (state == State::NOT_STARTED){
+        stack = ::mmap(nullptr, stackSize(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+        if (stack == MAP_FAILED){
+            stack = nullptr;
+            throw LoxRuntimeError("Could not allocate the stack of a generator");
+        }
+        ::mprotect(stack, ::sysconf(_SC_PAGESIZE), PROT_NONE);
+        ::getcontext(&context);
+        context.uc_stack.ss_sp = stack;
+        context.uc_stack.ss_size = stackSize();
+        context.uc_link = &caller;
+        ::makecontext(&context, &Generator::entry, 0);
+    }
+
+    resumer = running;
+    running = this;
+    switchState();
+    state = State::RUNNING;
+    stackLimit = reinterpret_cast<uintptr_t>(stack) + STACK_MARGIN;
+    ::swapcontext(&caller, &context);
+    stackLimit = resumer != nullptr ? reinterpret_cast<uintptr_t>(resumer->stack) + STACK_MARGIN : 0;
+    switchState();
+    running = resumer;
+
+    if (error){
+        std::rethrow_exception(std::exchange(error, nullptr));
+    }
+    return yielded.has_value();
+}
+
+//The interpreter runs on the environment and argument stack of whichever side of the switch is running
+void Generator::switchState() {
+    std::swap(interpreter.environment, environment);
+    std::swap(interpreter.argumentStack, argumentStack);
+}
+
+//Bottom of the stack of the coroutine, returning from it switches back to caller (uc_link)
+void Generator::entry() {
+    Generator* self = running;
+    try {
+        Token token(TokenType::IDENTIFIER, "generator", -1);
+        self->interpreter.call(LoxObject(self->function), self->arguments, token);
+    } catch (const Cancelled &) {
+    } catch (...) {
+        self->error = std::current_exception();
+    }
+    self->function.reset();
+    self->arguments.clear();
+    self->state = State::FINISHED;
+}
+
+void Generator::yield(const LoxObject &value) {
+    Generator* self = running;
+    if (self == nullptr){
+        throw LoxRuntimeError("yield() can only be called inside a generator");
+    }
+
+    self->yielded = value;
+    self->state = State::SUSPENDED;
+    ::swapcontext(&self->context, &self->caller);
+    if (self->cancelled){
+        throw Cancelled();
+    }
+}
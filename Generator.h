@@ -0,0 +1,92 @@
+#ifndef JLOX_GENERATOR_H
+#define JLOX_GENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <ucontext.h>
+#include "ArgumentStack.h"
+#include "Environment.h"
+#include "LoxCallable.h"
+#include "LoxIterator.h"
+#include "LoxObject.h"
+
+class Interpreter;
+
+/*Lazy sequences. generator(function, args...) returns a generator that calls function(args...) on its own stack (a stackful coroutine,
+ * switched with swapcontext). Whenever the call, or any function it calls, runs yield(value) the generator stops right there and hands
+ * value to whoever asked for it; the next request resumes it where it stopped. So a generator produces its values one at a time, and a
+ * sequence of millions of items never has to fit in memory. A generator is an iterator (see LoxIterator.h): next() runs it until its
+ * next yield and returns the value (nil once the function returned), done() tells if the function returned, and for-in loops over it.
+ * What the function returns is ignored. A runtime error inside the generator is reported by the next() or done() call that resumed it
+ * and finishes the generator.
+ *
+ * The generator has its own environment and ArgumentStack, swapped with the ones of the interpreter while it runs, so the frames of the
+ * generator and the ones of its caller don't have to be nested. A generator that is dropped before it finished is resumed once more and
+ * unwinds its stack, so the objects its frames hold are released.
+ *
+ * The part of the stack the generator can use is at least as big as the stack of the main thread (RLIMIT_STACK, 8 MiB if there is
+ * no limit), with STACK_MARGIN and a guard page below it. It is only reserved, most of it is never touched. Interpreter::call checks
+ * stackExhausted() before every call, so a recursion that goes too deep inside a generator is a runtime error instead of a crash on
+ * the guard page.
+ * */
+class Generator : public LoxIterator {
+public:
+    //Implements generator(function, args...)
+    static LoxObject create(Interpreter &interpreter, const SharedCallablePtr &function, LoxArguments arguments);
+    //Implements yield(value)
+    static void yield(const LoxObject &value);
+    //True when the generator running on this thread is close to the end of its stack. Always false outside of generators
+    static bool stackExhausted() {
+        char probe;
+        return reinterpret_cast<uintptr_t>(&probe) < stackLimit;
+    }
+
+    Generator(Interpreter &interpreter, SharedCallablePtr function, std::vector<LoxObject> arguments);
+    ~Generator() override;
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+
+protected:
+    bool produce(Interpreter &interpreter, LoxObject &item) override;
+
+private:
+    //Thrown by yield when a suspended generator is destroyed, to unwind its stack. Not a LoxError, so nothing else catches it
+    struct Cancelled {};
+    enum class State { NOT_STARTED, SUSPENDED, RUNNING, FINISHED };
+
+    //Room left for the frames of the call that finds the stack exhausted, for throwing the error and for unwinding
+    static constexpr size_t STACK_MARGIN = 256 * 1024;
+    //Lowest address the stack of the generator running on this thread may reach before stackExhausted(), 0 outside of generators
+    static thread_local uintptr_t stackLimit;
+
+    static size_t stackSize();
+
+    Interpreter &interpreter;
+    SharedCallablePtr function;
+    std::vector<LoxObject> arguments;
+    State state = State::NOT_STARTED;
+    //Value passed to yield, until resume() hands it out
+    std::optional<LoxObject> yielded;
+    std::exception_ptr error;
+    bool cancelled = false;
+
+    //Stack of the coroutine, with a guard page at the bottom. Mapped lazily, most of it is never touched
+    void* stack = nullptr;
+    ucontext_t context{}, caller{};
+    //Generator that was running when this one was resumed, if any
+    Generator* resumer = nullptr;
+    Environment::SharedPtr environment;
+    ArgumentStack argumentStack;
+
+    //Runs the generator until it yields (returns true) or finishes
+    bool resume();
+    void switchState();
+    static void entry();
+};
+
+
+#endif //JLOX_GENERATOR_H
@@ -5,16 +5,16 @@
 #include <stdexcept>
 #include <string>
 #include <sstream>
+#include "Generator.h"
 #include "LoxClass.h"
 #include "LoxError.h"
 #include "LoxFunction.h"
+#include "LoxIterator.h"
 #include "TokenType.h"
 #include "LoxCallable.h"
 #include "LoxList.h"
 #include "standardlib/StandardFunctions.h"
 
-//TODO: Add support for loading standard function in a more clean way
-
 
 Interpreter::Interpreter() {
     environment = std::make_shared<Environment>();
@@ -22,14 +22,20 @@ Interpreter::Interpreter() {
     loadBuiltinFunctions();
 }
 
+Interpreter::Interpreter(std::ostream &output) : outputWriter(output) {
+    environment = std::make_shared<Environment>();
+    globalEnv = environment;
+    loadBuiltinFunctions();
+}
+
 
 /*This function unpacks every UniqueStmtPtr into a raw pointer and then executes it. This is because the Interpreter does not
  * own the dynamically allocated statement objects, it only operates on them, so it should use raw pointers instead of a
  * smart pointer to signal that it does not own and has no influence over the lifetime of the objects.
+ * Functions and classes declared by the statements keep pointing into the AST after this call, so the caller has to keep the AST
+ * alive as long as the interpreter (see Program.h).
  * */
-void Interpreter::interpret(const std::vector<UniqueStmtPtr> &statements, const std::unordered_map<const Expr*, int> &distances, bool replMode) {
-    this->localsDistances = distances;
-
+void Interpreter::interpret(const std::vector<UniqueStmtPtr> &statements, bool replMode) {
     if (replMode){
         assert(statements.size() == 1);
         interpretReplMode(statements[0].get());
@@ -49,7 +55,7 @@ void Interpreter::interpretReplMode(Stmt *stmt) {
             return;
         }
 
-        std::cout << result << "\n";
+        print(result);
     } else {
         execute(stmt);
     }
@@ -69,25 +75,38 @@ void Interpreter::execute(Stmt* stmt) {
     stmt->accept(*this);
 }
 
+void Interpreter::interpret(const CompiledBlock &program) {
+    for (auto const &stmt : program){
+        stmt(*this);
+    }
+}
+
+void Interpreter::executeBlock(const CompiledBlock &stmts, Environment::SharedPtr newEnv) {
+    ScopedEnvironment scope(environment, std::move(newEnv));
+    for (auto const &stmt : stmts){
+        stmt(*this);
+    }
+}
+
+LoxObject Interpreter::interpret(const CompiledExpr &expr, Environment::SharedPtr newEnv) {
+    ScopedEnvironment env(environment, std::move(newEnv));
+    return expr(*this);
+}
+
 //STATEMENTS
 
 void Interpreter::visit(const VarDeclarationStmt *varDeclarationStmt) {
     if (varDeclarationStmt->expr.has_value()){
         LoxObject initializer = interpret(varDeclarationStmt->expr.value().get());
-        environment->define(varDeclarationStmt->identifier, initializer);
+        define(varDeclarationStmt->identifier, initializer);
     } else {
-        environment->define(varDeclarationStmt->identifier, LoxObject::Nil());
+        define(varDeclarationStmt->identifier, LoxObject::Nil());
     }
 }
 
 LoxObject Interpreter::visit(const AssignmentExpr *assignmentExpr) {
     LoxObject value = interpret(assignmentExpr->value.get());
-    if (localsDistances.find(assignmentExpr) != localsDistances.end()){
-        environment->assignAt(assignmentExpr->identifier, value, localsDistances[assignmentExpr]);
-    } else {
-        globalEnv->assign(assignmentExpr->identifier, value);
-    }
-
+    assignVariable(assignmentExpr->distance, assignmentExpr->globalSymbol, assignmentExpr->identifier, value);
     return value;
 }
 
@@ -98,12 +117,12 @@ void Interpreter::visit(const ExpressionStmt *expressionStmt) {
 
 void Interpreter::visit(const PrintStmt *printStmt) {
     if (!printStmt->expr.has_value()){
-        std::cout << "\n";
+        printNewline();
         return;
     }
 
     LoxObject result = interpret(printStmt->expr.value().get());
-    std::cout << result << "\n";
+    print(result);
 }
 
 void Interpreter::visit(const IfStmt *ifStmt) {
@@ -166,6 +185,26 @@ void Interpreter::visit(const ForStmt *forStmt) {
     }
 }
 
+//The loop variable lives in its own scope and is overwritten in place on every iteration, like the variable of a for loop
+void Interpreter::visit(const ForInStmt *forInStmt) {
+    LoxObject iterable = interpret(forInStmt->iterable.get());
+    Environment::SharedPtr newEnv = std::make_shared<Environment>(environment);
+    ScopedEnvironment scoped(environment, newEnv);
+    LoxObject &variable = newEnv->defineSlot(forInStmt->name);
+
+    LoxIterator::forEach(*this, iterable, forInStmt->name.line, [&](const LoxObject &item) {
+        variable = item;
+        try {
+            execute(forInStmt->body.get());
+        } catch (const BreakException &exception) {
+            return false;
+        } catch (const ContinueException &exception) {
+            //empty
+        }
+        return true;
+    });
+}
+
 void Interpreter::visit(const BlockStmt *blockStmt) {
     Environment::SharedPtr newEnv = std::make_shared<Environment>(environment);
     executeBlock(blockStmt->statements, newEnv);
@@ -186,7 +225,7 @@ void Interpreter::visit(const ContinueStmt *continueStmt) {
 void Interpreter::visit(const FunctionDeclStmt *functionStmt) {
     SharedCallablePtr function = std::make_shared<LoxFunction>(functionStmt, environment);
     LoxObject functionObject(function);
-    environment->define(functionStmt->name, functionObject);
+    define(functionStmt->name, functionObject);
 }
 
 LoxObject Interpreter::visit(const LambdaExpr *lambdaExpr) {
@@ -208,7 +247,7 @@ void Interpreter::visit(const ReturnStmt *returnStmt) {
 
 
 void Interpreter::visit(const ClassDeclStmt *classDeclStmt) {
-    environment->define(classDeclStmt->identifier, LoxObject::Nil());
+    define(classDeclStmt->identifier, LoxObject::Nil());
 
     std::optional<LoxObject> superclass = getSuperclass(classDeclStmt);
     std::optional<SharedCallablePtr> superclassPtr = std::nullopt;
@@ -219,12 +258,10 @@ void Interpreter::visit(const ClassDeclStmt *classDeclStmt) {
         environment->define("super", superclass.value());
     }
 
-    std::unordered_map<std::string, LoxObject> methods;
+    std::unordered_map<std::string, std::shared_ptr<LoxFunction>> methods;
     for (const auto& method : classDeclStmt->methods){
         bool isConstructor = method->name.lexeme == "init";
-        SharedCallablePtr callable = std::make_shared<LoxFunction>(method.get(), environment, isConstructor);
-        LoxObject functionObject(callable);
-        methods[method->name.lexeme] = functionObject;
+        methods[method->name.lexeme] = std::make_shared<LoxFunction>(method.get(), environment, isConstructor);
     }
 
 
@@ -235,23 +272,26 @@ void Interpreter::visit(const ClassDeclStmt *classDeclStmt) {
 
     SharedCallablePtr klass = std::make_shared<LoxClass>(classDeclStmt->identifier.lexeme, methods, superclassPtr);
     LoxObject classObject(klass);
-    environment->assign(classDeclStmt->identifier, classObject);
+    assignInCurrentScope(classDeclStmt->identifier, classObject);
 }
 
 std::optional<LoxObject> Interpreter::getSuperclass(const ClassDeclStmt* classDeclStmt) {
     std::optional<LoxObject> superclass = std::nullopt;
     if (classDeclStmt->superclass.has_value()){
         LoxObject object = interpret(classDeclStmt->superclass.value().get());
-        if (!object.isCallable() || object.getCallable()->type != LoxCallable::CallableType::CLASS){
-            throw LoxRuntimeError("Superclass must be a class.", classDeclStmt->identifier.line);
-        }
-
+        checkSuperclass(object, classDeclStmt);
         superclass = object;
     }
 
     return superclass;
 }
 
+void Interpreter::checkSuperclass(const LoxObject &superclass, const ClassDeclStmt *classDeclStmt) {
+    if (!superclass.isCallable() || superclass.getCallable()->type != LoxCallable::CallableType::CLASS){
+        throw LoxRuntimeError("Superclass must be a class.", classDeclStmt->identifier.line);
+    }
+}
+
 //EXPRESSIONS
 
 LoxObject Interpreter::visit(const BinaryExpr *binaryExpr) {
@@ -309,11 +349,7 @@ LoxObject Interpreter::visit(const IncrementExpr *incrementExpr) {
     LoxObject inc = prev + LoxObject(1.0);
 
     const VariableExpr *variableExpr = incrementExpr->variable.get();
-    if (localsDistances.find(variableExpr) != localsDistances.end()){
-        environment->assignAt(variableExpr->identifier, inc, localsDistances[variableExpr]);
-    } else {
-        globalEnv->assign(variableExpr->identifier, inc);
-    }
+    assignVariable(variableExpr->distance, variableExpr->globalSymbol, variableExpr->identifier, inc);
 
     if (incrementExpr->type == IncrementExpr::Type::POSTFIX){
         return prev;
@@ -327,11 +363,7 @@ LoxObject Interpreter::visit(const DecrementExpr *decrementExpr) {
     LoxObject dec = prev - LoxObject(1.0);
 
     const VariableExpr *variableExpr = decrementExpr->variable.get();
-    if (localsDistances.find(variableExpr) != localsDistances.end()){
-        environment->assignAt(variableExpr->identifier, dec, localsDistances[variableExpr]);
-    } else {
-        globalEnv->assign(variableExpr->identifier, dec);
-    }
+    assignVariable(variableExpr->distance, variableExpr->globalSymbol, variableExpr->identifier, dec);
 
     if (decrementExpr->type == DecrementExpr::Type::POSTFIX){
         return prev;
@@ -344,15 +376,39 @@ LoxObject Interpreter::visit(const LiteralExpr *literalExpr) {
 }
 
 LoxObject Interpreter::visit(const VariableExpr *variableExpr) {
-    LoxObject obj = lookupVariable(variableExpr, variableExpr->identifier);
+    LoxObject obj = lookupVariable(variableExpr->distance, variableExpr->globalSymbol, variableExpr->identifier);
     return obj;
 }
 
-LoxObject Interpreter::lookupVariable(const Expr *variableExpr, const Token &identifier) {
-    if (localsDistances.find(variableExpr) != localsDistances.end()){
-        return environment->getAt(identifier, localsDistances[variableExpr]);
+LoxObject Interpreter::lookupVariable(const std::optional<int> &distance, size_t globalSymbol, const Token &identifier) {
+    if (distance.has_value()){
+        return environment->getAt(identifier, distance.value());
+    }
+    return GlobalEnvironment::get(globals.cell(globalSymbol, identifier.lexeme), identifier);
+}
+
+void Interpreter::assignVariable(const std::optional<int> &distance, size_t globalSymbol, const Token &identifier, const LoxObject &value) {
+    if (distance.has_value()){
+        environment->assignAt(identifier, value, distance.value());
+    } else {
+        GlobalEnvironment::assign(globals.cell(globalSymbol, identifier.lexeme), identifier, value);
+    }
+}
+
+void Interpreter::define(const Token &identifier, const LoxObject &value) {
+    if (environment == globalEnv){
+        globals.define(identifier, value);
+    } else {
+        environment->define(identifier, value);
+    }
+}
+
+void Interpreter::assignInCurrentScope(const Token &identifier, const LoxObject &value) {
+    if (environment == globalEnv){
+        GlobalEnvironment::assign(globals.cell(identifier.lexeme), identifier, value);
+    } else {
+        environment->assign(identifier, value);
     }
-    return globalEnv->get(identifier);
 }
 
 LoxObject Interpreter::visit(const OrExpr *orExpr) {
@@ -377,19 +433,27 @@ LoxObject Interpreter::visit(const AndExpr *andExpr) {
 LoxObject Interpreter::visit(const CallExpr *callExpr) {
     LoxObject callee = interpret(callExpr->callee.get());
 
-    std::vector<LoxObject> arguments;
-    for (const UniqueExprPtr &arg : callExpr->arguments){
-        arguments.push_back(interpret(arg.get()));
+    ArgumentStack::Frame frame(argumentStack, callExpr->arguments.size());
+    for (size_t i = 0; i < callExpr->arguments.size(); i++){
+        frame.arguments[i] = interpret(callExpr->arguments[i].get());
     }
 
+    return call(callee, frame.arguments, callExpr->closingParen);
+}
+
+LoxObject Interpreter::call(const LoxObject &callee, LoxArguments arguments, const Token &closingParen) {
     if (!callee.isCallable()){
-        throw LoxRuntimeError("Expression is not callable", callExpr->closingParen.line);
+        throw LoxRuntimeError("Expression is not callable", closingParen.line);
     }
     LoxCallable* callable = callee.getCallable().get();
-    if (arguments.size() != callable->arity()){
+    size_t arity = callable->arity();
+    if (arguments.size() != arity && !(callable->isVariadic() && arguments.size() > arity)){
         std::stringstream ss;
-        ss  << callable->name() << " expected " << callable->arity() << " argument(s) but instead got " << arguments.size();
-        throw LoxRuntimeError(ss.str(), callExpr->closingParen.line);
+        ss  << callable->name() << " expected " << (callable->isVariadic() ? "at least " : "") << arity << " argument(s) but instead got " << arguments.size();
+        throw LoxRuntimeError(ss.str(), closingParen.line);
+    }
+    if (Generator::stackExhausted()){
+        throw LoxRuntimeError("Stack overflow inside a generator", closingParen.line);
     }
 
     return callable->call(*this, arguments);
@@ -416,7 +480,8 @@ LoxObject Interpreter::visit(const SetExpr *setExpr) {
 }
 
 LoxObject Interpreter::visit(const ThisExpr *thisExpr) {
-    return lookupVariable(thisExpr, thisExpr->keyword);
+    //The Resolver only accepts this inside a method, so it is always local
+    return environment->getAt(thisExpr->keyword, thisExpr->distance.value());
 }
 
 void Interpreter::executeBlock(const std::vector<UniqueStmtPtr> &stmts, Environment::SharedPtr newEnv) {
@@ -427,25 +492,23 @@ void Interpreter::executeBlock(const std::vector<UniqueStmtPtr> &stmts, Environm
 }
 
 LoxObject Interpreter::visit(const SuperExpr *superExpr) {
-    int distance = localsDistances[superExpr]; //distance from current env to env where the superclass is stored
+    int distance = superExpr->distance.value(); //distance from current env to env where the superclass is stored
     //Get the superclass object and cast it to LoxClass
     LoxObject superclassObj = environment->getAt("super", distance);
-    LoxClass* superclass = dynamic_cast<LoxClass*>(superclassObj.getCallable().get());
-    assert(superclass);
+    assert(superclassObj.getCallable()->type == LoxCallable::CallableType::CLASS); //checked when the class was declared
+    LoxClass* superclass = static_cast<LoxClass*>(superclassObj.getCallable().get());
 
-    //Get the method that the superExpr is referring to from the superclass and cast it as a LoxFunction
-    std::optional<LoxObject> methodObj = superclass->findMethod(superExpr->identifier.lexeme);
-    if (!methodObj.has_value()){
+    //Get the method that the superExpr is referring to from the superclass
+    LoxFunction* method = superclass->findMethod(superExpr->identifier.lexeme);
+    if (!method){
         throw LoxRuntimeError("Undefined property " + superExpr->identifier.lexeme, superExpr->keyword.line);
     }
-    LoxFunction* method = dynamic_cast<LoxFunction*>(methodObj.value().getCallable().get());
-    assert(method);
 
     LoxObject instanceObj = environment->getAt("this", distance-1); // "this" is always one level nearer than "super"'s environment.
 
     //Bind "this" to the superclass' method. Even though the method comes from the superclass, "this" refers to the instance that is
     //calling the method.
-    SharedCallablePtr bindedMethod(method->bindThis(instanceObj.getClassInstance()));
+    SharedCallablePtr bindedMethod = method->bindThis(instanceObj.getClassInstance());
     LoxObject bindedMethodObj(bindedMethod);
     return bindedMethodObj;
 }
@@ -461,16 +524,32 @@ LoxObject Interpreter::visit(const ListExpr *listExpr) {
     return listObj;
 }
 
-void Interpreter::loadBuiltinFunctions() {
-    SharedCallablePtr clock = std::make_shared<standardFunctions::Clock>();
-    SharedCallablePtr sleep = std::make_shared<standardFunctions::Sleep>();
-    SharedCallablePtr str = std::make_shared<standardFunctions::Str>();
+void Interpreter::print(const LoxObject &value) {
+    formatBuffer.clear();
+    value.format(formatBuffer);
+    output.write(formatBuffer.data(), formatBuffer.size());
+    printNewline();
+}
 
-    std::vector<LoxObject> functions = {LoxObject(clock), LoxObject(sleep), LoxObject(str)};
-    for (const auto &function : functions){
-        globalEnv->define(function.getCallable()->name(), function);
+void Interpreter::printNewline() {
+    output << '\n';
+    if (unbufferedOutput){
+        flushOutput();
     }
+}
+
+void Interpreter::flushOutput() {
+    outputWriter.flush();
+}
 
+std::ostream& Interpreter::getOutput() {
+    return output;
+}
+
+void Interpreter::loadBuiltinFunctions() {
+    for (const SharedCallablePtr &function : standardFunctions::builtins()){
+        globals.define(function->name(), LoxObject(function));
+    }
 }
 
 
@@ -1,27 +1,70 @@
 #ifndef JLOX_INTERPRETER_H
 #define JLOX_INTERPRETER_H
 
+#include <memory>
+#include <optional>
+#include <ostream>
 #include <unordered_map>
 #include <vector>
+#include "ArgumentStack.h"
 #include "Environment.h"
 #include "Expr.h"
 #include "Stmt.h"
 #include "LoxObject.h"
+#include "OutputWriter.h"
 #include "typedefs.h"
 
+class EventLoop;
+class TaskPool;
+
+/*An Interpreter owns all the state of the programs it runs (environments, globals, builtins, output buffer) and there
+ * is no global state shared between interpreters (but the locked table of global symbols, see GlobalEnvironment::symbol), so independent
+ * interpreters can run at the same time on different threads, even the same resolved program (which is never modified while running,
+ * see Program.h).
+ * A single interpreter, and the values it creates, must only be used by one thread at a time.
+ * */
 class Interpreter : public ExprVisitor, public StmtVisitor {
 public:
+    //Root of the environment chain. The variables of the outermost scope are stored in globals, not in globalEnv.
     Environment::SharedPtr globalEnv;
     Environment::SharedPtr environment;
-    //Contains the number of "hops" between the current environment and the environment where the variable referenced by Expr* is stored
-    std::unordered_map<const Expr*, int> localsDistances;
+    //Declared before globals: a suspended generator dropped with the globals still unwinds its frames, which pop arguments off it
+    ArgumentStack argumentStack;
+    GlobalEnvironment globals;
+    //When true print statements are written out immediately instead of being collected in the output buffer
+    bool unbufferedOutput = false;
+    //Workers of the tasks created by this interpreter, started by the first task() call. See TaskPool.h
+    std::shared_ptr<TaskPool> taskPool;
+    //Timers and file reads waiting for their callback, created by the first set_timeout() or read_file() call. See EventLoop.h
+    std::shared_ptr<EventLoop> eventLoop;
 
+    //Prints to standard output
     Interpreter();
+    //Prints to output instead of standard output
+    explicit Interpreter(std::ostream &output);
 
-    void interpret(const std::vector<UniqueStmtPtr> &statements, const std::unordered_map<const Expr*, int> &distances, bool replMode = false);
+    void interpret(const std::vector<UniqueStmtPtr> &statements, bool replMode = false);
     void executeBlock(const std::vector<UniqueStmtPtr> &stmts, Environment::SharedPtr newEnv);
     LoxObject interpret(Expr* expr, Environment::SharedPtr newEnv);
 
+    //Entry points for code produced by the ClosureCompiler
+    void interpret(const CompiledBlock &program);
+    void executeBlock(const CompiledBlock &stmts, Environment::SharedPtr newEnv);
+    LoxObject interpret(const CompiledExpr &expr, Environment::SharedPtr newEnv);
+
+    //Shared by both backends
+    //Variables declared in the outermost scope are stored in globals instead of the current environment
+    void define(const Token &identifier, const LoxObject &value);
+    void assignInCurrentScope(const Token &identifier, const LoxObject &value);
+    LoxObject call(const LoxObject &callee, LoxArguments arguments, const Token &closingParen);
+    void checkSuperclass(const LoxObject &superclass, const ClassDeclStmt* classDeclStmt);
+    //Output of print statements (and of expressions in the REPL). See OutputWriter.h
+    void print(const LoxObject &value);
+    void printNewline();
+    void flushOutput();
+    //Stream print statements write to. The Runner reports errors through it too, so they keep their order relative to the output
+    std::ostream& getOutput();
+
 
     void visit(const ExpressionStmt *expressionStmt) override;
     void visit(const PrintStmt *printStmt) override;
@@ -31,6 +74,7 @@ public:
     void visit(const BreakStmt *breakStmt) override;
     void visit(const WhileStmt *whileStmt) override;
     void visit(const ForStmt *forStmt) override;
+    void visit(const ForInStmt *forInStmt) override;
     void visit(const ContinueStmt *continueStmt) override;
     void visit(const FunctionDeclStmt *functionStmt) override;
     void visit(const ReturnStmt *returnStmt) override;
@@ -56,11 +100,18 @@ public:
     LoxObject visit(const ListExpr *listExpr) override;
 
 private:
+    OutputWriter outputWriter;
+    std::ostream output{&outputWriter};
+    //Reused by print so formatting a value doesn't allocate once the buffer has grown
+    std::string formatBuffer;
+
     void interpretReplMode(Stmt* stmt);
     LoxObject interpret(Expr* expr);
     void execute(Stmt* pStmt);
     void loadBuiltinFunctions();
-    LoxObject lookupVariable(const Expr *pExpr, const Token &identifier);
+    //globalSymbol is only used when there is no distance, see Expr.h
+    LoxObject lookupVariable(const std::optional<int> &distance, size_t globalSymbol, const Token &identifier);
+    void assignVariable(const std::optional<int> &distance, size_t globalSymbol, const Token &identifier, const LoxObject &value);
     std::optional<LoxObject> getSuperclass(const ClassDeclStmt* classDeclStmt);
 };
 
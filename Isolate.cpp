@@ -0,0 +1,174 @@
+#include "Isolate.h"
+#include <unordered_map>
+#include <utility>
+#include "EventLoop.h"
+#include "Interpreter.h"
+#include "LoxClass.h"
+#include "LoxError.h"
+#include "Token.h"
+#include "ValueCopier.h"
+#include "standardlib/NativeFunction.h"
+
+
+void Mailbox::post(LoxObject message) {
+    queue.push(std::move(message));
+    //The push is sequentially consistent, so either the consumer sees the message or we see it waiting
+    if (consumerWaiting.load()){
+        std::lock_guard<std::mutex> lock(mutex);
+        messagePosted.notify_one();
+    }
+}
+
+std::optional<LoxObject> Mailbox::take() {
+    std::optional<LoxObject> message = queue.pop();
+    if (message.has_value()){
+        return message;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    consumerWaiting.store(true);
+    while (!(message = queue.pop()).has_value() && !closed.load()){
+        messagePosted.wait(lock);
+    }
+    consumerWaiting.store(false);
+    //Messages posted before the mailbox was closed are still delivered
+    return message.has_value() ? message : queue.pop();
+}
+
+void Mailbox::close() {
+    closed.store(true);
+    std::lock_guard<std::mutex> lock(mutex);
+    messagePosted.notify_all();
+}
+
+
+std::string Isolate::Output::take() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string taken;
+    taken.swap(text);
+    return taken;
+}
+
+Isolate::Output::int_type Isolate::Output::overflow(int_type ch) {
+    if (ch != traits_type::eof()){
+        std::lock_guard<std::mutex> lock(mutex);
+        text += traits_type::to_char_type(ch);
+    }
+    return ch;
+}
+
+std::streamsize Isolate::Output::xsputn(const char *s, std::streamsize count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    text.append(s, count);
+    return count;
+}
+
+
+Isolate::Isolate(Interpreter &parent)
+    : interpreter(std::make_unique<Interpreter>(outputStream)), globalEnv(interpreter->globalEnv), parentGlobalEnv(parent.globalEnv) {
+    //Outside of an isolate send() and receive() are builtins that throw, see StandardFunctions.cpp
+    interpreter->globals.cell("send")->value = LoxObject(standardFunctions::makeNative("send", [this](Interpreter &current, const LoxObject &message) {
+        current.flushOutput(); //so the parent writes what was printed before the message
+        outbox.post(ValueCopier(current, parentGlobalEnv).copy(message));
+    }));
+    interpreter->globals.cell("receive")->value = LoxObject(standardFunctions::makeNative("receive", [this]() {
+        std::optional<LoxObject> message = inbox.take();
+        if (!message.has_value()){
+            throw LoxRuntimeError("receive() is waiting for a message but the handle of the isolate is gone");
+        }
+        return std::move(message.value());
+    }));
+}
+
+Isolate::~Isolate() {
+    inbox.close();
+    if (thread.joinable()){
+        thread.join();
+    }
+}
+
+LoxObject Isolate::spawn(Interpreter &interpreter, const SharedCallablePtr &function, LoxArguments arguments) {
+    std::shared_ptr<Isolate> isolate(new Isolate(interpreter));
+    ValueCopier copier(interpreter, *isolate->interpreter);
+    copier.copyGlobals();
+    SharedCallablePtr functionCopy = copier.copy(LoxObject(function)).getCallable();
+    std::vector<LoxObject> argumentCopies;
+    argumentCopies.reserve(arguments.size());
+    for (const LoxObject &argument : arguments){
+        argumentCopies.push_back(copier.copy(argument));
+    }
+
+    isolate->thread = std::thread(&Isolate::run, isolate.get(), std::move(functionCopy), std::move(argumentCopies));
+    return makeHandle(isolate);
+}
+
+void Isolate::run(SharedCallablePtr function, std::vector<LoxObject> arguments) {
+    try {
+        Token spawnToken(TokenType::IDENTIFIER, "spawn", -1);
+        LoxObject value = interpreter->call(LoxObject(function), arguments, spawnToken);
+        EventLoop::run(*interpreter);
+        result = ValueCopier(*interpreter, parentGlobalEnv).copy(value);
+    } catch (const LoxError &exception) {
+        error = exception.what();
+    }
+
+    //Everything that belongs to the heap of the isolate is released on its own thread
+    function.reset();
+    arguments.clear();
+    interpreter->flushOutput();
+    interpreter.reset();
+    outbox.close();
+}
+
+//The handle is an instance whose fields are the native methods, so it can only be used by the thread of the parent
+LoxObject Isolate::makeHandle(const std::shared_ptr<Isolate> &isolate) {
+    using standardFunctions::makeNative;
+    auto loxClass = std::make_shared<LoxClass>("Isolate", std::unordered_map<std::string, std::shared_ptr<LoxFunction>>(), std::nullopt);
+    auto handle = std::make_shared<LoxClassInstance>(loxClass);
+    handle->setProperty(Token(TokenType::IDENTIFIER, "send", -1), LoxObject(makeNative("send", [isolate](Interpreter &interpreter, const LoxObject &message) {
+        isolate->send(interpreter, message);
+    })));
+    handle->setProperty(Token(TokenType::IDENTIFIER, "receive", -1), LoxObject(makeNative("receive", [isolate](Interpreter &interpreter) {
+        return isolate->receive(interpreter);
+    })));
+    handle->setProperty(Token(TokenType::IDENTIFIER, "join", -1), LoxObject(makeNative("join", [isolate](Interpreter &interpreter) {
+        return isolate->join(interpreter);
+    })));
+    return LoxObject(handle);
+}
+
+void Isolate::send(Interpreter &parent, const LoxObject &message) {
+    inbox.post(ValueCopier(parent, globalEnv).copy(message));
+}
+
+LoxObject Isolate::receive(Interpreter &parent) {
+    std::optional<LoxObject> message = outbox.take();
+    forwardOutput(parent);
+    if (message.has_value()){
+        return std::move(message.value());
+    }
+
+    //outbox is only closed once the isolate has finished
+    if (error.has_value()){
+        throw LoxRuntimeError("Isolate failed: " + error.value());
+    }
+    throw LoxRuntimeError("Isolate finished without sending a message");
+}
+
+LoxObject Isolate::join(Interpreter &parent) {
+    if (thread.joinable()){
+        thread.join();
+    }
+    forwardOutput(parent);
+    if (error.has_value()){
+        throw LoxRuntimeError("Isolate failed: " + error.value());
+    }
+    return result;
+}
+
+void Isolate::forwardOutput(Interpreter &parent) {
+    std::string text = output.take();
+    if (!text.empty()){
+        parent.getOutput() << text;
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef JLOX_ISOLATE_H
+#define JLOX_ISOLATE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Environment.h"
+#include "LoxCallable.h"
+#include "LoxObject.h"
+#include "tools/SpscQueue.h"
+
+class Interpreter;
+
+/*Messages between an isolate and its parent. post() never blocks nor takes a lock, take() only sleeps on the condition variable
+ * when the queue is empty. There must be a single producer thread and a single consumer thread.
+ * */
+class Mailbox {
+public:
+    //Producer only
+    void post(LoxObject message);
+    //Consumer only. Waits for the next message, nullopt once the mailbox is closed and empty
+    std::optional<LoxObject> take();
+    //No more messages will be posted (or taken), wakes up the consumer
+    void close();
+
+private:
+    SpscQueue<LoxObject> queue;
+    std::atomic<bool> closed{false};
+    std::atomic<bool> consumerWaiting{false};
+    std::mutex mutex;
+    std::condition_variable messagePosted;
+};
+
+/*Isolates let a Lox program use several cores without sharing memory between threads. spawn(function, args...) creates an interpreter
+ * with its own heap on a new thread, copies into it the globals of the spawning interpreter, the function and the arguments (see
+ * ValueCopier.h) and calls the function there. It returns a handle:
+ *      handle.send(value)      copies value into the mailbox of the isolate, where receive() takes it
+ *      handle.receive()        waits for the next value the isolate passes to send(value)
+ *      handle.join()           waits for the function to return and returns a copy of its result
+ * A runtime error ends the isolate and is reported by handle.receive() and handle.join(). Values are always copied and never shared,
+ * so Environment and LoxObject stay single threaded. The handle can't be copied to another isolate, so each mailbox has one producer
+ * and one consumer thread.
+ * What the isolate prints is written to the output of its parent when the parent receives from it or joins it. When the last reference
+ * to the handle goes away the mailbox of the isolate is closed (receive() fails in the isolate) and the parent waits for it to finish.
+ * */
+class Isolate {
+public:
+    //Implements spawn(function, args...)
+    static LoxObject spawn(Interpreter &interpreter, const SharedCallablePtr &function, LoxArguments arguments);
+    ~Isolate();
+
+private:
+    //Output of the isolate, written by its thread and taken by its parent
+    class Output : public std::streambuf {
+    public:
+        std::string take();
+
+    protected:
+        int_type overflow(int_type ch) override;
+        std::streamsize xsputn(const char* s, std::streamsize count) override;
+
+    private:
+        std::mutex mutex;
+        std::string text;
+    };
+
+    Output output;
+    std::ostream outputStream{&output};
+    //Reset by the thread of the isolate when the function returns
+    std::unique_ptr<Interpreter> interpreter;
+    Environment::SharedPtr globalEnv;
+    Environment::SharedPtr parentGlobalEnv;
+    Mailbox inbox, outbox;
+    //Written by the isolate before it closes outbox
+    LoxObject result;
+    std::optional<std::string> error;
+    std::thread thread;
+
+    explicit Isolate(Interpreter &parent);
+    void run(SharedCallablePtr function, std::vector<LoxObject> arguments);
+    static LoxObject makeHandle(const std::shared_ptr<Isolate> &isolate);
+    //Called by the parent through the handle
+    void send(Interpreter &parent, const LoxObject &message);
+    LoxObject receive(Interpreter &parent);
+    LoxObject join(Interpreter &parent);
+    void forwardOutput(Interpreter &parent);
+};
+
+
+#endif //JLOX_ISOLATE_H
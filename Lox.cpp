@@ -0,0 +1,44 @@
+#include "Lox.h"
+#include <gsl/gsl_util>
+#include "Environment.h"
+#include "LoxError.h"
+#include "Token.h"
+
+
+Lox::Lox(std::ostream &output) : runner(output) {}
+
+Runner& Lox::getRunner() {
+    return runner;
+}
+
+Interpreter& Lox::getInterpreter() {
+    return runner.getInterpreter();
+}
+
+int Lox::run(const std::string &source) {
+    return runner.runSource(source);
+}
+
+std::optional<LoxObject> Lox::getGlobal(const std::string &name) {
+    GlobalEnvironment::Cell* cell = getInterpreter().globals.cell(name);
+    if (!cell->defined) return std::nullopt;
+    return cell->value;
+}
+
+void Lox::setGlobal(const std::string &name, const LoxObject &value) {
+    GlobalEnvironment::Cell* cell = getInterpreter().globals.cell(name);
+    cell->value = value;
+    cell->defined = true;
+}
+
+LoxObject Lox::callFunction(const std::string &name, std::vector<LoxObject> arguments) {
+    std::optional<LoxObject> callee = getGlobal(name);
+    if (!callee.has_value()){
+        throw LoxRuntimeError("Undefined variable '" + name + "'");
+    }
+
+    Interpreter &interpreter = getInterpreter();
+    //Whatever the function printed should be visible when the call returns, like at the end of run()
+    auto flush = gsl::finally([&interpreter] { interpreter.flushOutput(); });
+    return interpreter.call(callee.value(), arguments, Token(TokenType::IDENTIFIER, name, -1));
+}
@@ -0,0 +1,67 @@
+#ifndef JLOX_LOX_H
+#define JLOX_LOX_H
+
+#include <optional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Interpreter.h"
+#include "LoxObject.h"
+#include "Runner.h"
+#include "standardlib/NativeFunction.h"
+
+/*C++ embedding API of liblox: runs Lox code inside a host program without spawning jlox. Every Lox object is an independent
+ * interpreter with its own globals, natives and output, see Interpreter.h for the threading guarantees.
+ *
+ *      Lox lox;
+ *      lox.registerNative("twice", [](double x) { return 2 * x; });
+ *      lox.run("fun greet(name) { return \"hello \" + name; }");
+ *      LoxObject greeting = lox.call("greet", "world");
+ *
+ * The C API in LoxC.h is a thin layer on top of this class.
+ * */
+class Lox {
+public:
+    //Output of print statements and error messages goes to standard output
+    Lox() = default;
+    explicit Lox(std::ostream &output);
+
+    //Runner used by run(), its options (backend, AST cache, snapshot) can be changed before the first call to run()
+    Runner& getRunner();
+    Interpreter& getInterpreter();
+
+    //Runs source as a script. Returns the same exit codes as jlox (0, 65 for compile errors, 70 for runtime errors), errors are
+    //printed to the output. Declarations are kept, so code run later can use them.
+    int run(const std::string &source);
+
+    //Value of the global variable name, nothing if it isn't defined
+    std::optional<LoxObject> getGlobal(const std::string &name);
+    //Defines the global variable name, or overwrites it if it already exists
+    void setGlobal(const std::string &name, const LoxObject &value);
+
+    //Defines a global native function, the arguments and return value are converted as described in standardlib/NativeFunction.h
+    template<typename F>
+    void registerNative(const std::string &name, F function) {
+        setGlobal(name, LoxObject(standardFunctions::makeNative(name, std::move(function))));
+    }
+
+    /*Calls the global function (or class) name. Throws LoxRuntimeError if it isn't callable, if the number of arguments is wrong or
+     * if the call fails.*/
+    LoxObject callFunction(const std::string &name, std::vector<LoxObject> arguments);
+
+    //Same as callFunction, the arguments are native values converted like the return values of native functions
+    template<typename... Args>
+    LoxObject call(const std::string &name, Args&&... args) {
+        std::vector<LoxObject> arguments;
+        arguments.reserve(sizeof...(Args));
+        (arguments.push_back(standardFunctions::detail::toLox(std::forward<Args>(args))), ...);
+        return callFunction(name, std::move(arguments));
+    }
+
+private:
+    Runner runner;
+};
+
+
+#endif //JLOX_LOX_H
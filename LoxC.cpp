@@ -0,0 +1,236 @@
+#include "LoxC.h"
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Lox.h"
+#include "LoxCallable.h"
+#include "LoxError.h"
+
+namespace {
+    //Forwards the output of the interpreter to the host's callback. The interpreter already buffers it, see OutputWriter.h
+    class CallbackStreamBuffer : public std::streambuf {
+    public:
+        CallbackStreamBuffer(lox_write_fn write, void* userdata) : write(write), userdata(userdata) {}
+
+    protected:
+        int_type overflow(int_type ch) override {
+            if (!traits_type::eq_int_type(ch, traits_type::eof())){
+                char c = traits_type::to_char_type(ch);
+                write(&c, 1, userdata);
+            }
+            return traits_type::not_eof(ch);
+        }
+
+        std::streamsize xsputn(const char* s, std::streamsize count) override {
+            write(s, count, userdata);
+            return count;
+        }
+
+    private:
+        lox_write_fn write;
+        void* userdata;
+    };
+}
+
+struct lox_vm {
+    std::unique_ptr<CallbackStreamBuffer> outputBuffer;
+    std::unique_ptr<std::ostream> output;
+    std::unique_ptr<Lox> lox;
+    //Storage for the string of the last returned value
+    std::string returnedString;
+    std::string lastError;
+    std::optional<std::string> nativeError;
+};
+
+namespace {
+    LoxObject toLoxObject(const lox_value &value) {
+        switch (value.type) {
+            case LOX_NIL:
+                return LoxObject::Nil();
+            case LOX_BOOL:
+                return LoxObject(value.boolean != 0);
+            case LOX_NUMBER:
+                return LoxObject(value.number);
+            case LOX_STRING:
+                return LoxObject(std::string(value.string, value.length));
+            default:
+                throw LoxRuntimeError("Value can't be passed to Lox");
+        }
+    }
+
+    //Strings are copied into storage, the result points into it
+    lox_value toValue(const LoxObject &object, std::string &storage) {
+        lox_value value = lox_nil();
+        if (object.isBoolean()){
+            value = lox_bool(object.getBoolean());
+        } else if (object.isNumber()){
+            value = lox_number(object.getNumber());
+        } else if (object.isString()){
+            storage = object.getString();
+            value.type = LOX_STRING;
+            value.string = storage.c_str();
+            value.length = storage.size();
+        } else if (!object.isNil()){
+            value.type = LOX_OBJECT;
+        }
+        return value;
+    }
+
+    lox_value returnValue(lox_vm* vm, const LoxObject &object) {
+        return toValue(object, vm->returnedString);
+    }
+
+    class CNativeFunction : public LoxCallable {
+    public:
+        CNativeFunction(lox_vm* vm, std::string functionName, int functionArity, lox_native_fn function, void* userdata)
+            : LoxCallable(CallableType::FUNCTION), vm(vm), functionName(std::move(functionName)), functionArity(functionArity),
+              function(function), userdata(userdata) {}
+
+        LoxObject call(Interpreter &/*interpreter*/, LoxArguments arguments) override {
+            std::vector<std::string> strings(arguments.size());
+            std::vector<lox_value> args;
+            args.reserve(arguments.size());
+            for (size_t i = 0; i < arguments.size(); i++){
+                args.push_back(toValue(arguments[i], strings[i]));
+            }
+
+            vm->nativeError.reset();
+            lox_value result = function(vm, args.data(), (int) args.size(), userdata);
+            if (vm->nativeError.has_value()){
+                std::string message = std::move(vm->nativeError.value());
+                vm->nativeError.reset();
+                throw LoxRuntimeError(functionName + ": " + message);
+            }
+            return toLoxObject(result);
+        }
+
+        int arity() override {
+            return functionArity;
+        }
+
+        std::string to_string() override {
+            return "<native function " + functionName + ">";
+        }
+
+        std::string name() override {
+            return functionName;
+        }
+
+    private:
+        lox_vm* vm;
+        std::string functionName;
+        int functionArity;
+        lox_native_fn function;
+        void* userdata;
+    };
+}
+
+lox_vm* lox_new(void) {
+    auto* vm = new lox_vm();
+    vm->lox = std::make_unique<Lox>();
+    return vm;
+}
+
+lox_vm* lox_new_with_output(lox_write_fn write, void* userdata) {
+    auto* vm = new lox_vm();
+    vm->outputBuffer = std::make_unique<CallbackStreamBuffer>(write, userdata);
+    vm->output = std::make_unique<std::ostream>(vm->outputBuffer.get());
+    vm->lox = std::make_unique<Lox>(*vm->output);
+    return vm;
+}
+
+void lox_free(lox_vm* vm) {
+    delete vm;
+}
+
+int lox_run(lox_vm* vm, const char* source) {
+    try {
+        return vm->lox->run(source);
+    } catch (const std::exception &exception) {
+        vm->lastError = exception.what();
+        return 70;
+    }
+}
+
+int lox_get_global(lox_vm* vm, const char* name, lox_value* value) {
+    std::optional<LoxObject> global = vm->lox->getGlobal(name);
+    if (!global.has_value()) return 0;
+
+    *value = returnValue(vm, global.value());
+    return 1;
+}
+
+int lox_set_global(lox_vm* vm, const char* name, lox_value value) {
+    try {
+        vm->lox->setGlobal(name, toLoxObject(value));
+        return 1;
+    } catch (const LoxError &exception) {
+        vm->lastError = exception.what();
+        return 0;
+    }
+}
+
+int lox_call(lox_vm* vm, const char* name, const lox_value* args, int argc, lox_value* result) {
+    try {
+        std::vector<LoxObject> arguments;
+        arguments.reserve(argc);
+        for (int i = 0; i < argc; i++){
+            arguments.push_back(toLoxObject(args[i]));
+        }
+
+        LoxObject returned = vm->lox->callFunction(name, std::move(arguments));
+        if (result != nullptr){
+            *result = returnValue(vm, returned);
+        }
+        return 0;
+    } catch (const std::exception &exception) {
+        vm->lastError = exception.what();
+        return 70;
+    }
+}
+
+const char* lox_last_error(lox_vm* vm) {
+    return vm->lastError.c_str();
+}
+
+void lox_register_native(lox_vm* vm, const char* name, int arity, lox_native_fn function, void* userdata) {
+    vm->lox->setGlobal(name, LoxObject(std::make_shared<CNativeFunction>(vm, name, arity, function, userdata)));
+}
+
+void lox_native_error(lox_vm* vm, const char* message) {
+    vm->nativeError = message;
+}
+
+lox_value lox_nil(void) {
+    lox_value value;
+    std::memset(&value, 0, sizeof(value));
+    value.type = LOX_NIL;
+    return value;
+}
+
+lox_value lox_bool(int boolean) {
+    lox_value value = lox_nil();
+    value.type = LOX_BOOL;
+    value.boolean = boolean != 0;
+    return value;
+}
+
+lox_value lox_number(double number) {
+    lox_value value = lox_nil();
+    value.type = LOX_NUMBER;
+    value.number = number;
+    return value;
+}
+
+lox_value lox_string(const char* string) {
+    lox_value value = lox_nil();
+    value.type = LOX_STRING;
+    value.string = string;
+    value.length = std::strlen(string);
+    return value;
+}
@@ -0,0 +1,70 @@
+#ifndef JLOX_LOXC_H
+#define JLOX_LOXC_H
+
+#include <stddef.h>
+
+/*C embedding API of liblox, a thin layer over the Lox class (see Lox.h) for hosts that can't use the C++ API.
+ *
+ *      lox_vm* vm = lox_new();
+ *      lox_run(vm, "fun add(a, b) { return a + b; }");
+ *      lox_value args[2] = {lox_number(1), lox_number(2)}, result;
+ *      if (lox_call(vm, "add", args, 2, &result) == 0) printf("%g\n", result.number);
+ *      lox_free(vm);
+ *
+ * Only nil, booleans, numbers and strings can be passed in and out. Other values (functions, instances, lists) are reported with
+ * type LOX_OBJECT and can't be passed back. Strings returned by the API belong to the vm and stay valid until the next call on
+ * the same vm, strings received by a native function are only valid during the call.
+ * A vm must only be used by one thread at a time, different vms can be used concurrently.
+ * */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct lox_vm lox_vm;
+
+typedef enum {
+    LOX_NIL, LOX_BOOL, LOX_NUMBER, LOX_STRING, LOX_OBJECT
+} lox_type;
+
+typedef struct {
+    lox_type type;
+    int boolean;
+    double number;
+    const char* string;
+    size_t length; //of string, which is also null terminated
+} lox_value;
+
+//Receives the output of print statements and error messages
+typedef void (*lox_write_fn)(const char* data, size_t size, void* userdata);
+typedef lox_value (*lox_native_fn)(lox_vm* vm, const lox_value* args, int argc, void* userdata);
+
+//Output goes to standard output
+lox_vm* lox_new(void);
+lox_vm* lox_new_with_output(lox_write_fn write, void* userdata);
+void lox_free(lox_vm* vm);
+
+//Same exit codes as jlox: 0, 65 for compile errors, 70 for runtime errors. Errors are written to the output.
+int lox_run(lox_vm* vm, const char* source);
+//Returns 0 if name is not defined
+int lox_get_global(lox_vm* vm, const char* name, lox_value* value);
+//Returns 0 if value can't be converted (LOX_OBJECT)
+int lox_set_global(lox_vm* vm, const char* name, lox_value value);
+//Returns 0 and stores the return value in result (if it isn't NULL), or 70 if the call failed, see lox_last_error
+int lox_call(lox_vm* vm, const char* name, const lox_value* args, int argc, lox_value* result);
+//Message of the last failed lox_call, or of the last failed API call
+const char* lox_last_error(lox_vm* vm);
+
+//Defines a global native function. A native can fail with lox_native_error, its return value is ignored in that case.
+void lox_register_native(lox_vm* vm, const char* name, int arity, lox_native_fn function, void* userdata);
+void lox_native_error(lox_vm* vm, const char* message);
+
+lox_value lox_nil(void);
+lox_value lox_bool(int boolean);
+lox_value lox_number(double number);
+lox_value lox_string(const char* string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //JLOX_LOXC_H
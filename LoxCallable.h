@@ -3,11 +3,15 @@
 
 
 #include <string>
-#include <vector>
+#include <gsl/span>
 
 class LoxObject;
 class Interpreter;
 
+/*Arguments of a call. They live in the interpreter's ArgumentStack and are only valid during the call, the callee may move them
+ * (e.g. into its environment) instead of copying them.*/
+using LoxArguments = gsl::span<LoxObject>;
+
 
 class LoxCallable {
 public:
@@ -18,8 +22,10 @@ public:
     CallableType type;
 
     virtual ~LoxCallable() = default;
-    virtual LoxObject call(Interpreter &interpreter, const std::vector<LoxObject> &arguments) = 0;
+    virtual LoxObject call(Interpreter &interpreter, LoxArguments arguments) = 0;
+    //Number of arguments, or the minimum number of arguments if the callable is variadic
     virtual int arity() = 0;
+    virtual bool isVariadic() { return false; }
     virtual std::string to_string() = 0;
     virtual std::string name() = 0;
 
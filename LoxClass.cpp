@@ -1,7 +1,7 @@
 #include "LoxClass.h"
 #include <iostream>
 #include <utility>
-#include <sstream>
+#include <cstdio>
 #include <cassert>
 #include "LoxError.h"
 #include "LoxObject.h"
@@ -12,51 +12,50 @@
 class Interpreter;
 
 
-LoxClass::LoxClass(const std::string &name, const std::unordered_map<std::string, LoxObject> &methods, std::optional<SharedCallablePtr> superclass)
-    : LoxCallable(CallableType::CLASS), className(name), methods(methods), superclass(std::move(superclass)) {
+LoxClass::LoxClass(const std::string &name, const std::unordered_map<std::string, std::shared_ptr<LoxFunction>> &methods, std::optional<SharedCallablePtr> superclass)
+    : LoxCallable(CallableType::CLASS), className(name) {
+    setMethods(methods, std::move(superclass));
+}
+
+void LoxClass::setMethods(const std::unordered_map<std::string, std::shared_ptr<LoxFunction>> &methods, std::optional<SharedCallablePtr> superclass) {
+    this->superclass = std::move(superclass);
+    this->methods.clear();
     if (this->superclass.has_value()){
         assert(this->superclass.value()->type == CallableType::CLASS); //This should have been checked before by the interpreter
+        //The superclass' table is already flattened, so copying it brings in the methods of the whole hierarchy
+        this->methods = static_cast<LoxClass*>(this->superclass.value().get())->methods;
+    }
+
+    for (const auto &[key, method] : methods){
+        this->methods[key] = method; //overrides the inherited method, if any
     }
+
+    initializer = findMethod("init");
+    initializerArity = initializer ? initializer->arity() : 0;
 }
 
-LoxObject LoxClass::call(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+LoxObject LoxClass::call(Interpreter &interpreter, LoxArguments arguments) {
     SharedInstancePtr instance = std::make_shared<LoxClassInstance>(shared_from_this());
-    std::optional<LoxObject> constructor = findMethod("init");
-    if (constructor.has_value()){
-        LoxFunction *function = dynamic_cast<LoxFunction*>(constructor.value().getCallable().get());
-
-        //Create a new version of the constructor with "this" bound
-        LoxFunction *newFunction = function->bindThis(instance);
-        //call the constructor
-        newFunction->call(interpreter, arguments);
-        //Once we call the constructor we no longer need the newFunction so delete it before it leaks.
-        delete newFunction;
+    if (initializer){
+        //The new instance is passed directly as "this", no bound copy of the constructor is needed
+        initializer->call(interpreter, arguments, instance);
     }
 
     LoxObject instanceObj(instance);
     return instanceObj;
 }
 
-std::optional<LoxObject> LoxClass::findMethod(const std::string &key) {
-    if (methods.find(key) != methods.end()){
-        return methods[key];
-    }
-
-    if (superclass.has_value()){
-        LoxClass* loxClass = dynamic_cast<LoxClass*>(superclass.value().get());
-        return loxClass->findMethod(key);
+LoxFunction* LoxClass::findMethod(const std::string &key) {
+    auto it = methods.find(key);
+    if (it == methods.end()){
+        return nullptr;
     }
 
-    return std::nullopt;
+    return it->second.get();
 }
 
 int LoxClass::arity() {
-    std::optional<LoxObject> constructor = findMethod("init");
-    if (constructor.has_value()){
-        return constructor->getCallable()->arity();
-    }
-
-    return 0;
+    return initializerArity;
 }
 
 std::string LoxClass::to_string() {
@@ -71,16 +70,16 @@ std::string LoxClass::name() {
 LoxClassInstance::LoxClassInstance(std::shared_ptr<LoxClass> loxClass) : loxClass(std::move(loxClass)) {}
 
 LoxObject LoxClassInstance::getProperty(const Token &identifier) {
-    std::string key = identifier.lexeme;
-    if (fields.find(key) != fields.end()){
-        return fields[key];
+    const std::string &key = identifier.lexeme;
+    auto field = fields.find(key);
+    if (field != fields.end()){
+        return field->second;
     }
 
-    std::optional<LoxObject> method = loxClass->findMethod(key);
-    if (method.has_value()){
-        LoxFunction *function = dynamic_cast<LoxFunction*>(method.value().getCallable().get());
+    LoxFunction *method = loxClass->findMethod(key);
+    if (method){
         //Create a new function where the variable "this" is binded to this instance
-        SharedCallablePtr newFunction(function->bindThis(shared_from_this()));
+        SharedCallablePtr newFunction = method->bindThis(shared_from_this());
         LoxObject newFunctionObject(newFunction);
         return newFunctionObject;
     }
@@ -92,8 +91,26 @@ void LoxClassInstance::setProperty(const Token &identifier, const LoxObject &val
     fields[identifier.lexeme] = value;
 }
 
+const std::shared_ptr<LoxClass> &LoxClassInstance::getClass() const {
+    return loxClass;
+}
+
+const std::unordered_map<std::string, LoxObject> &LoxClassInstance::getFields() const {
+    return fields;
+}
+
+void LoxClassInstance::format(std::string &out) const {
+    char address[32];
+    std::snprintf(address, sizeof(address), "%p", static_cast<const void*>(this));
+    out += "<Instance of class ";
+    out += loxClass->className;
+    out += " at ";
+    out += address;
+    out += ">";
+}
+
 std::string LoxClassInstance::to_string() {
-    std::stringstream ss;
-    ss << "<Instance of class " << loxClass->name() << " at " << this << ">";
-    return ss.str();
+    std::string formatted;
+    format(formatted);
+    return formatted;
 }
@@ -9,6 +9,8 @@
 #include "LoxCallable.h"
 #include "LoxObject.h"
 class Interpreter;
+class LoxFunction;
+class LoxIterator;
 struct Token;
 
 class LoxClass : public LoxCallable, public std::enable_shared_from_this<LoxClass> {
@@ -22,12 +24,21 @@ public:
      * is used (LoxClass and not LoxFunction)
      * */
     std::optional<SharedCallablePtr> superclass;
-    std::unordered_map<std::string, LoxObject> methods;
+    /*Flattened method table: contains the methods declared by this class AND the ones inherited from its superclasses (copied down
+     * when the class is declared, overrides win), so finding a method is a single lookup no matter how deep the hierarchy is.*/
+    std::unordered_map<std::string, std::shared_ptr<LoxFunction>> methods;
     std::string className;
+    //"init" method and its arity, looked up once when the class is declared. initializer is nullptr if the class has no constructor.
+    LoxFunction* initializer = nullptr;
+    int initializerArity = 0;
 
-    explicit LoxClass(const std::string &name, const std::unordered_map<std::string, LoxObject> &methods, std::optional<SharedCallablePtr> superclass);
-    LoxObject call(Interpreter &interpreter, const std::vector<LoxObject> &arguments) override;
-    std::optional<LoxObject> findMethod(const std::string &key);
+    explicit LoxClass(const std::string &name, const std::unordered_map<std::string, std::shared_ptr<LoxFunction>> &methods, std::optional<SharedCallablePtr> superclass);
+    /*Fills the method table (see methods) and caches the initializer. Called by the constructor, and by Snapshot for classes that
+     * have to be created before their methods because the methods refer back to the class.*/
+    void setMethods(const std::unordered_map<std::string, std::shared_ptr<LoxFunction>> &methods, std::optional<SharedCallablePtr> superclass);
+    LoxObject call(Interpreter &interpreter, LoxArguments arguments) override;
+    //Returns nullptr if neither this class nor its superclasses have a method called key
+    LoxFunction* findMethod(const std::string &key);
     int arity() override;
     std::string to_string() override;
     std::string name() override;
@@ -37,9 +48,16 @@ public:
 class LoxClassInstance : public std::enable_shared_from_this<LoxClassInstance> {
 
 public:
+    //Native sequence behind the instance if it was made by LoxIterator::makeHandle (ranges, generators, iterators)
+    std::shared_ptr<LoxIterator> iterator;
+
     explicit LoxClassInstance(std::shared_ptr<LoxClass> loxClass);
     LoxObject getProperty(const Token &identifier);
     void setProperty(const Token &identifier, const LoxObject &value);
+    const std::shared_ptr<LoxClass>& getClass() const;
+    const std::unordered_map<std::string, LoxObject>& getFields() const;
+    //See LoxObject::format
+    void format(std::string &out) const;
     std::string to_string();
 
 private:
@@ -10,25 +10,39 @@
 #include "typedefs.h"
 #include "LoxClass.h"
 
-LoxFunction::LoxFunction(const FunctionDeclStmt *functionDeclStmt, Environment::SharedPtr closure, bool isConstructor)
-    : LoxCallable(CallableType::FUNCTION), functionDeclStmt(functionDeclStmt), closure(std::move(closure)), isConstructor(isConstructor) {}
+LoxFunction::LoxFunction(const FunctionDeclStmt *functionDeclStmt, Environment::SharedPtr closure, bool isConstructor,
+                         SharedCompiledBlock compiledBody, SharedInstancePtr receiver)
+    : LoxCallable(CallableType::FUNCTION), functionDeclStmt(functionDeclStmt), closure(std::move(closure)), isConstructor(isConstructor),
+    compiledBody(std::move(compiledBody)), receiver(std::move(receiver)) {}
 
 
-LoxObject LoxFunction::call(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+LoxObject LoxFunction::call(Interpreter &interpreter, LoxArguments arguments) {
+    return call(interpreter, arguments, receiver);
+}
+
+LoxObject LoxFunction::call(Interpreter &interpreter, LoxArguments arguments, const SharedInstancePtr &instance) {
     Environment::SharedPtr newEnv = std::make_shared<Environment>(closure);
+    if (instance){
+        newEnv->define("this", LoxObject(instance));
+    }
+
     assert(functionDeclStmt->params.size() == arguments.size()); //This should have already been checked by the interpreter
-    for (int i = 0; i < arguments.size(); i++){
-        newEnv->define(functionDeclStmt->params[i], arguments[i]);
+    for (size_t i = 0; i < arguments.size(); i++){
+        newEnv->define(functionDeclStmt->params[i], std::move(arguments[i]));
     }
 
     try {
-        interpreter.executeBlock(functionDeclStmt->body, newEnv);
+        if (compiledBody){
+            interpreter.executeBlock(*compiledBody, newEnv);
+        } else {
+            interpreter.executeBlock(functionDeclStmt->body, newEnv);
+        }
     } catch (const ReturnException &returnStmt) {
         /*NOTE: We're using exceptions as control flow here because it is the cleanest way to implement return given
         how the book implements the interpreter. This exception was thrown in the visitReturnStmt method of the interpreter*/
 
         //Constructor should always implicitly return "this".
-        if (isConstructor) return closure->getAt("this", 0);
+        if (isConstructor) return LoxObject(instance);
 
         return returnStmt.value;
     }
@@ -37,17 +51,14 @@ LoxObject LoxFunction::call(Interpreter &interpreter, const std::vector<LoxObjec
     if (isConstructor) {
         //Constructor should always implicitly return "this". This line covers the case where the constructor has no return stmt
         //but we still need to return "this".
-        return closure->getAt("this", 0);
+        return LoxObject(instance);
     }
 
     return LoxObject::Nil();
 }
 
-LoxFunction *LoxFunction::bindThis(SharedInstancePtr instance) {
-    Environment::SharedPtr newEnv = std::make_shared<Environment>(closure);
-    LoxObject instanceObj(std::move(instance));
-    newEnv->define("this", instanceObj);
-    return new LoxFunction(functionDeclStmt, newEnv, isConstructor);
+std::shared_ptr<LoxFunction> LoxFunction::bindThis(SharedInstancePtr instance) {
+    return std::make_shared<LoxFunction>(functionDeclStmt, closure, isConstructor, compiledBody, std::move(instance));
 }
 
 int LoxFunction::arity() {
@@ -63,16 +74,19 @@ std::string LoxFunction::name() {
 }
 
 
-LoxLambdaWrapper::LoxLambdaWrapper(const LambdaExpr *lambdaExpr, Environment::SharedPtr closure)
-    : LoxCallable(CallableType::FUNCTION), lambdaExpr(lambdaExpr), closure(std::move(closure)) {}
+LoxLambdaWrapper::LoxLambdaWrapper(const LambdaExpr *lambdaExpr, Environment::SharedPtr closure, SharedCompiledExpr compiledBody)
+    : LoxCallable(CallableType::FUNCTION), lambdaExpr(lambdaExpr), closure(std::move(closure)), compiledBody(std::move(compiledBody)) {}
 
-LoxObject LoxLambdaWrapper::call(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+LoxObject LoxLambdaWrapper::call(Interpreter &interpreter, LoxArguments arguments) {
     Environment::SharedPtr newEnv = std::make_shared<Environment>(closure);
     assert(lambdaExpr->params.size() == arguments.size()); //This should have already been checked by the interpreter
-    for (int i = 0; i < arguments.size(); i++){
-        newEnv->define(lambdaExpr->params[i], arguments[i]);
+    for (size_t i = 0; i < arguments.size(); i++){
+        newEnv->define(lambdaExpr->params[i], std::move(arguments[i]));
     }
 
+    if (compiledBody){
+        return interpreter.interpret(*compiledBody, newEnv);
+    }
 
     return interpreter.interpret(lambdaExpr->body.get(), newEnv);
 }
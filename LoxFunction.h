@@ -6,6 +6,7 @@
 #include "Environment.h"
 #include "LoxCallable.h"
 #include "LoxObject.h"
+#include "typedefs.h"
 
 class FunctionDeclStmt;
 class Interpreter;
@@ -18,11 +19,19 @@ public:
     const FunctionDeclStmt* functionDeclStmt;
     Environment::SharedPtr closure;
     bool isConstructor;
-
-    LoxFunction(const FunctionDeclStmt* functionDeclStmt, Environment::SharedPtr closure, bool isConstructor = false);
-    LoxObject call(Interpreter &interpreter, const std::vector<LoxObject> &arguments) override;
-    //Creates a NEW LoxFunction that is a copy of the current LoxFunction but with a different closure where "this" is binded to an instance;
-    LoxFunction* bindThis(SharedInstancePtr instance);
+    //Body produced by the ClosureCompiler. nullptr when the function was created by the tree walking interpreter.
+    SharedCompiledBlock compiledBody;
+    //Instance that "this" refers to when the function is a bound method, nullptr otherwise.
+    SharedInstancePtr receiver;
+
+    LoxFunction(const FunctionDeclStmt* functionDeclStmt, Environment::SharedPtr closure, bool isConstructor = false,
+                SharedCompiledBlock compiledBody = nullptr, SharedInstancePtr receiver = nullptr);
+    LoxObject call(Interpreter &interpreter, LoxArguments arguments) override;
+    /*Calls a method with "this" bound to receiver. "this" is defined in the same environment as the parameters, so calling a method
+     * (or a constructor from LoxClass::call) doesn't need a bound copy of the function nor an extra environment.*/
+    LoxObject call(Interpreter &interpreter, LoxArguments arguments, const SharedInstancePtr &instance);
+    //Creates a NEW LoxFunction that is a copy of the current LoxFunction but with "this" binded to an instance;
+    std::shared_ptr<LoxFunction> bindThis(SharedInstancePtr instance);
     int arity() override;
     std::string to_string() override;
     std::string name() override;
@@ -35,9 +44,11 @@ public:
 
     const LambdaExpr* lambdaExpr;
     Environment::SharedPtr closure;
+    //Body produced by the ClosureCompiler. nullptr when the lambda was created by the tree walking interpreter.
+    SharedCompiledExpr compiledBody;
 
-    LoxLambdaWrapper(const LambdaExpr* lambdaExpr, Environment::SharedPtr closure);
-    LoxObject call(Interpreter &interpreter, const std::vector<LoxObject> &arguments) override;
+    LoxLambdaWrapper(const LambdaExpr* lambdaExpr, Environment::SharedPtr closure, SharedCompiledExpr compiledBody = nullptr);
+    LoxObject call(Interpreter &interpreter, LoxArguments arguments) override;
     int arity() override;
     std::string to_string() override;
     std::string name() override;
@@ -0,0 +1,322 @@
+#include "LoxIterator.h"
+#include <cmath>
+#include <unordered_map>
+#include <utility>
+#include "ArgumentStack.h"
+#include "Interpreter.h"
+#include "LoxError.h"
+#include "LoxFunction.h"
+#include "Token.h"
+#include "standardlib/NativeFunction.h"
+
+namespace {
+    //Numbers are computed from the index, so a fractional step doesn't accumulate rounding errors
+    class Range : public LoxIterator {
+    public:
+        Range(double start, double step, double count) : start(start), step(step), count(count) {}
+
+        std::shared_ptr<LoxIterator> iterate() override {
+            return std::make_shared<Range>(start, step, count);
+        }
+
+    protected:
+        bool produce(Interpreter &, LoxObject &item) override {
+            if (index >= count) return false;
+            item = LoxObject(start + index * step);
+            index++;
+            return true;
+        }
+
+    private:
+        double start, step, count, index = 0;
+    };
+
+    //Instances of Lox classes that implement done() and next() themselves
+    class MethodIterator : public LoxIterator {
+    public:
+        MethodIterator(SharedInstancePtr instance, int line)
+                : instance(std::move(instance)), doneToken(TokenType::IDENTIFIER, "done", line), nextToken(TokenType::IDENTIFIER, "next", line) {}
+
+    protected:
+        bool produce(Interpreter &interpreter, LoxObject &item) override {
+            if (interpreter.call(instance->getProperty(doneToken), {}, doneToken).truthy()) return false;
+            item = interpreter.call(instance->getProperty(nextToken), {}, nextToken);
+            return true;
+        }
+
+    private:
+        SharedInstancePtr instance;
+        Token doneToken, nextToken;
+    };
+
+    class ListIterator : public LoxIterator {
+    public:
+        explicit ListIterator(SharedListPtr list) : list(std::move(list)) {}
+
+    protected:
+        bool produce(Interpreter &, LoxObject &item) override {
+            const std::vector<LoxObject> &items = list->getItems();
+            if (index >= items.size()) return false;
+            item = items[index++];
+            return true;
+        }
+
+    private:
+        SharedListPtr list;
+        size_t index = 0;
+    };
+
+    /*Calls function directly instead of going through Interpreter::call, the steps check the arity once when they are created.
+     * The arguments go in the ArgumentStack like the ones of any call, so calling a lambda for every item doesn't allocate.*/
+    template<typename... Args>
+    LoxObject callFunction(Interpreter &interpreter, LoxCallable &function, Args&&... args) {
+        ArgumentStack::Frame frame(interpreter.argumentStack, sizeof...(Args));
+        size_t i = 0;
+        ((frame.arguments[i++] = std::forward<Args>(args)), ...);
+        return function.call(interpreter, frame.arguments);
+    }
+
+    void checkArity(LoxCallable &function, int count, const std::string &method) {
+        int arity = function.arity();
+        if (arity != count && !(function.isVariadic() && arity < count)){
+            throw LoxRuntimeError("The function passed to " + method + "() must take " + std::to_string(count) + " argument(s), "
+                                  + function.name() + " takes " + std::to_string(arity));
+        }
+    }
+
+    size_t checkCount(double count, const std::string &method) {
+        if (count < 0 || count != std::floor(count)){
+            throw LoxRuntimeError("The argument of " + method + "() must be a non negative integer");
+        }
+        return static_cast<size_t>(count);
+    }
+
+    class MapIterator : public LoxIterator {
+    public:
+        MapIterator(std::shared_ptr<LoxIterator> source, SharedCallablePtr function) : source(std::move(source)), function(std::move(function)) {}
+
+    protected:
+        bool produce(Interpreter &interpreter, LoxObject &item) override {
+            if (!source->next(interpreter, item)) return false;
+            item = callFunction(interpreter, *function, std::move(item));
+            return true;
+        }
+
+    private:
+        std::shared_ptr<LoxIterator> source;
+        SharedCallablePtr function;
+    };
+
+    class FilterIterator : public LoxIterator {
+    public:
+        FilterIterator(std::shared_ptr<LoxIterator> source, SharedCallablePtr function) : source(std::move(source)), function(std::move(function)) {}
+
+    protected:
+        bool produce(Interpreter &interpreter, LoxObject &item) override {
+            while (source->next(interpreter, item)){
+                if (callFunction(interpreter, *function, item).truthy()) return true;
+            }
+            return false;
+        }
+
+    private:
+        std::shared_ptr<LoxIterator> source;
+        SharedCallablePtr function;
+    };
+
+    //Stops without asking the source for more than count items, so it also works on endless generators
+    class TakeIterator : public LoxIterator {
+    public:
+        TakeIterator(std::shared_ptr<LoxIterator> source, size_t count) : source(std::move(source)), remaining(count) {}
+
+    protected:
+        bool produce(Interpreter &interpreter, LoxObject &item) override {
+            if (remaining == 0 || !source->next(interpreter, item)) return false;
+            remaining--;
+            return true;
+        }
+
+    private:
+        std::shared_ptr<LoxIterator> source;
+        size_t remaining;
+    };
+
+    class SkipIterator : public LoxIterator {
+    public:
+        SkipIterator(std::shared_ptr<LoxIterator> source, size_t count) : source(std::move(source)), remaining(count) {}
+
+    protected:
+        bool produce(Interpreter &interpreter, LoxObject &item) override {
+            for (; remaining > 0; remaining--){
+                if (!source->next(interpreter, item)) return false;
+            }
+            return source->next(interpreter, item);
+        }
+
+    private:
+        std::shared_ptr<LoxIterator> source;
+        size_t remaining;
+    };
+
+    class ZipIterator : public LoxIterator {
+    public:
+        ZipIterator(std::shared_ptr<LoxIterator> first, std::shared_ptr<LoxIterator> second) : first(std::move(first)), second(std::move(second)) {}
+
+    protected:
+        bool produce(Interpreter &interpreter, LoxObject &item) override {
+            LoxObject other;
+            if (!first->next(interpreter, item) || !second->next(interpreter, other)) return false;
+            item = LoxObject(std::make_shared<LoxList>(nullptr, std::vector<LoxObject>{std::move(item), std::move(other)}));
+            return true;
+        }
+
+    private:
+        std::shared_ptr<LoxIterator> first, second;
+    };
+
+    class EnumerateIterator : public LoxIterator {
+    public:
+        explicit EnumerateIterator(std::shared_ptr<LoxIterator> source) : source(std::move(source)) {}
+
+    protected:
+        bool produce(Interpreter &interpreter, LoxObject &item) override {
+            if (!source->next(interpreter, item)) return false;
+            item = LoxObject(std::make_shared<LoxList>(nullptr, std::vector<LoxObject>{LoxObject(index++), std::move(item)}));
+            return true;
+        }
+
+    private:
+        std::shared_ptr<LoxIterator> source;
+        double index = 0;
+    };
+
+    LoxObject makeStep(const std::shared_ptr<LoxIterator> &step) {
+        return LoxIterator::makeHandle(step, "Iterator");
+    }
+
+    bool hasMethod(const SharedInstancePtr &instance, const std::string &name) {
+        return instance->getFields().count(name) != 0 || instance->getClass()->findMethod(name) != nullptr;
+    }
+}
+
+
+bool LoxIterator::next(Interpreter &interpreter, LoxObject &item) {
+    if (ahead.has_value()){
+        item = std::move(ahead.value());
+        ahead.reset();
+        return true;
+    }
+    return produce(interpreter, item);
+}
+
+bool LoxIterator::done(Interpreter &interpreter) {
+    if (ahead.has_value()) return false;
+
+    LoxObject item;
+    if (!produce(interpreter, item)) return true;
+    ahead = std::move(item);
+    return false;
+}
+
+std::shared_ptr<LoxIterator> LoxIterator::iterate() {
+    return shared_from_this();
+}
+
+LoxObject LoxIterator::makeHandle(const std::shared_ptr<LoxIterator> &iterator, const std::string &className) {
+    using standardFunctions::makeNative;
+    auto loxClass = std::make_shared<LoxClass>(className, std::unordered_map<std::string, std::shared_ptr<LoxFunction>>(), std::nullopt);
+    auto handle = std::make_shared<LoxClassInstance>(loxClass);
+    handle->iterator = iterator;
+    auto method = [&handle](const std::string &name, SharedCallablePtr native) {
+        handle->setProperty(Token(TokenType::IDENTIFIER, name, -1), LoxObject(std::move(native)));
+    };
+
+    method("next", makeNative("next", [iterator](Interpreter &interpreter) {
+        LoxObject item;
+        return iterator->next(interpreter, item) ? item : LoxObject();
+    }));
+    method("done", makeNative("done", [iterator](Interpreter &interpreter) {
+        return iterator->done(interpreter);
+    }));
+
+    method("map", makeNative("map", [iterator](const SharedCallablePtr &function) {
+        checkArity(*function, 1, "map");
+        return makeStep(std::make_shared<MapIterator>(iterator->iterate(), function));
+    }));
+    method("filter", makeNative("filter", [iterator](const SharedCallablePtr &function) {
+        checkArity(*function, 1, "filter");
+        return makeStep(std::make_shared<FilterIterator>(iterator->iterate(), function));
+    }));
+    method("take", makeNative("take", [iterator](double count) {
+        return makeStep(std::make_shared<TakeIterator>(iterator->iterate(), checkCount(count, "take")));
+    }));
+    method("skip", makeNative("skip", [iterator](double count) {
+        return makeStep(std::make_shared<SkipIterator>(iterator->iterate(), checkCount(count, "skip")));
+    }));
+    method("zip", makeNative("zip", [iterator](const LoxObject &other) {
+        return makeStep(std::make_shared<ZipIterator>(iterator->iterate(), of(other, -1)));
+    }));
+    method("enumerate", makeNative("enumerate", [iterator]() {
+        return makeStep(std::make_shared<EnumerateIterator>(iterator->iterate()));
+    }));
+
+    method("reduce", makeNative("reduce", [iterator](Interpreter &interpreter, const SharedCallablePtr &function, const LoxObject &initial) {
+        checkArity(*function, 2, "reduce");
+        std::shared_ptr<LoxIterator> source = iterator->iterate();
+        LoxObject result = initial, item;
+        while (source->next(interpreter, item)){
+            result = callFunction(interpreter, *function, std::move(result), std::move(item));
+        }
+        return result;
+    }));
+    method("collect", makeNative("collect", [iterator](Interpreter &interpreter) {
+        std::shared_ptr<LoxIterator> source = iterator->iterate();
+        std::vector<LoxObject> items;
+        LoxObject item;
+        while (source->next(interpreter, item)){
+            items.push_back(std::move(item));
+        }
+        return LoxObject(std::make_shared<LoxList>(nullptr, items));
+    }));
+    return LoxObject(handle);
+}
+
+LoxObject LoxIterator::range(double first, LoxArguments rest) {
+    if (rest.size() > 2){
+        throw LoxRuntimeError("range() takes at most 3 arguments, got " + std::to_string(rest.size() + 1));
+    }
+    for (const LoxObject &argument : rest){
+        if (!argument.isNumber()) throw LoxRuntimeError("The arguments of range() must be numbers");
+    }
+
+    double start = rest.empty() ? 0 : first;
+    double end = rest.empty() ? first : rest[0].getNumber();
+    double step = rest.size() == 2 ? rest[1].getNumber() : 1;
+    if (step == 0){
+        throw LoxRuntimeError("The step of range() can't be 0");
+    }
+
+    double count = std::max(0.0, std::ceil((end - start) / step));
+    return makeHandle(std::make_shared<Range>(start, step, count), "Range");
+}
+
+LoxObject LoxIterator::iter(const LoxObject &iterable) {
+    return makeHandle(of(iterable, -1), "Iterator");
+}
+
+std::shared_ptr<LoxIterator> LoxIterator::of(const LoxObject &iterable, int line) {
+    if (iterable.isList()){
+        return std::make_shared<ListIterator>(iterable.getList());
+    }
+    if (iterable.isClassInstance()){
+        const SharedInstancePtr &instance = iterable.getClassInstance();
+        if (instance->iterator){
+            return instance->iterator->iterate();
+        }
+        if (hasMethod(instance, "done") && hasMethod(instance, "next")){
+            return std::make_shared<MethodIterator>(instance, line);
+        }
+    }
+    throw LoxRuntimeError("Can only iterate over lists, ranges, generators, iterators and instances with done() and next() methods, got "
+                          + loxTypeToString(iterable.type), line);
+}
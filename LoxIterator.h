@@ -0,0 +1,86 @@
+#ifndef JLOX_LOXITERATOR_H
+#define JLOX_LOXITERATOR_H
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "LoxCallable.h"
+#include "LoxClass.h"
+#include "LoxList.h"
+#include "LoxObject.h"
+
+class Interpreter;
+
+/*Lazy sequence of values produced one at a time by native code, e.g. range(), generators, iter(). Lox sees it as an instance (see
+ * makeHandle) with these methods:
+ *      next()              the next item, nil once there are no more
+ *      done()              true once there are no more items (produces the next one ahead of time if needed)
+ *      map(fn)             iterator over fn(item)
+ *      filter(fn)          iterator over the items for which fn(item) is truthy
+ *      take(n)             iterator over the first n items
+ *      skip(n)             iterator over the items after the first n
+ *      zip(iterable)       iterator over [item, other] pairs, stops at the end of the shorter one
+ *      enumerate()         iterator over [index, item] pairs
+ *      reduce(fn, initial) fn(...fn(fn(initial, item1), item2)..., itemN)
+ *      collect()           list of the remaining items
+ * The combinators don't compute anything, they return an iterator that pulls from this one. A whole pipeline like
+ * iter(list).map(f).filter(g).take(10).collect() runs in a single pass when the last step asks for items, every item goes through all the
+ * steps before the next one is produced, and no intermediate list is built. A step consumes the iterator it was created on (a range starts
+ * over, see iterate()), so a pipeline can only run once.
+ * for-in loops (see forEach) take the items straight from the iterator behind the instance, without calling the methods.
+ * */
+class LoxIterator : public std::enable_shared_from_this<LoxIterator> {
+public:
+    virtual ~LoxIterator() = default;
+
+    //Stores the next item in item, returns false once there are no more
+    bool next(Interpreter &interpreter, LoxObject &item);
+    bool done(Interpreter &interpreter);
+    //Iterator a for-in loop runs on. By default the loop consumes this one, a range starts over every time
+    virtual std::shared_ptr<LoxIterator> iterate();
+
+    //Instance of a class called className whose next() and done() methods are backed by iterator
+    static LoxObject makeHandle(const std::shared_ptr<LoxIterator> &iterator, const std::string &className);
+    //Implements range(end), range(start, end) and range(start, end, step)
+    static LoxObject range(double first, LoxArguments rest);
+    //Implements iter(iterable): an iterator over anything a for-in loop accepts
+    static LoxObject iter(const LoxObject &iterable);
+
+    /*Calls body(item) for every item of iterable until body returns false. Lists are iterated over their storage, handles made by
+     * makeHandle over their native iterator, and any other instance through its done() and next() methods. Anything else is a runtime
+     * error reported on line.*/
+    template<typename Body>
+    static void forEach(Interpreter &interpreter, const LoxObject &iterable, int line, Body &&body);
+
+protected:
+    //Same as next, without the item done() may have produced ahead
+    virtual bool produce(Interpreter &interpreter, LoxObject &item) = 0;
+
+private:
+    std::optional<LoxObject> ahead;
+
+    //Iterator for anything forEach accepts, reported on line
+    static std::shared_ptr<LoxIterator> of(const LoxObject &iterable, int line);
+};
+
+template<typename Body>
+void LoxIterator::forEach(Interpreter &interpreter, const LoxObject &iterable, int line, Body &&body) {
+    if (iterable.isList()){
+        SharedListPtr list = iterable.getList();
+        const std::vector<LoxObject> &items = list->getItems();
+        for (size_t i = 0; i < items.size(); i++){
+            if (!body(items[i])) return;
+        }
+        return;
+    }
+
+    std::shared_ptr<LoxIterator> iterator = of(iterable, line);
+    LoxObject item;
+    while (iterator->next(interpreter, item)){
+        if (!body(item)) return;
+    }
+}
+
+
+#endif //JLOX_LOXITERATOR_H
@@ -1,4 +1,3 @@
-#include <sstream>
 #include "LoxList.h"
 #include "LoxObject.h"
 #include "Expr.h"
@@ -28,18 +27,29 @@ LoxObject LoxList::remove(int index) {
 
 void LoxList::assertBounds(int index) {
     if (index < 0 || index >= length()){
-        throw LoxRuntimeError("List index out of range", listDeclarationExpr->openingBracket.line);
+        throw LoxRuntimeError("List index out of range", listDeclarationExpr ? listDeclarationExpr->openingBracket.line : -1);
     }
 }
 
-std::string LoxList::to_string() {
-    std::stringstream ss;
-    ss << "[";
-    for (int i = 0; i < length(); i++){
-        ss << items[i];
-        if (i != length() - 1) ss << ", ";
+const std::vector<LoxObject> &LoxList::getItems() const {
+    return items;
+}
+
+const ListExpr *LoxList::getDeclaration() const {
+    return listDeclarationExpr;
+}
+
+void LoxList::format(std::string &out) const {
+    out += "[";
+    for (size_t i = 0; i < items.size(); i++){
+        if (i != 0) out += ", ";
+        items[i].format(out);
     }
-    ss << "]";
+    out += "]";
+}
 
-    return ss.str();
+std::string LoxList::to_string() {
+    std::string formatted;
+    format(formatted);
+    return formatted;
 }
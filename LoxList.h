@@ -1,6 +1,7 @@
 #ifndef JLOX_LOXLIST_H
 #define JLOX_LOXLIST_H
 
+#include <string>
 #include <vector>
 
 class ListExpr;
@@ -15,6 +16,10 @@ public:
     void append(const LoxObject &val);
     LoxObject at(int index);
     LoxObject remove(int index);
+    const std::vector<LoxObject>& getItems() const;
+    const ListExpr* getDeclaration() const;
+    //See LoxObject::format
+    void format(std::string &out) const;
     std::string to_string();
 
 
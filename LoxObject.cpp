@@ -1,18 +1,24 @@
 #include "LoxObject.h"
+#include <algorithm>
+#include <charconv>
 #include <cmath>
+#include <limits>
+#include <ostream>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 #include "LoxCallable.h"
 #include "LoxClass.h"
 #include "LoxList.h"
 #include "Token.h"
 #include "TokenType.h"
-#include "tools/Utils.h"
 
 LoxObject::LoxObject(double number) : type(LoxType::NUMBER), number(number) {}
 
 LoxObject::LoxObject(const std::string &string) : type(LoxType::STRING), str(string) {}
 
+LoxObject::LoxObject(std::string &&string) : type(LoxType::STRING), str(std::move(string)) {}
+
 LoxObject::LoxObject(const char *string) : LoxObject(std::string(string)) {}
 
 LoxObject::LoxObject(bool boolean) : type(LoxType::BOOL), boolean(boolean) {}
@@ -29,10 +35,20 @@ LoxObject::LoxObject(SharedListPtr list) : type(LoxType::LIST), list(std::move(l
 
 LoxObject::LoxObject(const Token &token) {
     switch (token.type) {
-        case NUMBER:
+        case NUMBER: {
             type = LoxType::NUMBER;
-            number = std::stod(token.lexeme);
+            //The scanner only produces well formed numbers. Unlike std::stod, from_chars doesn't depend on the locale
+            const char* first = token.lexeme.data();
+            const char* last = first + token.lexeme.size();
+            if (std::from_chars(first, last, number).ec == std::errc::result_out_of_range){
+                /*from_chars leaves number untouched if the literal doesn't fit a double. Literals have no sign or exponent, so it is either
+                 * too big (inf, like strtod) or so small that the closest double is 0*/
+                const char* point = std::find(first, last, '.');
+                bool tooBig = std::find_if(first, point, [](char digit) { return digit != '0'; }) != point;
+                number = tooBig ? std::numeric_limits<double>::infinity() : 0.0;
+            }
             break;
+        }
         case TRUE:
             type = LoxType::BOOL;
             boolean = true;
@@ -267,38 +283,82 @@ LoxObject LoxObject::operator--() {
     throw std::runtime_error("Cannot apply prefix operator '--' to operand of type " + loxTypeToString(this->type));
 }
 
+namespace {
+    //Integers up to this magnitude are printed without decimal part or exponent, every one of them is exactly representable by a double
+    constexpr double MAX_EXACT_INTEGER = 9007199254740992.0; //2^53
+
+    //String forms of the small non negative integers, they are by far the most printed numbers (counters, indices, ids)
+    constexpr int CACHED_INTEGERS = 1024;
+
+    const std::string& smallIntegerString(int n) {
+        static const std::vector<std::string> cache = [] {
+            std::vector<std::string> strings;
+            strings.reserve(CACHED_INTEGERS);
+            for (int i = 0; i < CACHED_INTEGERS; i++){
+                strings.push_back(std::to_string(i));
+            }
+            return strings;
+        }();
+
+        return cache[n];
+    }
+
+    /*Numbers with no decimal part are printed as integers. Everything else uses the shortest representation that parses back
+     * to the same double (2.5 instead of 2.500000, 0.1 instead of 0.100000), which is what std::to_chars produces without a precision.*/
+    void formatNumber(double number, std::string &out) {
+        char buffer[64];
+        char* end;
+        if (std::floor(number) == number && std::abs(number) <= MAX_EXACT_INTEGER){
+            if (number >= 0 && number < CACHED_INTEGERS){
+                out += smallIntegerString((int) number);
+                return;
+            }
+            end = std::to_chars(buffer, buffer + sizeof(buffer), (long long) number).ptr;
+        } else {
+            end = std::to_chars(buffer, buffer + sizeof(buffer), number).ptr;
+        }
+
+        out.append(buffer, end);
+    }
+}
+
 std::ostream &operator<<(std::ostream &os, const LoxObject &object) {
-    switch (object.type) {
+    std::string formatted;
+    object.format(formatted);
+    return os << formatted;
+}
+
+void LoxObject::format(std::string &out) const {
+    switch (type) {
         case LoxType::NIL:
-            os << std::string("nil");
-            return os;
+            out += "nil";
+            return;
         case LoxType::BOOL:
-            os << (object.getBoolean() ? std::string("true") : std::string("false"));
-            return os;
+            out += boolean ? "true" : "false";
+            return;
         case LoxType::NUMBER:
-            if (std::abs(floor(object.getNumber())) == std::abs(object.getNumber())){ //If it has no decimal part
-                os << std::to_string((long long) object.getNumber());
-            } else {
-                os << std::to_string(object.getNumber());
-            }
-            return os;
+            formatNumber(number, out);
+            return;
         case LoxType::STRING:
-            {
-            std::string s = object.getString();
-            utils::replaceAll(s, "\\n", "\n");
-            utils::replaceAll(s, "\\t", "\t");
-            os << s;
-            return os;
+            //Translate the "\n" and "\t" escape sequences while copying
+            for (size_t i = 0; i < str.size(); i++){
+                if (str[i] == '\\' && i + 1 < str.size() && (str[i + 1] == 'n' || str[i + 1] == 't')){
+                    out += str[i + 1] == 'n' ? '\n' : '\t';
+                    i++;
+                } else {
+                    out += str[i];
+                }
             }
+            return;
         case LoxType::CALLABLE:
-            os << object.getCallable()->to_string();
-            return os;
+            out += callable->to_string();
+            return;
         case LoxType::INSTANCE:
-            os << object.getClassInstance()->to_string();
-            return os;
+            instance->format(out);
+            return;
         case LoxType::LIST:
-            os << object.getList()->to_string();
-            return os;
+            list->format(out);
+            return;
         default:
             throw std::runtime_error("Object has no string representation");
     }
@@ -36,6 +36,7 @@ public:
     explicit LoxObject(const Token &token);
     explicit LoxObject(double number);
     explicit LoxObject(const std::string &string);
+    explicit LoxObject(std::string &&string);
     explicit LoxObject(const char* string);
     explicit LoxObject(bool boolean);
     explicit LoxObject(SharedCallablePtr callable);
@@ -65,6 +66,10 @@ public:
     SharedListPtr getList() const;
 
 
+    /*Appends the printable representation of the object to out. Lists and instances are written element by element straight into out,
+     * so formatting a big (or deeply nested) list doesn't build a temporary string per element. Used by print, str() and operator<<.*/
+    void format(std::string &out) const;
+
     friend std::ostream& operator<<(std::ostream& os, const LoxObject& object);
     friend LoxObject operator+(const LoxObject &lhs, const LoxObject &rhs);
     friend LoxObject operator-(const LoxObject &lhs, const LoxObject &rhs);
@@ -0,0 +1,223 @@
+#include "Memoize.h"
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include "LoxClass.h"
+#include "LoxError.h"
+#include "LoxFunction.h"
+#include "Token.h"
+
+namespace {
+    constexpr size_t INITIAL_SLOTS = 16;
+
+    size_t combine(size_t seed, size_t value) {
+        return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+    }
+
+    //Consistent with operator==: equal values have equal hashes
+    size_t hashValue(const LoxObject &value) {
+        switch (value.type) {
+            case LoxType::NUMBER:
+                //0 and -0 are equal
+                return value.getNumber() == 0 ? 0 : std::hash<double>()(value.getNumber());
+            case LoxType::STRING:
+                return std::hash<std::string>()(value.getString());
+            case LoxType::BOOL:
+                return value.getBoolean() ? 1 : 2;
+            case LoxType::CALLABLE:
+                return std::hash<const void*>()(value.getCallable().get());
+            case LoxType::INSTANCE:
+                return std::hash<const void*>()(value.getClassInstance().get());
+            case LoxType::LIST:
+                return std::hash<const void*>()(value.getList().get());
+            default:
+                return 3;
+        }
+    }
+}
+
+
+LoxObject MemoizedFunction::create(const SharedCallablePtr &function, LoxArguments rest) {
+    if (rest.size() > 1){
+        throw LoxRuntimeError("memoize() takes at most 2 arguments, got " + std::to_string(rest.size() + 1));
+    }
+    size_t capacity = 0;
+    if (!rest.empty()){
+        const LoxObject &argument = rest[0];
+        if (!argument.isNumber() || argument.getNumber() < 1 || argument.getNumber() != std::floor(argument.getNumber())
+                || argument.getNumber() >= NONE){
+            throw LoxRuntimeError("The capacity of memoize() must be a positive integer");
+        }
+        capacity = static_cast<size_t>(argument.getNumber());
+    }
+    return LoxObject(std::static_pointer_cast<LoxCallable>(std::make_shared<MemoizedFunction>(function, capacity)));
+}
+
+LoxObject MemoizedFunction::stats(const SharedCallablePtr &memoized) {
+    auto* cache = dynamic_cast<MemoizedFunction*>(memoized.get());
+    if (cache == nullptr){
+        throw LoxRuntimeError("memo_stats() expects a function returned by memoize(), got " + memoized->to_string());
+    }
+
+    auto loxClass = std::make_shared<LoxClass>("MemoStats", std::unordered_map<std::string, std::shared_ptr<LoxFunction>>(), std::nullopt);
+    auto instance = std::make_shared<LoxClassInstance>(loxClass);
+    auto field = [&instance](const std::string &name, const LoxObject &value) {
+        instance->setProperty(Token(TokenType::IDENTIFIER, name, -1), value);
+    };
+    field("hits", LoxObject(static_cast<double>(cache->hits)));
+    field("misses", LoxObject(static_cast<double>(cache->misses)));
+    field("evictions", LoxObject(static_cast<double>(cache->evictions)));
+    field("size", LoxObject(static_cast<double>(cache->entries.size())));
+    field("capacity", cache->capacity == 0 ? LoxObject() : LoxObject(static_cast<double>(cache->capacity)));
+    return LoxObject(instance);
+}
+
+MemoizedFunction::MemoizedFunction(SharedCallablePtr function, size_t capacity)
+    : LoxCallable(CallableType::FUNCTION), function(std::move(function)), capacity(capacity) {}
+
+LoxObject MemoizedFunction::call(Interpreter &interpreter, LoxArguments arguments) {
+    if (!cacheable(arguments)){
+        misses++;
+        return function->call(interpreter, arguments);
+    }
+
+    size_t hash = hashOf(arguments);
+    size_t slot = find(arguments, hash);
+    if (slot != NONE){
+        hits++;
+        uint32_t index = slots[slot];
+        if (capacity != 0 && index != newest){
+            unlink(index);
+            link(index);
+        }
+        return entries[index].value;
+    }
+
+    misses++;
+    //The callee may move the arguments, and its recursive calls may reshape the table, so nothing is kept across the call but the key
+    std::vector<LoxObject> key(arguments.begin(), arguments.end());
+    LoxObject value = function->call(interpreter, arguments);
+    insert(std::move(key), hash, value);
+    return value;
+}
+
+int MemoizedFunction::arity() {
+    return function->arity();
+}
+
+bool MemoizedFunction::isVariadic() {
+    return function->isVariadic();
+}
+
+std::string MemoizedFunction::to_string() {
+    return "<memoized " + function->to_string() + ">";
+}
+
+std::string MemoizedFunction::name() {
+    return function->name();
+}
+
+bool MemoizedFunction::cacheable(LoxArguments arguments) {
+    for (const LoxObject &argument : arguments){
+        if (argument.isNumber() && std::isnan(argument.getNumber())) return false;
+    }
+    return true;
+}
+
+size_t MemoizedFunction::hashOf(LoxArguments arguments) {
+    size_t hash = arguments.size();
+    for (const LoxObject &argument : arguments){
+        hash = combine(hash, combine(static_cast<size_t>(argument.type), hashValue(argument)));
+    }
+    return hash;
+}
+
+size_t MemoizedFunction::find(LoxArguments arguments, size_t hash) const {
+    if (slots.empty()) return NONE;
+
+    size_t mask = slots.size() - 1;
+    for (size_t slot = hash & mask; slots[slot] != NONE; slot = (slot + 1) & mask){
+        const Entry &entry = entries[slots[slot]];
+        if (entry.hash != hash || entry.key.size() != arguments.size()) continue;
+        bool same = true;
+        for (size_t i = 0; i < arguments.size() && same; i++){
+            same = entry.key[i] == arguments[i];
+        }
+        if (same) return slot;
+    }
+    return NONE;
+}
+
+void MemoizedFunction::insert(std::vector<LoxObject> key, size_t hash, const LoxObject &value) {
+    //A recursive call with the same arguments may have stored a result already
+    size_t existing = find(key, hash);
+    if (existing != NONE){
+        entries[slots[existing]].value = value;
+        return;
+    }
+
+    uint32_t index;
+    if (capacity != 0 && entries.size() == capacity){
+        //Full, the least recently used entry makes room
+        index = oldest;
+        size_t mask = slots.size() - 1;
+        size_t slot = entries[index].hash & mask;
+        while (slots[slot] != index) slot = (slot + 1) & mask;
+        removeSlot(slot);
+        unlink(index);
+        evictions++;
+        entries[index] = Entry{std::move(key), hash, value, NONE, NONE};
+    } else {
+        if ((entries.size() + 1) * 2 > slots.size()) grow();
+        index = static_cast<uint32_t>(entries.size());
+        entries.push_back(Entry{std::move(key), hash, value, NONE, NONE});
+    }
+
+    size_t mask = slots.size() - 1;
+    size_t slot = hash & mask;
+    while (slots[slot] != NONE) slot = (slot + 1) & mask;
+    slots[slot] = index;
+    if (capacity != 0) link(index);
+}
+
+void MemoizedFunction::removeSlot(size_t slot) {
+    size_t mask = slots.size() - 1;
+    slots[slot] = NONE;
+    for (size_t next = (slot + 1) & mask; slots[next] != NONE; next = (next + 1) & mask){
+        size_t ideal = entries[slots[next]].hash & mask;
+        //The entry can move back to the hole if the hole lies between its ideal slot and where it is now (cyclically)
+        bool movable = slot <= next ? (ideal <= slot || ideal > next) : (ideal <= slot && ideal > next);
+        if (movable){
+            slots[slot] = slots[next];
+            slots[next] = NONE;
+            slot = next;
+        }
+    }
+}
+
+void MemoizedFunction::grow() {
+    std::vector<uint32_t> grown(slots.empty() ? INITIAL_SLOTS : slots.size() * 2, NONE);
+    size_t mask = grown.size() - 1;
+    for (uint32_t index = 0; index < entries.size(); index++){
+        size_t slot = entries[index].hash & mask;
+        while (grown[slot] != NONE) slot = (slot + 1) & mask;
+        grown[slot] = index;
+    }
+    slots = std::move(grown);
+}
+
+void MemoizedFunction::link(uint32_t index) {
+    entries[index].older = newest;
+    entries[index].newer = NONE;
+    if (newest != NONE) entries[newest].newer = index;
+    newest = index;
+    if (oldest == NONE) oldest = index;
+}
+
+void MemoizedFunction::unlink(uint32_t index) {
+    Entry &entry = entries[index];
+    if (entry.older != NONE) entries[entry.older].newer = entry.newer; else oldest = entry.newer;
+    if (entry.newer != NONE) entries[entry.newer].older = entry.older; else newest = entry.older;
+}
@@ -0,0 +1,82 @@
+#ifndef JLOX_MEMOIZE_H
+#define JLOX_MEMOIZE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "LoxCallable.h"
+#include "LoxObject.h"
+
+class Interpreter;
+
+/*memoize(function) and memoize(function, capacity): a callable that remembers what function returned for every tuple of arguments
+ * it was called with, and returns it again instead of calling function when the same arguments come back. Meant for pure recursive
+ * functions, which become a one liner:
+ *
+ *      fun paths(x, y) { if (x == 0 or y == 0) return 1; return paths(x - 1, y) + paths(x, y - 1); }
+ *      paths = memoize(paths);
+ *
+ * (the recursive calls look paths up when they run, so they go through the cache too).
+ * Arguments are compared like ==: numbers, strings, booleans and nil by value, functions, classes, instances and lists by identity (a
+ * list that is modified is still the same key). A call with a NaN argument is never cached, NaN isn't equal to itself. Calls that
+ * throw aren't cached either.
+ *
+ * The results live in an open addressing table (linear probing, indices into a dense array of entries). Without a capacity it only
+ * grows; with one, the least recently used entry is evicted to make room once it is full. memo_stats(memoized) returns the number of
+ * hits, misses, evictions and entries.
+ *
+ * The cache isn't thread safe. Copies made by the ValueCopier (isolates, task arguments and captures) start with their own empty
+ * cache, and a memoized function stored in a global isn't visible to tasks, whose globals are shared by all the worker threads.
+ * */
+class MemoizedFunction : public LoxCallable {
+public:
+    //Implements memoize(function, capacity?)
+    static LoxObject create(const SharedCallablePtr &function, LoxArguments rest);
+    //Implements memo_stats(memoized)
+    static LoxObject stats(const SharedCallablePtr &memoized);
+
+    //capacity 0 means unbounded
+    MemoizedFunction(SharedCallablePtr function, size_t capacity);
+
+    LoxObject call(Interpreter &interpreter, LoxArguments arguments) override;
+    int arity() override;
+    bool isVariadic() override;
+    std::string to_string() override;
+    std::string name() override;
+
+    //Only replaced by the ValueCopier, which creates the copy before copying the function (it can refer back to the copy)
+    SharedCallablePtr function;
+    const size_t capacity;
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Entry {
+        std::vector<LoxObject> key;
+        size_t hash;
+        LoxObject value;
+        //Neighbours in the recency list, only kept up to date when there is a capacity
+        uint32_t older, newer;
+    };
+
+    std::vector<Entry> entries;
+    //Power of two, at most half full. Every slot is an index into entries or NONE
+    std::vector<uint32_t> slots;
+    uint32_t oldest = NONE, newest = NONE;
+    size_t hits = 0, misses = 0, evictions = 0;
+
+    static bool cacheable(LoxArguments arguments);
+    static size_t hashOf(LoxArguments arguments);
+    //Slot holding the entry for arguments, NONE if there isn't one
+    size_t find(LoxArguments arguments, size_t hash) const;
+    void insert(std::vector<LoxObject> key, size_t hash, const LoxObject &value);
+    //Empties a slot, shifting back the entries that probed past it so every entry stays reachable from its ideal slot
+    void removeSlot(size_t slot);
+    void grow();
+    void link(uint32_t index);
+    void unlink(uint32_t index);
+};
+
+
+#endif //JLOX_MEMOIZE_H
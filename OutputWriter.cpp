@@ -0,0 +1,75 @@
+#include "OutputWriter.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+
+
+OutputWriter::OutputWriter(int fd, size_t capacity) : fd(fd), buffer(capacity) {
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+OutputWriter::OutputWriter(std::ostream &sink, size_t capacity) : fd(-1), sink(&sink), buffer(capacity) {
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+OutputWriter::~OutputWriter() {
+    flush();
+}
+
+void OutputWriter::flush() {
+    if (sink == nullptr){
+        std::cout.flush();
+    }
+    writeAll(pbase(), pptr() - pbase());
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+OutputWriter::int_type OutputWriter::overflow(int_type ch) {
+    flush();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())){
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize OutputWriter::xsputn(const char *s, std::streamsize count) {
+    if (count > epptr() - pptr()){
+        flush();
+        if (count > epptr() - pptr()){ //Doesn't fit even in the empty buffer, write it directly
+            writeAll(s, count);
+            return count;
+        }
+    }
+
+    std::memcpy(pptr(), s, count);
+    pbump(count);
+    return count;
+}
+
+int OutputWriter::sync() {
+    flush();
+    return 0;
+}
+
+void OutputWriter::writeAll(const char *data, size_t size) {
+    if (sink != nullptr){
+        if (size == 0) return;
+        sink->write(data, size);
+        sink->flush();
+        return;
+    }
+
+    while (size > 0){
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0){
+            if (errno == EINTR) continue;
+            return; //Nothing sensible to do if stdout is gone, drop the output like std::cout would
+        }
+
+        data += written;
+        size -= written;
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef JLOX_OUTPUTWRITER_H
+#define JLOX_OUTPUTWRITER_H
+
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+/*Stream buffer for the output of print statements. Scripts that print a lot used to be bound by std::cout (one trip through iostream
+ * and usually one syscall per print), instead the output is collected in a large buffer and written to the file descriptor with write(2)
+ * when the buffer is full or when flush() is called.
+ * The interpreter flushes it when the program ends, before the REPL prompt, before reporting errors and when Lox calls flush().
+ * Anything written through std::cout is flushed first, so text printed by the Runner keeps its order relative to the Lox output.
+ * Instead of a file descriptor the output can go to a sink stream (e.g. a std::ostringstream of a program that embeds the interpreter),
+ * in that case the buffer is written to the sink when it is flushed.
+ * */
+class OutputWriter : public std::streambuf {
+public:
+    explicit OutputWriter(int fd = 1, size_t capacity = 1 << 16);
+    explicit OutputWriter(std::ostream &sink, size_t capacity = 1 << 16);
+    ~OutputWriter() override;
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+
+    void flush();
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* s, std::streamsize count) override;
+    int sync() override;
+
+private:
+    int fd;
+    std::ostream* sink = nullptr;
+    std::vector<char> buffer;
+
+    void writeAll(const char* data, size_t size);
+};
+
+
+#endif //JLOX_OUTPUTWRITER_H
@@ -10,7 +10,7 @@
 #include "Stmt.h"
 #include "TokenType.h"
 
-Parser::Parser(const std::vector<Token> &tokens) : tokens(tokens) {}
+Parser::Parser(const std::vector<Token> &tokens, std::ostream &errorOutput) : tokens(tokens), errorOutput(errorOutput) {}
 
 std::vector<UniqueStmtPtr> Parser::parse(bool &successFlag) {
     successFlag = true;
@@ -35,7 +35,7 @@ UniqueStmtPtr Parser::declaration() {
         return statement();
     } catch (const LoxParsingError &error) {
         //Report the exception but don't let it bubble up and stop the program. Instead, synchronize the parser and keep parsing.
-        std::cout << error.what() << "\n";
+        errorOutput << error.what() << "\n";
         hadError = true;
         synchronize();
     }
@@ -64,7 +64,7 @@ UniqueStmtPtr Parser::functionDeclStatement(FunctionType type) {
         do {
             if (parameters.size() >= 255){
                 //Report the error but don't throw it bc throwing it will cause the parser to synchronize and we want to keep parsing
-                std::cout << error(type_str + " cannot have more than 255 parameters", peek().line).what() << "\n";
+                errorOutput << error(type_str + " cannot have more than 255 parameters", peek().line).what() << "\n";
                 hadError = true;
             }
             Token param = expect(TokenType::IDENTIFIER, "Expected parameters name");
@@ -180,6 +180,12 @@ UniqueStmtPtr Parser::whileStatement() {
 
 UniqueStmtPtr Parser::forStatement() {
     expect(TokenType::LEFT_PAREN, "Expect '(' after for");
+    //in isn't a keyword, so it can still name variables, parameters and methods. Two identifiers in a row are never the start of an
+    //expression, so "for (name in" can only be a for-in loop
+    if (check(TokenType::IDENTIFIER) && tokens[current + 1].type == TokenType::IDENTIFIER && tokens[current + 1].lexeme == "in"){
+        return forInStatement();
+    }
+
     std::optional<UniqueStmtPtr> initializer = std::nullopt;
     if (match(TokenType::VAR)){
         initializer = varDeclStatement();
@@ -205,6 +211,15 @@ UniqueStmtPtr Parser::forStatement() {
     return std::make_unique<ForStmt>(std::move(initializer), std::move(condition), std::move(increment), std::move(body));
 }
 
+UniqueStmtPtr Parser::forInStatement() {
+    Token name = advance();
+    advance(); //in, forStatement already checked it
+    UniqueExprPtr iterable = expression();
+    expect(TokenType::RIGHT_PAREN, "Expect ')' after for");
+    UniqueStmtPtr body = statement();
+    return std::make_unique<ForInStmt>(name, std::move(iterable), std::move(body));
+}
+
 UniqueStmtPtr Parser::breakStatement() {
     Token keyword = previous();
     expect(TokenType::SEMICOLON, "Expect ';' after break");
@@ -286,7 +301,7 @@ UniqueExprPtr Parser::lambda() {
         do {
             if (params.size() >= 255){
                 //Report the error but don't throw it bc throwing it will cause the parser to synchronize and we want to keep parsing
-                std::cout << error("Lambda expression cannot have more than 255 parameters", peek().line).what() << "\n";
+                errorOutput << error("Lambda expression cannot have more than 255 parameters", peek().line).what() << "\n";
                 hadError = true;
             }
 
@@ -445,7 +460,7 @@ UniqueExprPtr Parser::finishCall(UniqueExprPtr expr) {
         do {
             if (arguments.size() >= 255){
                 //Report the error but don't throw it bc throwing it will cause the parser to synchronize and we want to keep parsing
-                std::cout << error("Cannot have more than 255 arguments", peek().line).what() << "\n";
+                errorOutput << error("Cannot have more than 255 arguments", peek().line).what() << "\n";
                 hadError = true;
             }
 
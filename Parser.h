@@ -1,6 +1,7 @@
 #ifndef JLOX_PARSER_H
 #define JLOX_PARSER_H
 
+#include <iostream>     // for ostream, cout
 #include <string>       // for string
 #include <vector>       // for vector
 #include "LoxError.h"   // for LoxParsingError
@@ -11,7 +12,8 @@
 
 class Parser {
 public:
-    Parser(const std::vector<Token> &tokens);
+    //Errors are reported to errorOutput
+    explicit Parser(const std::vector<Token> &tokens, std::ostream &errorOutput = std::cout);
     std::vector<UniqueStmtPtr> parse(bool &successFlag);
 
     enum class FunctionType {
@@ -20,6 +22,7 @@ public:
 
 private:
     std::vector<Token> tokens;
+    std::ostream &errorOutput;
     int current = 0;
     bool hadError = false;
 
@@ -33,6 +36,7 @@ private:
     UniqueStmtPtr ifStatement();
     UniqueStmtPtr whileStatement();
     UniqueStmtPtr forStatement();
+    UniqueStmtPtr forInStatement();
     UniqueStmtPtr breakStatement();
     UniqueStmtPtr continueStatement();
     UniqueStmtPtr returnStatement();
@@ -0,0 +1,18 @@
+#ifndef JLOX_PROGRAM_H
+#define JLOX_PROGRAM_H
+
+#include <vector>
+#include "Expr.h"
+#include "Stmt.h"
+#include "typedefs.h"
+
+/*Output of the front end (Scanner, Parser and Resolver), or of the AstCache. Owns the AST that the interpreter runs.
+ * The Resolver stores the distances of local variables in the nodes themselves while the Program is still non-const (see
+ * Resolver::resolve), and nothing modifies the AST after that, so a resolved program is immutable and can be shared (as a
+ * std::shared_ptr<const Program>) by interpreters running on different threads.
+ * */
+struct Program {
+    std::vector<UniqueStmtPtr> statements;
+};
+
+#endif //JLOX_PROGRAM_H
@@ -0,0 +1,27 @@
+#include "ProgramCache.h"
+#include "tools/BinaryStream.h"
+
+
+MemoryProgramCache::MemoryProgramCache(size_t capacity) : capacity(capacity) {}
+
+std::shared_ptr<const Program> MemoryProgramCache::load(const std::string &source) {
+    uint64_t hash = binary::fnv1a(source);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(hash);
+    if (it == entries.end() || it->second.source != source) return nullptr;
+    return it->second.program;
+}
+
+void MemoryProgramCache::store(const std::string &source, const std::shared_ptr<const Program> &program) {
+    uint64_t hash = binary::fnv1a(source);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto [it, inserted] = entries.try_emplace(hash);
+    it->second = Entry{source, program};
+    if (!inserted) return;
+
+    insertionOrder.push_back(hash);
+    if (insertionOrder.size() > capacity){
+        entries.erase(insertionOrder.front());
+        insertionOrder.pop_front();
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef JLOX_PROGRAMCACHE_H
+#define JLOX_PROGRAMCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "Program.h"
+
+//Where the Runner looks for resolved programs before scanning, parsing and resolving the source
+class ProgramCache {
+public:
+    virtual ~ProgramCache() = default;
+    //nullptr if there is no entry for source
+    virtual std::shared_ptr<const Program> load(const std::string &source) = 0;
+    //The cache is only an optimization, failing to store an entry is not an error
+    virtual void store(const std::string &source, const std::shared_ptr<const Program> &program) = 0;
+};
+
+/*Keeps resolved programs in memory for a process that runs the same scripts many times (see Server.h). Programs are immutable,
+ * so every load returns the same AST and runners on different threads share it instead of each one building its own copy.
+ * It can be used from several threads, when it holds capacity entries the oldest one is dropped (runners that still use it keep it alive).
+ * */
+class MemoryProgramCache : public ProgramCache {
+public:
+    explicit MemoryProgramCache(size_t capacity = 256);
+
+    std::shared_ptr<const Program> load(const std::string &source) override;
+    void store(const std::string &source, const std::shared_ptr<const Program> &program) override;
+
+private:
+    struct Entry {
+        std::string source;
+        std::shared_ptr<const Program> program;
+    };
+
+    size_t capacity;
+    std::mutex mutex;
+    std::unordered_map<uint64_t, Entry> entries;
+    std::deque<uint64_t> insertionOrder;
+};
+
+
+#endif //JLOX_PROGRAMCACHE_H
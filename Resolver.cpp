@@ -1,22 +1,32 @@
 #include "Resolver.h"
 #include <gsl/gsl_util>        // for finally
 #include <iostream>            // for operator<<, char_traits, basic_ostream
+#include "Environment.h"        // for GlobalEnvironment
 #include "LoxError.h"          // for LoxParsingError
 #include "Token.h"             // for Token
 
 
-std::unordered_map<const Expr*, int> Resolver::resolve(const std::vector<UniqueStmtPtr> &stmts, bool &successFlag) {
+namespace {
+    /*The visitor methods get the nodes as const, but the nodes are part of the non-const statements resolve() was given, so
+     * storing the distances in them is fine*/
+    template<typename Node>
+    Node* unfrozen(const Node *node) {
+        return const_cast<Node*>(node);
+    }
+}
+
+Resolver::Resolver(std::ostream &errorOutput) : errorOutput(errorOutput) {}
+
+void Resolver::resolve(std::vector<UniqueStmtPtr> &stmts, bool &successFlag) {
     successFlag = true;
     for (auto const &stmt : stmts){
         try {
             resolve(stmt.get());
         } catch (const LoxParsingError &error) {
-            std::cout << error.what() << "\n";
+            errorOutput << error.what() << "\n";
             successFlag = false;
         }
     }
-
-    return distances;
 }
 
 void Resolver::resolve(const std::vector<UniqueStmtPtr> &stmts) {
@@ -33,15 +43,15 @@ void Resolver::resolve(Expr *expr) {
     expr->accept(*this);
 }
 
-void Resolver::resolveLocal(const Expr *expr, const Token &name) {
+std::optional<int> Resolver::resolveLocal(const Token &name) {
     for (int i = scopes.size() - 1; i >= 0; i--){
         if (scopes[i].find(name.lexeme) != scopes[i].end()){
-            distances[expr] = scopes.size() - i - 1; //number of hops when resolving variable
-            return;
+            return scopes.size() - i - 1; //number of hops when resolving variable
         }
     }
 
     //If it is not found we assume the variable was global
+    return std::nullopt;
 }
 
 void Resolver::beginScope() {
@@ -143,18 +153,45 @@ void Resolver::visit(const ForStmt *forStmt) {
     endScope();
 }
 
+//The iterable is evaluated outside of the scope of the loop variable
+void Resolver::visit(const ForInStmt *forInStmt) {
+    resolve(forInStmt->iterable.get());
+
+    loopNestingLevel++;
+    auto finalAction = gsl::finally([this] {this->loopNestingLevel--;});
+
+    beginScope();
+    declare(forInStmt->name);
+    define(forInStmt->name);
+    resolve(forInStmt->body.get());
+    endScope();
+}
+
 void Resolver::visit(const FunctionDeclStmt *functionStmt) {
     declare(functionStmt->name);
     define(functionStmt->name);
     resolveFunction(functionStmt, FunctionType::FUNCTION);
 }
 
+template<typename Node>
+void Resolver::resolveVariable(Node *node) {
+    node->distance = resolveLocal(node->identifier);
+    if (!node->distance){
+        node->globalSymbol = GlobalEnvironment::symbol(node->identifier.lexeme);
+    }
+}
+
 void Resolver::resolveFunction(const FunctionDeclStmt *functionStmt, FunctionType type) {
     FunctionType enclosing = currentFunction;
     currentFunction = type;
     auto finalAction = gsl::finally([this, enclosing] {this->currentFunction = enclosing;});
 
     beginScope();
+    if (type == FunctionType::METHOD || type == FunctionType::CONSTRUCTOR){
+        //"this" lives in the same scope as the parameters, see LoxFunction::call
+        scopes.back()["this"] = true;
+    }
+
     for (const Token &param : functionStmt->params){
         declare(param);
         define(param);
@@ -179,14 +216,14 @@ void Resolver::visit(const ClassDeclStmt *classDeclStmt) {
         if (classDeclStmt->superclass.value()->identifier.lexeme == classDeclStmt->identifier.lexeme){
             throw LoxParsingError("Class cannot inherit from itself", classDeclStmt->identifier.line);
         }
+        //The superclass isn't resolved to a local, it is always looked up among the globals
+        VariableExpr* superclass = classDeclStmt->superclass.value().get();
+        superclass->globalSymbol = GlobalEnvironment::symbol(superclass->identifier.lexeme);
 
         beginScope();
         scopes.back()["super"] = true;
     }
 
-    beginScope();
-    scopes.back()["this"] = true;
-
     for (const auto& method : classDeclStmt->methods){
         FunctionType type = method->name.lexeme == "init" ? FunctionType::CONSTRUCTOR : FunctionType::METHOD;
         resolveFunction(method.get(), type);
@@ -197,8 +234,6 @@ void Resolver::visit(const ClassDeclStmt *classDeclStmt) {
         endScope();
     }
 
-    endScope();
-
 }
 
 void Resolver::visit(const ReturnStmt *returnStmt) {
@@ -246,13 +281,13 @@ LoxObject Resolver::visit(const VariableExpr *variableExpr) {
         }
     }
 
-    resolveLocal(variableExpr, variableExpr->identifier);
+    resolveVariable(unfrozen(variableExpr));
     return LoxObject::Nil();
 }
 
 LoxObject Resolver::visit(const AssignmentExpr *assignmentExpr) {
     resolve(assignmentExpr->value.get());
-    resolveLocal(assignmentExpr, assignmentExpr->identifier);
+    resolveVariable(unfrozen(assignmentExpr));
     return LoxObject::Nil();
 }
 
@@ -288,12 +323,12 @@ LoxObject Resolver::visit(const SetExpr *setExpr) {
 }
 
 LoxObject Resolver::visit(const IncrementExpr *incrementExpr) {
-    resolveLocal(incrementExpr->variable.get(), incrementExpr->variable->identifier);
+    resolveVariable(incrementExpr->variable.get());
     return LoxObject::Nil();
 }
 
 LoxObject Resolver::visit(const DecrementExpr *decrementExpr) {
-    resolveLocal(decrementExpr->variable.get(), decrementExpr->variable->identifier);
+    resolveVariable(decrementExpr->variable.get());
     return LoxObject::Nil();
 }
 
@@ -313,7 +348,7 @@ LoxObject Resolver::visit(const ThisExpr *thisExpr) {
         throw LoxParsingError("'this' must be inside a class declaration", thisExpr->keyword.line);
     }
 
-    resolveLocal(thisExpr, thisExpr->keyword);
+    unfrozen(thisExpr)->distance = resolveLocal(thisExpr->keyword);
     return LoxObject::Nil();
 }
 
@@ -332,6 +367,6 @@ LoxObject Resolver::visit(const SuperExpr *superExpr) {
         throw LoxParsingError("Cannot use 'super' in a class with no superclass", superExpr->keyword.line);
     }
 
-    resolveLocal(superExpr, superExpr->keyword);
+    unfrozen(superExpr)->distance = resolveLocal(superExpr->keyword);
     return LoxObject::Nil();
 }
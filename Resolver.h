@@ -2,6 +2,8 @@
 #define JLOX_RESOLVER_H
 
 
+#include <iostream>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -15,7 +17,11 @@ struct Token;
 class Resolver : public ExprVisitor, StmtVisitor {
 
 public:
-    std::unordered_map<const Expr*, int> resolve(const std::vector<UniqueStmtPtr> &stmts, bool &successFlag);
+    //Errors are reported to errorOutput
+    explicit Resolver(std::ostream &errorOutput = std::cout);
+    /*Stores the distance of every variable reference in its node, see Expr.h. Takes the statements of a Program that is still being
+     * built: a program that is already shared as const can't be resolved again while other threads run it*/
+    void resolve(std::vector<UniqueStmtPtr> &stmts, bool &successFlag);
 
     LoxObject visit(const BinaryExpr *binaryExpr) override;
     LoxObject visit(const GroupingExpr *groupingExpr) override;
@@ -44,6 +50,7 @@ public:
     void visit(const BreakStmt *breakStmt) override;
     void visit(const ContinueStmt *continueStmt) override;
     void visit(const ForStmt *forStmt) override;
+    void visit(const ForInStmt *forInStmt) override;
     void visit(const FunctionDeclStmt *functionStmt) override;
     void visit(const ReturnStmt *returnStmt) override;
     void visit(const ClassDeclStmt *classDeclStmt) override;
@@ -57,7 +64,7 @@ private:
         NONE, CLASS, SUBCLASS
     };
 
-    std::unordered_map<const Expr*, int> distances;
+    std::ostream &errorOutput;
     int loopNestingLevel = 0;
     FunctionType currentFunction = FunctionType::NONE;
     ClassType currentClass = ClassType::NONE;
@@ -69,7 +76,10 @@ private:
     void resolve(const std::vector<UniqueStmtPtr> &stmts);
     void resolve(Stmt* stmt);
     void resolve(Expr* expr);
-    void resolveLocal(const Expr* expr, const Token &name);
+    std::optional<int> resolveLocal(const Token &name);
+    //Stores the distance of a VariableExpr or AssignmentExpr, or its symbol if it is a global
+    template<typename Node>
+    void resolveVariable(Node *node);
     void resolveFunction(const FunctionDeclStmt *functionStmt, FunctionType type);
     void beginScope();
     void endScope();
@@ -1,84 +1,169 @@
 #include "Runner.h"
 #include <iostream>
+#include <iterator>
+#include <optional>
+#include <utility>
 #include <unordered_map>
 #include <vector>
+#include "ClosureCompiler.h"
+#include "EventLoop.h"
 #include "FileReader.h"
 #include "Interpreter.h"
 #include "LoxError.h"
 #include "Parser.h"
+#include "Program.h"
 #include "Resolver.h"
 #include "Scanner.h"
+#include "Snapshot.h"
 #include "Token.h"
 #include "typedefs.h"
 
-class Expr;
 
-
-Interpreter Runner::interpreter = Interpreter();
+Runner::Runner(std::ostream &output) : interpreter(output) {}
 
 int Runner::runScript(const std::string& filename) {
     FileReader reader(filename);
-    return runCode(reader.readAll());
+    return runSource(reader.readAll());
+}
+
+int Runner::runSource(const std::string &code) {
+    interpreter.unbufferedOutput = unbufferedOutput;
+    int exitCode = loadSnapshot() ? runCode(code) : 66;
+    if (exitCode == 0 && !snapshotCreatePath.empty()){
+        try {
+            Snapshot::create(snapshotCreatePath, programs, interpreter);
+        } catch (const LoxError &exception) {
+            interpreter.getOutput() << exception.what() << "\n";
+            exitCode = 74;
+        }
+    }
+    interpreter.flushOutput();
+    return exitCode;
 }
 
 int Runner::runRepl() {
     std::cout << "Interactive Repl mode. Type \"quit()\" or press CTRL-C to exit\n";
+    interpreter.unbufferedOutput = unbufferedOutput;
+    if (!loadSnapshot()){
+        return 66;
+    }
+
     std::string line;
     while (true){
+        interpreter.flushOutput();
         std::cout << "< ";
         std::getline(std::cin, line);
         if (line == "quit()") return 0;
         try {
             runCode(line, true);
         } catch (const LoxError &exception){
-            std::cout << exception.what() << "\n"; //use cout instead of cerr to avoid the two streams not being synchronized when printing the next '< '
+            interpreter.getOutput() << exception.what() << "\n"; //use stdout instead of cerr to avoid the two streams not being synchronized when printing the next '< '
         }
     }
 }
 
+int Runner::runProgram(const std::shared_ptr<const Program> &program) {
+    interpreter.unbufferedOutput = unbufferedOutput;
+    int exitCode = loadSnapshot() ? execute(program) : 66;
+    interpreter.flushOutput();
+    return exitCode;
+}
+
 int Runner::runCode(const std::string& code, bool replMode) {
+    std::shared_ptr<const Program> program = loadProgram(code, replMode);
+    if (!program){
+        return 65;
+    }
+    return execute(program, replMode);
+}
+
+int Runner::execute(const std::shared_ptr<const Program> &program, bool replMode) {
+    programs.push_back(program);
+
+    try {
+        if (backend == Backend::CLOSURES){
+            ClosureCompiler compiler(interpreter.globals);
+            CompiledBlock compiled = compiler.compile(program->statements, replMode);
+            interpreter.interpret(compiled);
+        } else {
+            interpreter.interpret(program->statements, replMode);
+        }
+        EventLoop::run(interpreter);
+    } catch (const LoxRuntimeError &exception) {
+        interpreter.getOutput() << exception.what() << "\n"; //Same stream as the output, so it appears after what was printed before the error
+        return 70;
+    }
+
+    return 0;
+}
+
+std::shared_ptr<const Program> Runner::loadProgram(const std::string &code, bool replMode) {
+    ProgramCache* cache = replMode ? nullptr : programCache.get();
+    if (cache != nullptr){
+        std::shared_ptr<const Program> cached = cache->load(code);
+        if (cached){
+            return cached;
+        }
+    }
+
+    auto program = std::make_shared<Program>();
     Scanner scanner(code);
     std::vector<Token> tokens;
 
     try {
         tokens = scanner.scanTokens();
     } catch (const LoxScanningError& exception) {
-        std::cout << exception.what() << "\n";
-        return 65;
+        interpreter.getOutput() << exception.what() << "\n";
+        return nullptr;
     }
 
 
-    Parser parser(tokens);
+    Parser parser(tokens, interpreter.getOutput());
     /*Because the parser can keep parsing after multiple errors instead of exiting at the first error, it has its own
     exception handling functionality baked into it, and the caller only has to worry about success or not.*/
     bool parsingSuccess = true;
-    std::vector<UniqueStmtPtr> statements = parser.parse(parsingSuccess);
+    program->statements = parser.parse(parsingSuccess);
     if (!parsingSuccess){
-        return 65;
+        return nullptr;
     }
 
-    Resolver resolver;
-    std::unordered_map<const Expr*, int> distances;
+    Resolver resolver(interpreter.getOutput());
     /*Because the resolver can keep going after multiple errors instead of exiting at the first error, it has its own
     exception handling functionality baked into it, and the caller only has to worry about success or not.*/
     bool resolvingSuccess = false;
-    distances = resolver.resolve(statements, resolvingSuccess);
+    resolver.resolve(program->statements, resolvingSuccess);
     if (!resolvingSuccess){
-        return 65;
+        return nullptr;
     }
 
+    if (cache != nullptr){
+        cache->store(code, program);
+    }
+
+    return program;
+}
+
+Interpreter& Runner::getInterpreter() {
+    return interpreter;
+}
 
+bool Runner::loadSnapshot() {
+    if (snapshotPath.empty() || snapshotLoaded) return true;
 
+    snapshotLoaded = true;
     try {
-        interpreter.interpret(statements, distances, replMode);
-    } catch (const LoxRuntimeError &exception) {
-        std::cout << exception.what() << "\n";
-        return 70;
+        std::vector<std::shared_ptr<const Program>> loaded = Snapshot::load(snapshotPath, interpreter, backend == Backend::CLOSURES);
+        std::move(loaded.begin(), loaded.end(), std::back_inserter(programs));
+    } catch (const LoxError &exception) {
+        interpreter.getOutput() << exception.what() << "\n";
+        return false;
     }
-
-    return 0;
+    return true;
 }
 
 void Runner::displayLoxUsage(){
-    std::cout << "Usage: jlox [script]\n";
+    std::cout << "Usage: jlox [--compile] [--unbuffered] [--ast-cache dir] [--snapshot image] [--snapshot-create image] [script]\n"
+                 "       jlox [--compile] [--snapshot image] --serve socket\n"
+                 "       jlox --submit socket script [args]\n"
+                 "       jlox [--compile] [--snapshot image] --workers n [scripts]\n";
 }
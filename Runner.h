@@ -1,19 +1,63 @@
 #ifndef JLOX_RUNNER_H
 #define JLOX_RUNNER_H
+#include <memory>
+#include <ostream>
 #include <string>
+#include <vector>
+#include "Interpreter.h"
+#include "Program.h"
+#include "ProgramCache.h"
 
-class Interpreter;
-
+/*Runs scripts and the repl on its own Interpreter. Runners don't share any state, so a program can create several of them and run
+ * independent scripts at the same time, one Runner per thread (see Interpreter.h). The options must be set before running anything.
+ * */
 class Runner {
 public:
+    enum class Backend {
+        TREE_WALKER, //Interpreter visits the AST directly
+        CLOSURES //The AST is compiled into native closures by the ClosureCompiler before running, see ClosureCompiler.h
+    };
+
+    Backend backend = Backend::TREE_WALKER;
+    //Write the output of print statements immediately instead of buffering it, see OutputWriter.h
+    bool unbufferedOutput = false;
+    //Resolved programs are looked up here before parsing a script (not in the repl), e.g. an AstCache. Can be shared by several runners
+    std::shared_ptr<ProgramCache> programCache;
+    //Snapshot loaded before running the script or the repl, none if empty
+    std::string snapshotPath;
+    //Snapshot written by runScript after the script runs successfully, none if empty
+    std::string snapshotCreatePath;
+
+    //Output and error messages go to standard output
+    Runner() = default;
+    //Output and error messages go to output
+    explicit Runner(std::ostream &output);
+
     //returns exit code
-    static int runScript(const std::string& filename);
-    static int runRepl();
+    int runScript(const std::string& filename);
+    //Same as runScript with the source code of the script
+    int runSource(const std::string& code);
+    int runRepl();
+    /*Scans, parses and resolves code, or loads it from the program cache. Errors are reported to the output, returns nullptr if
+     * there were any. The program is immutable, so it can be run by any number of runners, each one on its own thread.*/
+    std::shared_ptr<const Program> loadProgram(const std::string &code, bool replMode = false);
+    //Same as runSource with a program returned by loadProgram (of this Runner or any other one)
+    int runProgram(const std::shared_ptr<const Program> &program);
+    /*Loads the snapshot (once) if there is one, errors are reported to the output. The run methods call it, it only has to be
+     * called directly to have the snapshot loaded before running anything (see WorkerPool.h)*/
+    bool loadSnapshot();
+    Interpreter& getInterpreter();
     static void displayLoxUsage();
 
 private:
-    static int runCode(const std::string& code, bool replMode = false);
-    static Interpreter interpreter;
+    /*Functions, classes and lists keep pointers into the AST they were declared in, so every program that was run is kept alive.
+     * Declared before the interpreter so it is destroyed after it, isolates still running (see Isolate.h) are joined first.*/
+    std::vector<std::shared_ptr<const Program>> programs;
+    Interpreter interpreter;
+    bool snapshotLoaded = false;
+
+    int runCode(const std::string& code, bool replMode = false);
+    int execute(const std::shared_ptr<const Program> &program, bool replMode = false);
 };
 
 #endif
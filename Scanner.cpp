@@ -5,7 +5,7 @@
 #include "LoxError.h"
 #include "TokenType.h"
 
-std::map<std::string, TokenType> Scanner::reservedKeywords = {
+const std::map<std::string, TokenType> Scanner::reservedKeywords = {
         {"and", TokenType::AND},
         {"class", TokenType::CLASS},
         {"else", TokenType::ELSE},
@@ -160,14 +160,15 @@ std::optional<Token> Scanner::scanIdentifier() {
     }
 
     std::string identifier = source.substr(start, (current - start));
-    if (reservedKeywords.count(identifier) > 0){
+    auto keyword = reservedKeywords.find(identifier);
+    if (keyword != reservedKeywords.end()){
         if (identifier == "false"){
             return createToken(TokenType::FALSE);
         } else if (identifier == "true"){
             return createToken(TokenType::TRUE);
         }
 
-        return createToken(reservedKeywords[identifier]);
+        return createToken(keyword->second);
     }
     return createToken(IDENTIFIER);
 }
@@ -17,7 +17,7 @@ private:
     int start = 0, current = 0, line = 1, pos_in_line = 1;
     std::string source;
     std::vector<Token> tokens;
-    static std::map<std::string, TokenType> reservedKeywords;
+    static const std::map<std::string, TokenType> reservedKeywords;
 
     bool isAtEnd();
     std::optional<Token> scanNextToken();
@@ -0,0 +1,280 @@
+#include "Server.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <streambuf>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <gsl/gsl_util>
+#include "FileReader.h"
+#include "Interpreter.h"
+#include "LoxError.h"
+#include "LoxList.h"
+#include "LoxObject.h"
+
+namespace {
+    //Scripts and paths bigger than this are rejected instead of allocating whatever a client asks for
+    constexpr size_t MAX_MESSAGE_SIZE = 64 << 20;
+
+    bool sendAll(int fd, const char* data, size_t size) {
+        while (size > 0){
+            ssize_t sent = ::send(fd, data, size, MSG_NOSIGNAL);
+            if (sent < 0){
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += sent;
+            size -= sent;
+        }
+        return true;
+    }
+
+    bool sendMessage(int fd, const std::string &header, const char* data, size_t size) {
+        std::string line = header + " " + std::to_string(size) + "\n";
+        return sendAll(fd, line.data(), line.size()) && sendAll(fd, data, size);
+    }
+
+    //Reads the headers and payloads of the protocol described in Server.h
+    class MessageReader {
+    public:
+        explicit MessageReader(int fd) : fd(fd) {}
+
+        //Reads "<header> <number>\n", returns false if the connection was closed or the line is malformed
+        bool readHeader(std::string &header, size_t &number) {
+            std::string line;
+            char c;
+            while (true){
+                if (!readBytes(&c, 1)) return false;
+                if (c == '\n') break;
+                if (line.size() > 64) return false;
+                line += c;
+            }
+
+            size_t space = line.find(' ');
+            if (space == std::string::npos) return false;
+            header = line.substr(0, space);
+            try {
+                number = std::stoull(line.substr(space + 1));
+            } catch (const std::exception &) {
+                return false;
+            }
+            return true;
+        }
+
+        bool readPayload(std::string &payload, size_t size) {
+            if (size > MAX_MESSAGE_SIZE) return false;
+            payload.resize(size);
+            return readBytes(payload.data(), size);
+        }
+
+    private:
+        int fd;
+        char buffer[4096];
+        size_t start = 0, end = 0;
+
+        bool readBytes(char* out, size_t size) {
+            while (size > 0){
+                if (start == end){
+                    ssize_t received = ::recv(fd, buffer, sizeof(buffer), 0);
+                    if (received < 0 && errno == EINTR) continue;
+                    if (received <= 0) return false;
+                    start = 0;
+                    end = received;
+                }
+
+                size_t count = std::min(size, end - start);
+                std::memcpy(out, buffer + start, count);
+                start += count;
+                out += count;
+                size -= count;
+            }
+            return true;
+        }
+    };
+
+    /*Sends everything written to it as OUT messages. The output is collected in a buffer and sent as one message when the buffer is
+     * full or the stream is flushed (the interpreter flushes it whenever its own output buffer is flushed, see OutputWriter.h), so
+     * writing a character at a time doesn't cost a message each*/
+    class ConnectionStreamBuffer : public std::streambuf {
+    public:
+        explicit ConnectionStreamBuffer(int fd, size_t capacity = 1 << 16) : fd(fd), buffer(capacity) {
+            setp(buffer.data(), buffer.data() + buffer.size());
+        }
+
+    protected:
+        int_type overflow(int_type ch) override {
+            send();
+            if (!traits_type::eq_int_type(ch, traits_type::eof())){
+                *pptr() = traits_type::to_char_type(ch);
+                pbump(1);
+            }
+            return traits_type::not_eof(ch);
+        }
+
+        std::streamsize xsputn(const char* s, std::streamsize count) override {
+            if (count > epptr() - pptr()){
+                send();
+                if (count > epptr() - pptr()){ //Doesn't fit even in the empty buffer, send it directly
+                    sendMessage(fd, "OUT", s, count);
+                    return count;
+                }
+            }
+            std::memcpy(pptr(), s, count);
+            pbump(count);
+            return count;
+        }
+
+        int sync() override {
+            send();
+            return 0;
+        }
+
+    private:
+        int fd;
+        std::vector<char> buffer;
+
+        void send() {
+            if (pptr() != pbase()){
+                sendMessage(fd, "OUT", pbase(), pptr() - pbase());
+            }
+            setp(buffer.data(), buffer.data() + buffer.size());
+        }
+    };
+
+    sockaddr_un socketAddress(const std::string &path) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        return address;
+    }
+}
+
+
+Server::Server(std::string socketPath) : socketPath(std::move(socketPath)), programCache(std::make_shared<MemoryProgramCache>()) {}
+
+int Server::run() {
+    if (socketPath.size() >= sizeof(sockaddr_un::sun_path)){
+        std::cout << "Socket path " << socketPath << " is too long\n";
+        return 71;
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un address = socketAddress(socketPath);
+    ::unlink(socketPath.c_str()); //Left behind by a server that didn't shut down cleanly
+    if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || ::listen(fd, SOMAXCONN) < 0){
+        std::cout << "Could not listen on " << socketPath << ": " << std::strerror(errno) << "\n";
+        if (fd >= 0) ::close(fd);
+        return 71;
+    }
+    listeningSocket = fd;
+
+    while (!stopping){
+        int connection = ::accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (connection < 0){
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break; //stop() shut the socket down
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            runningJobs++;
+        }
+        std::thread([this, connection] {
+            handleConnection(connection);
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            runningJobs--;
+            jobsFinished.notify_all();
+        }).detach();
+    }
+
+    ::close(fd);
+    ::unlink(socketPath.c_str());
+    std::unique_lock<std::mutex> lock(jobsMutex);
+    jobsFinished.wait(lock, [this] { return runningJobs == 0; });
+    return 0;
+}
+
+void Server::stop() {
+    stopping = true;
+    int fd = listeningSocket;
+    if (fd >= 0){
+        ::shutdown(fd, SHUT_RDWR); //Wakes up accept()
+    }
+}
+
+void Server::handleConnection(int connection) {
+    auto closeConnection = gsl::finally([connection] { ::close(connection); });
+
+    MessageReader reader(connection);
+    std::vector<LoxObject> args;
+    std::string header, payload, source;
+    size_t size;
+    while (true){
+        if (!reader.readHeader(header, size) || !reader.readPayload(payload, size)) return;
+        if (header == "ARG"){
+            args.emplace_back(std::move(payload));
+        } else if (header == "SOURCE" || header == "FILE"){
+            break;
+        } else {
+            return;
+        }
+    }
+
+    ConnectionStreamBuffer outputBuffer(connection);
+    std::ostream output(&outputBuffer);
+    int exitCode;
+    {
+        Runner runner(output);
+        runner.backend = backend;
+        runner.snapshotPath = snapshotPath;
+        runner.programCache = programCache;
+        runner.getInterpreter().globals.define("args", LoxObject(std::make_shared<LoxList>(nullptr, args)));
+        try {
+            exitCode = header == "FILE" ? runner.runScript(payload) : runner.runSource(payload);
+        } catch (const LoxError &exception) { //File not found
+            output << exception.what() << "\n";
+            exitCode = 66;
+        }
+    } //The runner flushes the rest of its output when it is destroyed
+    output.flush();
+
+    std::string exit = "EXIT " + std::to_string(exitCode) + "\n";
+    sendAll(connection, exit.data(), exit.size());
+}
+
+int Server::submit(const std::string &socketPath, const std::string &source, const std::vector<std::string> &args, std::ostream &output) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return 71;
+    auto closeSocket = gsl::finally([fd] { ::close(fd); });
+
+    sockaddr_un address = socketAddress(socketPath);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0){
+        output << "Could not connect to " << socketPath << ": " << std::strerror(errno) << "\n";
+        return 71;
+    }
+
+    for (const std::string &arg : args){
+        if (!sendMessage(fd, "ARG", arg.data(), arg.size())) return 71;
+    }
+    if (!sendMessage(fd, "SOURCE", source.data(), source.size())) return 71;
+
+    MessageReader reader(fd);
+    std::string header, payload;
+    size_t number;
+    while (reader.readHeader(header, number)){
+        if (header == "EXIT"){
+            output.flush();
+            return (int) number;
+        }
+        if (header != "OUT" || !reader.readPayload(payload, number)) break;
+        output.write(payload.data(), payload.size());
+    }
+
+    output << "Connection to " << socketPath << " closed before the job finished\n";
+    return 71;
+}
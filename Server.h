@@ -0,0 +1,57 @@
+#ifndef JLOX_SERVER_H
+#define JLOX_SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ProgramCache.h"
+#include "Runner.h"
+
+/*Script server: "jlox --serve /path/to.sock" keeps a process running that executes the scripts submitted over a Unix domain socket,
+ * so a job doesn't pay for starting a process. Every connection runs one job on its own thread with its own Runner (so jobs are
+ * isolated from each other, see Interpreter.h), and resolved programs are kept in a MemoryProgramCache shared by all the jobs,
+ * keyed by the content of the source.
+ *
+ * The protocol is made of text headers followed by raw bytes, one job per connection. The client sends
+ *      ARG <length>\n<bytes>           zero or more times, the arguments of the script (the global list "args")
+ *      SOURCE <length>\n<bytes>        the source of the script, or
+ *      FILE <length>\n<bytes>          the path of the script, read by the server
+ * and the server answers with the output of the script as it is produced and the exit code of the job
+ *      OUT <length>\n<bytes>           zero or more times
+ *      EXIT <code>\n
+ * "jlox --submit /path/to.sock script.lox [args]" is a client that prints the output and exits with the exit code of the job.
+ * */
+class Server {
+public:
+    //Options of the runner of every job
+    Runner::Backend backend = Runner::Backend::TREE_WALKER;
+    std::string snapshotPath;
+
+    explicit Server(std::string socketPath);
+
+    /*Accepts connections until stop() is called and waits for the jobs that are still running. Returns an exit code, 0 after stop()
+     * or 71 if the socket can't be created*/
+    int run();
+    void stop();
+
+    //Runs a job on the server listening on socketPath and writes its output to output. Returns the exit code of the job
+    static int submit(const std::string &socketPath, const std::string &source, const std::vector<std::string> &args, std::ostream &output);
+
+private:
+    std::string socketPath;
+    std::shared_ptr<ProgramCache> programCache;
+    std::atomic<int> listeningSocket{-1};
+    std::atomic<bool> stopping{false};
+    std::mutex jobsMutex;
+    std::condition_variable jobsFinished;
+    int runningJobs = 0;
+
+    void handleConnection(int connection);
+};
+
+
+#endif //JLOX_SERVER_H
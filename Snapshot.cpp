@@ -0,0 +1,549 @@
+#include "Snapshot.h"
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include "AstSerializer.h"
+#include "ClosureCompiler.h"
+#include "Environment.h"
+#include "Interpreter.h"
+#include "LoxClass.h"
+#include "LoxError.h"
+#include "LoxFunction.h"
+#include "LoxList.h"
+#include "Token.h"
+#include "tools/BinaryStream.h"
+
+namespace {
+    constexpr char MAGIC[8] = {'L', 'O', 'X', 'S', 'N', 'A', 'P', '\0'};
+
+    enum class ObjectKind : uint8_t {
+        ENVIRONMENT, FUNCTION, LAMBDA, CLASS, NATIVE, INSTANCE, LIST
+    };
+
+    //References to environments, superclasses and receivers are written as 0 for none (the global environment for environments)
+    //or object id + 1
+
+    class SnapshotWriter {
+    public:
+        explicit SnapshotWriter(Interpreter &interpreter) : interpreter(interpreter) {}
+
+        std::vector<uint8_t> write(const std::vector<std::shared_ptr<const Program>> &programs) {
+            binary::Writer payload;
+            payload.varint(programs.size());
+            for (const std::shared_ptr<const Program> &program : programs){
+                AstSerializer serializer;
+                serializer.serialize(*program, payload, &nodeIds);
+            }
+
+            std::vector<std::pair<const std::string*, const LoxObject*>> globals;
+            for (const GlobalEnvironment::Cell &cell : interpreter.globals.getCells()){
+                if (!cell.defined || isBuiltin(cell.name, cell.value)) continue;
+                globals.emplace_back(&cell.name, &cell.value);
+                discover(cell.value);
+            }
+
+            //objects grows while its children are discovered
+            for (size_t i = 0; i < objects.size(); i++){
+                discoverChildren(objects[i]);
+            }
+
+            payload.varint(objects.size());
+            for (const Object &object : objects){
+                writeShell(object, payload);
+            }
+            for (const Object &object : objects){
+                writeLinks(object, payload);
+            }
+
+            payload.varint(globals.size());
+            for (const auto &[name, value] : globals){
+                payload.string(*name);
+                writeValue(*value, payload);
+            }
+
+            binary::Writer out;
+            out.raw(MAGIC, sizeof(MAGIC));
+            out.u32(Snapshot::FORMAT_VERSION);
+            out.u64(binary::fnv1a(payload.bytes));
+            out.raw(payload.bytes.data(), payload.bytes.size());
+            return std::move(out.bytes);
+        }
+
+    private:
+        struct Object {
+            ObjectKind kind;
+            const void* pointer;
+            uint64_t parent = 0; //only for environments
+        };
+
+        Interpreter &interpreter;
+        std::unordered_map<const void*, uint64_t> nodeIds;
+        std::unordered_map<const void*, uint64_t> objectIds;
+        std::vector<Object> objects;
+
+        bool isBuiltin(const std::string &name, const LoxObject &value) {
+            return value.isCallable() && kindOf(value.getCallable().get()) == ObjectKind::NATIVE && value.getCallable()->name() == name;
+        }
+
+        static ObjectKind kindOf(LoxCallable* callable) {
+            if (dynamic_cast<LoxFunction*>(callable)) return ObjectKind::FUNCTION;
+            if (dynamic_cast<LoxLambdaWrapper*>(callable)) return ObjectKind::LAMBDA;
+            if (dynamic_cast<LoxClass*>(callable)) return ObjectKind::CLASS;
+            return ObjectKind::NATIVE;
+        }
+
+        uint64_t add(ObjectKind kind, const void* pointer) {
+            auto [it, inserted] = objectIds.try_emplace(pointer, objects.size());
+            if (inserted){
+                objects.push_back({kind, pointer});
+            }
+            return it->second;
+        }
+
+        void discover(const LoxObject &value) {
+            if (value.isCallable()){
+                add(kindOf(value.getCallable().get()), value.getCallable().get());
+            } else if (value.isClassInstance()){
+                add(ObjectKind::INSTANCE, value.getClassInstance().get());
+            } else if (value.isList()){
+                add(ObjectKind::LIST, value.getList().get());
+            }
+        }
+
+        //Environments get their id after their parent, so the reader can create them in order
+        uint64_t environmentReference(Environment* environment) {
+            if (environment == interpreter.globalEnv.get()) return 0;
+
+            auto it = objectIds.find(environment);
+            if (it != objectIds.end()) return it->second + 1;
+
+            if (environment->parent() == nullptr){
+                throw LoxError("Cannot create snapshot: found an environment that is not part of the global environment chain");
+            }
+            uint64_t parent = environmentReference(environment->parent().get());
+            uint64_t id = add(ObjectKind::ENVIRONMENT, environment);
+            objects[id].parent = parent;
+            return id + 1;
+        }
+
+        uint64_t nodeId(const void* node, const std::string &description) {
+            auto it = nodeIds.find(node);
+            if (it == nodeIds.end()){
+                throw LoxError("Cannot create snapshot: " + description + " was not declared by the snapshotted programs");
+            }
+            return it->second;
+        }
+
+        //Gets an id for everything that object refers to
+        void discoverChildren(const Object &object) {
+            switch (object.kind) {
+                case ObjectKind::ENVIRONMENT:
+                    for (const auto &[name, value] : static_cast<const Environment*>(object.pointer)->getVariables()){
+                        discover(value);
+                    }
+                    break;
+                case ObjectKind::FUNCTION: {
+                    auto* function = static_cast<const LoxFunction*>(object.pointer);
+                    environmentReference(function->closure.get());
+                    if (function->receiver) add(ObjectKind::INSTANCE, function->receiver.get());
+                    break;
+                }
+                case ObjectKind::LAMBDA:
+                    environmentReference(static_cast<const LoxLambdaWrapper*>(object.pointer)->closure.get());
+                    break;
+                case ObjectKind::CLASS: {
+                    auto* loxClass = static_cast<const LoxClass*>(object.pointer);
+                    if (loxClass->superclass.has_value()) add(ObjectKind::CLASS, loxClass->superclass.value().get());
+                    for (const auto &[name, method] : loxClass->methods){
+                        add(ObjectKind::FUNCTION, method.get());
+                    }
+                    break;
+                }
+                case ObjectKind::NATIVE: {
+                    auto* native = const_cast<LoxCallable*>(static_cast<const LoxCallable*>(object.pointer));
+                    GlobalEnvironment::Cell* cell = interpreter.globals.cell(native->name());
+                    if (!cell->defined || !cell->value.isCallable() || cell->value.getCallable().get() != native){
+                        throw LoxError("Cannot create snapshot: native function '" + native->name() + "' is not a builtin");
+                    }
+                    break;
+                }
+                case ObjectKind::INSTANCE: {
+                    auto* instance = static_cast<const LoxClassInstance*>(object.pointer);
+                    add(ObjectKind::CLASS, instance->getClass().get());
+                    for (const auto &[name, value] : instance->getFields()){
+                        discover(value);
+                    }
+                    break;
+                }
+                case ObjectKind::LIST:
+                    for (const LoxObject &item : static_cast<const LoxList*>(object.pointer)->getItems()){
+                        discover(item);
+                    }
+                    break;
+            }
+        }
+
+        //Everything needed to create the object, except references to other objects
+        void writeShell(const Object &object, binary::Writer &out) {
+            out.u8((uint8_t) object.kind);
+            switch (object.kind) {
+                case ObjectKind::ENVIRONMENT:
+                    out.varint(object.parent);
+                    break;
+                case ObjectKind::FUNCTION: {
+                    auto* function = static_cast<const LoxFunction*>(object.pointer);
+                    out.varint(nodeId(function->functionDeclStmt, "function '" + function->functionDeclStmt->name.lexeme + "'"));
+                    out.u8(function->isConstructor);
+                    break;
+                }
+                case ObjectKind::LAMBDA:
+                    out.varint(nodeId(static_cast<const LoxLambdaWrapper*>(object.pointer)->lambdaExpr, "a lambda"));
+                    break;
+                case ObjectKind::CLASS:
+                    out.string(static_cast<const LoxClass*>(object.pointer)->className);
+                    break;
+                case ObjectKind::NATIVE:
+                    out.string(const_cast<LoxCallable*>(static_cast<const LoxCallable*>(object.pointer))->name());
+                    break;
+                case ObjectKind::INSTANCE:
+                    out.varint(objectIds.at(static_cast<const LoxClassInstance*>(object.pointer)->getClass().get()));
+                    break;
+                case ObjectKind::LIST:
+                    out.varint(nodeId(static_cast<const LoxList*>(object.pointer)->getDeclaration(), "a list"));
+                    break;
+            }
+        }
+
+        void writeLinks(const Object &object, binary::Writer &out) {
+            switch (object.kind) {
+                case ObjectKind::ENVIRONMENT:
+                    writeVariables(static_cast<const Environment*>(object.pointer)->getVariables(), out);
+                    break;
+                case ObjectKind::FUNCTION: {
+                    auto* function = static_cast<const LoxFunction*>(object.pointer);
+                    out.varint(environmentReference(function->closure.get()));
+                    out.varint(function->receiver ? objectIds.at(function->receiver.get()) + 1 : 0);
+                    break;
+                }
+                case ObjectKind::LAMBDA:
+                    out.varint(environmentReference(static_cast<const LoxLambdaWrapper*>(object.pointer)->closure.get()));
+                    break;
+                case ObjectKind::CLASS: {
+                    auto* loxClass = static_cast<const LoxClass*>(object.pointer);
+                    out.varint(loxClass->superclass.has_value() ? objectIds.at(loxClass->superclass.value().get()) + 1 : 0);
+                    out.varint(loxClass->methods.size());
+                    for (const auto &[name, method] : loxClass->methods){
+                        out.string(name);
+                        out.varint(objectIds.at(method.get()));
+                    }
+                    break;
+                }
+                case ObjectKind::NATIVE:
+                    break;
+                case ObjectKind::INSTANCE:
+                    writeVariables(static_cast<const LoxClassInstance*>(object.pointer)->getFields(), out);
+                    break;
+                case ObjectKind::LIST: {
+                    const std::vector<LoxObject> &items = static_cast<const LoxList*>(object.pointer)->getItems();
+                    out.varint(items.size());
+                    for (const LoxObject &item : items){
+                        writeValue(item, out);
+                    }
+                    break;
+                }
+            }
+        }
+
+        void writeVariables(const std::unordered_map<std::string, LoxObject> &variables, binary::Writer &out) {
+            out.varint(variables.size());
+            for (const auto &[name, value] : variables){
+                out.string(name);
+                writeValue(value, out);
+            }
+        }
+
+        void writeValue(const LoxObject &value, binary::Writer &out) {
+            out.u8((uint8_t) value.type);
+            switch (value.type) {
+                case LoxType::NIL:
+                    break;
+                case LoxType::BOOL:
+                    out.u8(value.getBoolean());
+                    break;
+                case LoxType::NUMBER:
+                    out.number(value.getNumber());
+                    break;
+                case LoxType::STRING:
+                    out.string(value.getString());
+                    break;
+                case LoxType::CALLABLE:
+                    out.varint(objectIds.at(value.getCallable().get()));
+                    break;
+                case LoxType::INSTANCE:
+                    out.varint(objectIds.at(value.getClassInstance().get()));
+                    break;
+                case LoxType::LIST:
+                    out.varint(objectIds.at(value.getList().get()));
+                    break;
+            }
+        }
+    };
+
+
+    class SnapshotReader {
+    public:
+        SnapshotReader(Interpreter &interpreter, bool compile) : interpreter(interpreter), compile(compile) {}
+
+        std::vector<std::shared_ptr<const Program>> read(binary::Reader &in) {
+            size_t programCount = in.varint();
+            std::vector<std::shared_ptr<const Program>> programs;
+            for (size_t i = 0; i < programCount; i++){
+                AstDeserializer deserializer;
+                programs.push_back(std::make_shared<const Program>(deserializer.deserialize(in, &nodes)));
+            }
+
+            size_t objectCount = in.varint();
+            objects.resize(objectCount);
+            //Instances need their class, which may come later in the table, so they are created once everything else exists
+            std::vector<std::pair<size_t, uint64_t>> instanceClasses;
+            for (size_t i = 0; i < objectCount; i++){
+                readShell(i, in, instanceClasses);
+            }
+            for (const auto &[index, classId] : instanceClasses){
+                auto loxClass = std::dynamic_pointer_cast<LoxClass>(object(classId, ObjectKind::CLASS).callable);
+                objects[index].instance = std::make_shared<LoxClassInstance>(loxClass);
+            }
+
+            for (size_t i = 0; i < objectCount; i++){
+                readLinks(objects[i], in);
+            }
+
+            size_t globalCount = in.varint();
+            for (size_t i = 0; i < globalCount; i++){
+                std::string name(in.string());
+                interpreter.globals.define(name, readValue(in));
+            }
+
+            if (compile){
+                compileBodies();
+            }
+
+            return programs;
+        }
+
+    private:
+        struct Object {
+            ObjectKind kind;
+            Environment::SharedPtr environment;
+            SharedCallablePtr callable;
+            SharedInstancePtr instance;
+            SharedListPtr list;
+        };
+
+        Interpreter &interpreter;
+        bool compile;
+        std::vector<const void*> nodes;
+        std::vector<Object> objects;
+
+        const void* node(uint64_t id) {
+            if (id >= nodes.size()) throw binary::FormatError("Invalid node id");
+            return nodes[id];
+        }
+
+        Object& object(uint64_t id, ObjectKind kind) {
+            if (id >= objects.size() || objects[id].kind != kind) throw binary::FormatError("Invalid object reference");
+            return objects[id];
+        }
+
+        Environment::SharedPtr environment(uint64_t reference) {
+            if (reference == 0) return interpreter.globalEnv;
+            return object(reference - 1, ObjectKind::ENVIRONMENT).environment;
+        }
+
+        void readShell(size_t index, binary::Reader &in, std::vector<std::pair<size_t, uint64_t>> &instanceClasses) {
+            Object &object = objects[index];
+            object.kind = (ObjectKind) in.u8();
+            switch (object.kind) {
+                case ObjectKind::ENVIRONMENT: {
+                    uint64_t parent = in.varint();
+                    if (parent > index) throw binary::FormatError("Environment created before its parent");
+                    object.environment = std::make_shared<Environment>(environment(parent));
+                    break;
+                }
+                case ObjectKind::FUNCTION: {
+                    auto* declaration = static_cast<const FunctionDeclStmt*>(node(in.varint()));
+                    bool isConstructor = in.u8();
+                    object.callable = std::make_shared<LoxFunction>(declaration, nullptr, isConstructor);
+                    break;
+                }
+                case ObjectKind::LAMBDA:
+                    object.callable = std::make_shared<LoxLambdaWrapper>(static_cast<const LambdaExpr*>(node(in.varint())), nullptr);
+                    break;
+                case ObjectKind::CLASS:
+                    object.callable = std::make_shared<LoxClass>(std::string(in.string()), std::unordered_map<std::string, std::shared_ptr<LoxFunction>>(), std::nullopt);
+                    break;
+                case ObjectKind::NATIVE: {
+                    std::string name(in.string());
+                    GlobalEnvironment::Cell* cell = interpreter.globals.cell(name);
+                    if (!cell->defined || !cell->value.isCallable()){
+                        throw LoxError("Snapshot refers to native function '" + name + "' which doesn't exist");
+                    }
+                    object.callable = cell->value.getCallable();
+                    break;
+                }
+                case ObjectKind::INSTANCE:
+                    instanceClasses.emplace_back(index, in.varint());
+                    break;
+                case ObjectKind::LIST:
+                    object.list = std::make_shared<LoxList>(static_cast<const ListExpr*>(node(in.varint())), std::vector<LoxObject>());
+                    break;
+                default:
+                    throw binary::FormatError("Invalid object kind");
+            }
+        }
+
+        void readLinks(Object &object, binary::Reader &in) {
+            switch (object.kind) {
+                case ObjectKind::ENVIRONMENT: {
+                    size_t count = in.varint();
+                    for (size_t i = 0; i < count; i++){
+                        std::string name(in.string());
+                        object.environment->define(name, readValue(in));
+                    }
+                    break;
+                }
+                case ObjectKind::FUNCTION: {
+                    auto* function = static_cast<LoxFunction*>(object.callable.get());
+                    function->closure = environment(in.varint());
+                    uint64_t receiver = in.varint();
+                    if (receiver != 0){
+                        function->receiver = this->object(receiver - 1, ObjectKind::INSTANCE).instance;
+                    }
+                    break;
+                }
+                case ObjectKind::LAMBDA:
+                    static_cast<LoxLambdaWrapper*>(object.callable.get())->closure = environment(in.varint());
+                    break;
+                case ObjectKind::CLASS: {
+                    std::optional<SharedCallablePtr> superclass = std::nullopt;
+                    uint64_t superclassReference = in.varint();
+                    if (superclassReference != 0){
+                        superclass = this->object(superclassReference - 1, ObjectKind::CLASS).callable;
+                    }
+
+                    //The table was written flattened, so it doesn't matter whether the superclass has been filled in yet
+                    std::unordered_map<std::string, std::shared_ptr<LoxFunction>> methods;
+                    size_t count = in.varint();
+                    for (size_t i = 0; i < count; i++){
+                        std::string name(in.string());
+                        methods[name] = std::static_pointer_cast<LoxFunction>(this->object(in.varint(), ObjectKind::FUNCTION).callable);
+                    }
+                    static_cast<LoxClass*>(object.callable.get())->setMethods(methods, superclass);
+                    break;
+                }
+                case ObjectKind::NATIVE:
+                    break;
+                case ObjectKind::INSTANCE: {
+                    size_t count = in.varint();
+                    for (size_t i = 0; i < count; i++){
+                        Token name(TokenType::IDENTIFIER, std::string(in.string()), -1);
+                        object.instance->setProperty(name, readValue(in));
+                    }
+                    break;
+                }
+                case ObjectKind::LIST: {
+                    size_t count = in.varint();
+                    for (size_t i = 0; i < count; i++){
+                        object.list->append(readValue(in));
+                    }
+                    break;
+                }
+            }
+        }
+
+        LoxObject readValue(binary::Reader &in) {
+            auto type = (LoxType) in.u8();
+            switch (type) {
+                case LoxType::NIL:
+                    return LoxObject::Nil();
+                case LoxType::BOOL:
+                    return LoxObject((bool) in.u8());
+                case LoxType::NUMBER:
+                    return LoxObject(in.number());
+                case LoxType::STRING:
+                    return LoxObject(std::string(in.string()));
+                case LoxType::CALLABLE: {
+                    uint64_t id = in.varint();
+                    if (id >= objects.size() || !objects[id].callable) throw binary::FormatError("Invalid object reference");
+                    return LoxObject(objects[id].callable);
+                }
+                case LoxType::INSTANCE:
+                    return LoxObject(object(in.varint(), ObjectKind::INSTANCE).instance);
+                case LoxType::LIST:
+                    return LoxObject(object(in.varint(), ObjectKind::LIST).list);
+                default:
+                    throw binary::FormatError("Invalid value type");
+            }
+        }
+
+        //Functions created by the tree walker have no compiled body, compile the ones that were loaded (once per declaration)
+        void compileBodies() {
+            ClosureCompiler compiler(interpreter.globals);
+            std::unordered_map<const FunctionDeclStmt*, SharedCompiledBlock> functionBodies;
+            std::unordered_map<const LambdaExpr*, SharedCompiledExpr> lambdaBodies;
+            for (Object &object : objects){
+                if (object.kind == ObjectKind::FUNCTION){
+                    auto* function = static_cast<LoxFunction*>(object.callable.get());
+                    SharedCompiledBlock &body = functionBodies[function->functionDeclStmt];
+                    if (!body) body = compiler.compileFunctionBody(function->functionDeclStmt);
+                    function->compiledBody = body;
+                } else if (object.kind == ObjectKind::LAMBDA){
+                    auto* lambda = static_cast<LoxLambdaWrapper*>(object.callable.get());
+                    SharedCompiledExpr &body = lambdaBodies[lambda->lambdaExpr];
+                    if (!body) body = compiler.compileLambdaBody(lambda->lambdaExpr);
+                    lambda->compiledBody = body;
+                }
+            }
+        }
+    };
+}
+
+
+void Snapshot::create(const std::string &path, const std::vector<std::shared_ptr<const Program>> &programs, Interpreter &interpreter) {
+    SnapshotWriter writer(interpreter);
+    if (!binary::writeFileAtomically(path, writer.write(programs))){
+        throw LoxError("Could not write snapshot " + path);
+    }
+}
+
+std::vector<std::shared_ptr<const Program>> Snapshot::load(const std::string &path, Interpreter &interpreter, bool compile) {
+    binary::MappedFile file(path);
+    if (!file.isOpen()){
+        throw LoxError("Could not open snapshot " + path);
+    }
+
+    try {
+        binary::Reader in(file.data(), file.size());
+        if (std::memcmp(in.raw(sizeof(MAGIC)), MAGIC, sizeof(MAGIC)) != 0 || in.u32() != FORMAT_VERSION){
+            throw LoxError(path + " is not a snapshot created by this version of jlox");
+        }
+
+        uint64_t checksum = in.u64();
+        size_t payloadSize = file.size() - (sizeof(MAGIC) + 4 + 8);
+        const uint8_t* payload = in.raw(payloadSize);
+        if (binary::fnv1a(std::string_view(reinterpret_cast<const char*>(payload), payloadSize)) != checksum){
+            throw LoxError("Snapshot " + path + " is corrupted");
+        }
+
+        binary::Reader payloadReader(payload, payloadSize);
+        SnapshotReader reader(interpreter, compile);
+        std::vector<std::shared_ptr<const Program>> programs = reader.read(payloadReader);
+        if (!payloadReader.atEnd()){
+            throw binary::FormatError("Trailing data");
+        }
+        return programs;
+    } catch (const binary::FormatError &error) {
+        throw LoxError("Snapshot " + path + " is corrupted: " + error.what());
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef JLOX_SNAPSHOT_H
+#define JLOX_SNAPSHOT_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Program.h"
+
+class Interpreter;
+
+/*Image of the global state of an interpreter, so scripts that all start by declaring the same library (a prelude) don't have to run it
+ * every time. Run the prelude once with "jlox --snapshot-create prelude.img prelude.lox" and then start every script with
+ * "jlox --snapshot prelude.img script.lox".
+ *
+ * The image contains the programs that were run (in the AstSerializer format) and every value reachable from the globals: data, lists,
+ * instances, functions, lambdas and classes together with the environments they close over. Functions, lambdas and lists refer to
+ * their AST node by its preorder id (see AstSerializer::serialize). Native functions are stored by name and must be builtins.
+ * Loading maps the file, rebuilds the AST and then the object graph in two passes (objects first, references between them second) so
+ * cycles and shared objects are preserved.
+ * */
+class Snapshot {
+public:
+    //Bump it whenever the format changes or AstCache::FORMAT_VERSION is bumped
+    static constexpr uint32_t FORMAT_VERSION = 4;
+
+    //Throws LoxError if a global can't be stored
+    static void create(const std::string &path, const std::vector<std::shared_ptr<const Program>> &programs, Interpreter &interpreter);
+    /*Defines the globals stored in the image in interpreter. The returned programs own the AST the globals point into, so they must
+     * live as long as the interpreter. If compile is true the bodies of the functions are compiled by the ClosureCompiler.
+     * Throws LoxError if the image can't be read.*/
+    static std::vector<std::shared_ptr<const Program>> load(const std::string &path, Interpreter &interpreter, bool compile);
+};
+
+
+#endif //JLOX_SNAPSHOT_H
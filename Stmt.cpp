@@ -55,6 +55,14 @@ void ForStmt::accept(StmtVisitor &visitor) {
 }
 
 
+ForInStmt::ForInStmt(const Token &name, UniqueExprPtr iterable, UniqueStmtPtr body)
+: name(name), iterable(std::move(iterable)), body(std::move(body)) {}
+
+void ForInStmt::accept(StmtVisitor &visitor) {
+    visitor.visit(this);
+}
+
+
 BreakStmt::BreakStmt(const Token &keyword) : keyword(keyword) {}
 
 void BreakStmt::accept(StmtVisitor &visitor) {
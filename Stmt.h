@@ -15,6 +15,7 @@ class BlockStmt;
 class IfStmt;
 class WhileStmt;
 class ForStmt;
+class ForInStmt;
 class BreakStmt;
 class ContinueStmt;
 class FunctionDeclStmt;
@@ -34,6 +35,7 @@ public:
     virtual void visit(const BreakStmt *breakStmt) = 0;
     virtual void visit(const ContinueStmt *continueStmt) = 0;
     virtual void visit(const ForStmt *forStmt) = 0;
+    virtual void visit(const ForInStmt *forInStmt) = 0;
     virtual void visit(const FunctionDeclStmt *functionStmt) = 0;
     virtual void visit(const ReturnStmt *returnStmt) = 0;
     virtual void visit(const ClassDeclStmt *classDeclStmt) = 0;
@@ -117,6 +119,17 @@ public:
     void accept(StmtVisitor &visitor) override;
 };
 
+//for (name in iterable) body. See LoxIterator::forEach for what can be iterated
+class ForInStmt : public Stmt {
+public:
+    Token name;
+    UniqueExprPtr iterable;
+    UniqueStmtPtr body;
+
+    ForInStmt(const Token &name, UniqueExprPtr iterable, UniqueStmtPtr body);
+    void accept(StmtVisitor &visitor) override;
+};
+
 class BreakStmt : public Stmt {
 public:
     Token keyword;
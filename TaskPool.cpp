@@ -0,0 +1,355 @@
+#include "TaskPool.h"
+#include <algorithm>
+#include <unordered_map>
+#include "Environment.h"
+#include "Interpreter.h"
+#include "LoxClass.h"
+#include "LoxError.h"
+#include "LoxFunction.h"
+#include "LoxList.h"
+#include "Token.h"
+#include "ValueCopier.h"
+#include "standardlib/NativeFunction.h"
+
+namespace {
+    //Worker of the current thread, nullptr outside of a pool
+    thread_local void* currentWorker = nullptr;
+
+    //Functions and classes declared in the outermost scope, which tasks can use without copying them every time
+    bool isDeclaration(const LoxObject &value, const Environment::SharedPtr &globalEnv) {
+        if (!value.isCallable()) return false;
+
+        LoxCallable* callable = value.getCallable().get();
+        if (auto* function = dynamic_cast<LoxFunction*>(callable)){
+            return function->closure == globalEnv && !function->receiver;
+        }
+        if (auto* lambda = dynamic_cast<LoxLambdaWrapper*>(callable)){
+            return lambda->closure == globalEnv;
+        }
+        if (auto* loxClass = dynamic_cast<LoxClass*>(callable)){
+            //Methods close over the global environment, or over the one that only defines "super"
+            for (const auto &[name, method] : loxClass->methods){
+                const Environment::SharedPtr &closure = method->closure;
+                if (closure != globalEnv && (closure->parent() != globalEnv || closure->getVariables().size() != 1)) return false;
+            }
+            return true;
+        }
+        return false;
+    }
+}
+
+
+TaskPool::TaskPool(size_t workerCount) {
+    if (workerCount == 0){
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (size_t i = 0; i < workerCount; i++){
+        auto worker = std::make_unique<Worker>();
+        worker->pool = this;
+        worker->interpreter = std::make_unique<Interpreter>(worker->output);
+        workers.push_back(std::move(worker));
+    }
+    //Started once every worker exists, since they steal from each other
+    for (const std::unique_ptr<Worker> &worker : workers){
+        worker->thread = std::thread(&TaskPool::run, this, std::ref(*worker));
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping.store(true);
+    }
+    workAvailable.notify_all();
+    for (const std::unique_ptr<Worker> &worker : workers){
+        worker->thread.join();
+    }
+}
+
+LoxObject TaskPool::submit(Interpreter &interpreter, const SharedCallablePtr &function, LoxArguments arguments) {
+    ValueCopier copier(interpreter, nullptr, true);
+    LoxObject functionCopy = copier.copy(LoxObject(function));
+    std::vector<LoxObject> argumentCopies;
+    argumentCopies.reserve(arguments.size());
+    for (const LoxObject &argument : arguments){
+        argumentCopies.push_back(copier.copy(argument));
+    }
+
+    auto task = std::make_shared<Task>();
+    task->work = [functionCopy, argumentCopies](Interpreter &worker) mutable {
+        return worker.call(functionCopy, argumentCopies, Token(TokenType::IDENTIFIER, "task", -1));
+    };
+    schedule(interpreter, {task});
+    return makeHandle(task);
+}
+
+LoxObject TaskPool::map(Interpreter &interpreter, const SharedListPtr &list, const SharedCallablePtr &function) {
+    std::vector<std::shared_ptr<Task>> chunks = split(interpreter, list->getItems(), function,
+            [](Interpreter &worker, const LoxObject &function, LoxArguments items, size_t first) {
+        std::vector<LoxObject> results;
+        results.reserve(items.size());
+        for (size_t i = 0; i < items.size(); i++){
+            try {
+                results.push_back(worker.call(function, items.subspan(i, 1), Token(TokenType::IDENTIFIER, "parallel_map", -1)));
+            } catch (const LoxError &exception) {
+                throw LoxRuntimeError("parallel_map failed on item " + std::to_string(first + i) + ": " + exception.what());
+            }
+        }
+        return LoxObject(std::make_shared<LoxList>(nullptr, results));
+    });
+
+    //In order, so the output and the reported error are the same as if the items were mapped one after the other
+    std::vector<LoxObject> results;
+    results.reserve(list->getItems().size());
+    for (const std::shared_ptr<Task> &chunk : chunks){
+        wait(interpreter, *chunk);
+        if (chunk->error) std::rethrow_exception(chunk->error);
+        const std::vector<LoxObject> &chunkResults = chunk->result.getList()->getItems();
+        results.insert(results.end(), chunkResults.begin(), chunkResults.end());
+    }
+    return LoxObject(std::make_shared<LoxList>(nullptr, results));
+}
+
+//Every chunk is folded on its own starting from its first item, the partial results are folded into initial by the caller
+LoxObject TaskPool::reduce(Interpreter &interpreter, const SharedListPtr &list, const SharedCallablePtr &function, const LoxObject &initial) {
+    std::vector<std::shared_ptr<Task>> chunks = split(interpreter, list->getItems(), function,
+            [](Interpreter &worker, const LoxObject &function, LoxArguments items, size_t first) {
+        std::vector<LoxObject> arguments{items[0], LoxObject()};
+        for (size_t i = 1; i < items.size(); i++){
+            arguments[1] = items[i];
+            try {
+                arguments[0] = worker.call(function, arguments, Token(TokenType::IDENTIFIER, "parallel_reduce", -1));
+            } catch (const LoxError &exception) {
+                throw LoxRuntimeError("parallel_reduce failed on item " + std::to_string(first + i) + ": " + exception.what());
+            }
+        }
+        return arguments[0];
+    });
+
+    std::vector<LoxObject> arguments{initial, LoxObject()};
+    Token token(TokenType::IDENTIFIER, "parallel_reduce", -1);
+    for (const std::shared_ptr<Task> &chunk : chunks){
+        wait(interpreter, *chunk);
+        if (chunk->error) std::rethrow_exception(chunk->error);
+        arguments[1] = chunk->result;
+        arguments[0] = interpreter.call(LoxObject(function), arguments, token);
+    }
+    return arguments[0];
+}
+
+//A few chunks per worker, so the workers that finish first can steal the rest
+std::vector<std::shared_ptr<TaskPool::Task>> TaskPool::split(Interpreter &interpreter, const std::vector<LoxObject> &items, const SharedCallablePtr &function,
+        const std::function<LoxObject(Interpreter&, const LoxObject&, LoxArguments, size_t)> &chunk) {
+    size_t chunkCount = std::min(items.size(), current(interpreter).workers.size() * 4);
+    std::vector<std::shared_ptr<Task>> tasks;
+    tasks.reserve(chunkCount);
+
+    for (size_t i = 0; i < chunkCount; i++){
+        size_t first = items.size() * i / chunkCount, last = items.size() * (i + 1) / chunkCount;
+        //Every chunk gets its own copies, tasks share nothing that can be modified
+        ValueCopier copier(interpreter, nullptr, true);
+        LoxObject functionCopy = copier.copy(LoxObject(function));
+        std::vector<LoxObject> itemCopies;
+        itemCopies.reserve(last - first);
+        for (size_t j = first; j < last; j++){
+            itemCopies.push_back(copier.copy(items[j]));
+        }
+
+        auto task = std::make_shared<Task>();
+        task->work = [chunk, functionCopy, itemCopies, first](Interpreter &worker) mutable {
+            return chunk(worker, functionCopy, itemCopies, first);
+        };
+        tasks.push_back(std::move(task));
+    }
+
+    schedule(interpreter, tasks);
+    return tasks;
+}
+
+bool TaskPool::onWorker() {
+    return currentWorker != nullptr;
+}
+
+TaskPool& TaskPool::current(Interpreter &interpreter) {
+    if (currentWorker != nullptr){
+        return *static_cast<Worker*>(currentWorker)->pool;
+    }
+    if (!interpreter.taskPool){
+        interpreter.taskPool = std::make_shared<TaskPool>();
+    }
+    return *interpreter.taskPool;
+}
+
+//Tasks created by a task go to the deque of its worker and see the same globals, the other ones are dealt to the workers in turn
+void TaskPool::schedule(Interpreter &interpreter, const std::vector<std::shared_ptr<Task>> &tasks) {
+    TaskPool &pool = current(interpreter);
+    auto* worker = static_cast<Worker*>(currentWorker);
+    std::shared_ptr<const Globals> taskGlobals = worker != nullptr ? worker->runningGlobals : pool.currentGlobals(interpreter);
+
+    for (const std::shared_ptr<Task> &task : tasks){
+        task->globals = taskGlobals;
+        pool.push(worker != nullptr ? *worker : *pool.workers[pool.nextWorker++ % pool.workers.size()], task);
+    }
+}
+
+void TaskPool::push(Worker &worker, std::shared_ptr<Task> task) {
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+    queued.fetch_add(1);
+    //Taking the lock makes sure a worker that just saw queued == 0 is already waiting, so it gets the notification
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    workAvailable.notify_one();
+}
+
+std::shared_ptr<TaskPool::Task> TaskPool::findTask(Worker &worker) {
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.tasks.empty()){
+            std::shared_ptr<Task> task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+            queued.fetch_sub(1);
+            return task;
+        }
+    }
+
+    size_t index = 0;
+    while (workers[index].get() != &worker) index++;
+    for (size_t i = 1; i < workers.size(); i++){
+        Worker &victim = *workers[(index + i) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()){
+            std::shared_ptr<Task> task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued.fetch_sub(1);
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+void TaskPool::run(Worker &worker) {
+    currentWorker = &worker;
+    while (!stopping.load()){
+        if (std::shared_ptr<Task> task = findTask(worker)){
+            execute(worker, *task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        workAvailable.wait(lock, [this] { return stopping.load() || queued.load() > 0; });
+    }
+    //Whatever the tasks left in the heap of the worker is released on its own thread
+    worker.interpreter.reset();
+}
+
+void TaskPool::execute(Worker &worker, Task &task) {
+    Interpreter &interpreter = *worker.interpreter;
+    //A worker can run a task while it is joining another one, keep the output of that one apart
+    interpreter.flushOutput();
+    std::string outerOutput = worker.output.str();
+    worker.output.str("");
+
+    loadGlobals(worker, task.globals);
+    std::shared_ptr<const Globals> outerGlobals = std::exchange(worker.runningGlobals, task.globals);
+    try {
+        task.result = ValueCopier(interpreter, nullptr).copy(task.work(interpreter));
+    } catch (const LoxError &) {
+        task.error = std::current_exception();
+    }
+    worker.runningGlobals = std::move(outerGlobals);
+    task.work = nullptr;
+
+    interpreter.flushOutput();
+    task.output = worker.output.str();
+    worker.output.str(outerOutput);
+    worker.output.seekp(0, std::ios::end);
+
+    {
+        std::lock_guard<std::mutex> lock(task.mutex);
+        task.done.store(true);
+    }
+    task.finished.notify_all();
+}
+
+//Globals are read only in the workers: the tasks that share them run on several threads at once
+void TaskPool::loadGlobals(Worker &worker, const std::shared_ptr<const Globals> &taskGlobals) {
+    if (worker.loadedGlobals == taskGlobals || taskGlobals == nullptr) return;
+
+    for (const auto &[name, value] : taskGlobals->values){
+        GlobalEnvironment::Cell* cell = worker.interpreter->globals.cell(name);
+        cell->value = value;
+        cell->defined = true;
+        cell->readOnly = true;
+    }
+    worker.loadedGlobals = taskGlobals;
+}
+
+//The copies are only made again when the declarations changed since the last task
+std::shared_ptr<const TaskPool::Globals> TaskPool::currentGlobals(Interpreter &owner) {
+    std::vector<const GlobalEnvironment::Cell*> declarations;
+    std::vector<const LoxCallable*> originals;
+    for (const GlobalEnvironment::Cell &cell : owner.globals.getCells()){
+        if (cell.defined && isDeclaration(cell.value, owner.globalEnv)){
+            declarations.push_back(&cell);
+            originals.push_back(cell.value.getCallable().get());
+        }
+    }
+    if (globals && globals->originals == originals){
+        return globals;
+    }
+
+    auto newGlobals = std::make_shared<Globals>();
+    ValueCopier copier(owner, nullptr, true);
+    for (const GlobalEnvironment::Cell* cell : declarations){
+        newGlobals->values.emplace_back(cell->name, copier.copy(cell->value));
+    }
+    newGlobals->originals = std::move(originals);
+    globals = std::move(newGlobals);
+    return globals;
+}
+
+void TaskPool::wait(Interpreter &interpreter, Task &task) {
+    if (currentWorker != nullptr){
+        auto* worker = static_cast<Worker*>(currentWorker);
+        while (!task.done.load()){
+            if (std::shared_ptr<Task> other = worker->pool->findTask(*worker)){
+                worker->pool->execute(*worker, *other);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    } else {
+        std::unique_lock<std::mutex> lock(task.mutex);
+        task.finished.wait(lock, [&task] { return task.done.load(); });
+    }
+
+    if (!task.output.empty()){
+        interpreter.getOutput() << task.output;
+        task.output.clear();
+    }
+}
+
+LoxObject TaskPool::join(Interpreter &interpreter, const std::shared_ptr<Task> &task) {
+    wait(interpreter, *task);
+    if (task->error){
+        try {
+            std::rethrow_exception(task->error);
+        } catch (const LoxError &exception) {
+            throw LoxRuntimeError("Task failed: " + std::string(exception.what()));
+        }
+    }
+    return task->result;
+}
+
+//Like the handle of an isolate, the future is an instance whose join field is a native function, so it can't be copied into a task
+LoxObject TaskPool::makeHandle(const std::shared_ptr<Task> &task) {
+    auto loxClass = std::make_shared<LoxClass>("Task", std::unordered_map<std::string, std::shared_ptr<LoxFunction>>(), std::nullopt);
+    auto handle = std::make_shared<LoxClassInstance>(loxClass);
+    handle->setProperty(Token(TokenType::IDENTIFIER, "join", -1), LoxObject(standardFunctions::makeNative("join", [task](Interpreter &interpreter) {
+        return join(interpreter, task);
+    })));
+    return LoxObject(handle);
+}
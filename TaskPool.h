@@ -0,0 +1,120 @@
+#ifndef JLOX_TASKPOOL_H
+#define JLOX_TASKPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "LoxCallable.h"
+#include "LoxObject.h"
+
+class Interpreter;
+
+/*Fork-join parallelism for pure functions. task(function, args...) queues a call of function on a pool of worker threads and returns
+ * a future whose join() method waits for the call and returns (a copy of) its result, or reports its runtime error.
+ *
+ * Every worker runs tasks on its own Interpreter, so Environment and LoxObject stay single threaded. The function and the arguments are
+ * copied when the task is created (see ValueCopier.h), and the scopes the function closes over are frozen: a task can only modify its
+ * own variables and its arguments. Besides that it only sees the functions and classes declared in the outermost scope of the program,
+ * which are read only in the workers. Anything else (e.g. reading a global variable or assigning a captured one) fails at runtime.
+ * What a task prints is written to the output of whoever joins it. The workers only run on the tree walker.
+ *
+ * Every worker has a deque of tasks. A task created by a worker goes to the back of its own deque and the worker takes its next task
+ * from the back too (so it works depth first, on the data it just touched), idle workers steal from the front of the other deques
+ * (the oldest, usually biggest, tasks). A worker that joins a task which hasn't finished runs other tasks meanwhile instead of blocking,
+ * so recursive divide and conquer can't run out of threads. Tasks created outside of the pool are dealt to the workers in turn.
+ *
+ * parallel_map and parallel_reduce split a list into contiguous chunks and run one task per chunk, the results are put back together in
+ * order. Like task(), the function must be pure; for parallel_reduce it must also be associative. If several items fail, the error of
+ * the first one is reported, so the outcome doesn't depend on the scheduling.
+ *
+ * The pool of an interpreter is created by its first task() call and stopped when the interpreter is destroyed.
+ * */
+class TaskPool {
+public:
+    //Starts one worker per core if workerCount is 0
+    explicit TaskPool(size_t workerCount = 0);
+    ~TaskPool();
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    //Implements task(function, args...)
+    static LoxObject submit(Interpreter &interpreter, const SharedCallablePtr &function, LoxArguments arguments);
+    //Implements parallel_map(list, function): a new list with function applied to every item
+    static LoxObject map(Interpreter &interpreter, const SharedListPtr &list, const SharedCallablePtr &function);
+    //Implements parallel_reduce(list, function, initial): function(...function(function(initial, a), b)..., z)
+    static LoxObject reduce(Interpreter &interpreter, const SharedListPtr &list, const SharedCallablePtr &function, const LoxObject &initial);
+    //True on the threads of a pool, i.e. inside a task
+    static bool onWorker();
+
+private:
+    //Read only copies of the functions and classes declared in the outermost scope of the interpreter that owns the pool
+    struct Globals {
+        std::vector<std::pair<std::string, LoxObject>> values;
+        std::vector<const LoxCallable*> originals;
+    };
+
+    struct Task {
+        //Runs on a worker, only holds copies (see ValueCopier.h). Released once it ran
+        std::function<LoxObject(Interpreter&)> work;
+        std::shared_ptr<const Globals> globals;
+        //Written by the worker before it sets done. error holds the LoxError thrown by work
+        LoxObject result;
+        std::exception_ptr error;
+        std::string output;
+        std::atomic<bool> done{false};
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+
+    struct Worker {
+        TaskPool* pool;
+        std::unique_ptr<Interpreter> interpreter;
+        std::ostringstream output;
+        std::mutex mutex;
+        std::deque<std::shared_ptr<Task>> tasks;
+        //Globals defined in interpreter, and the ones of the task that is running (tasks it creates inherit them)
+        std::shared_ptr<const Globals> loadedGlobals, runningGlobals;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    //Only used by the thread of the interpreter that owns the pool
+    std::shared_ptr<const Globals> globals;
+    size_t nextWorker = 0;
+    //Tasks waiting in the deques. Idle workers sleep on workAvailable until it isn't 0
+    std::atomic<size_t> queued{0};
+    std::atomic<bool> stopping{false};
+    std::mutex sleepMutex;
+    std::condition_variable workAvailable;
+
+    //Pool of the current worker, or the one of interpreter (started if needed)
+    static TaskPool& current(Interpreter &interpreter);
+    static void schedule(Interpreter &interpreter, const std::vector<std::shared_ptr<Task>> &tasks);
+    void push(Worker &worker, std::shared_ptr<Task> task);
+    std::shared_ptr<Task> findTask(Worker &worker);
+    void run(Worker &worker);
+    void execute(Worker &worker, Task &task);
+    void loadGlobals(Worker &worker, const std::shared_ptr<const Globals> &taskGlobals);
+    std::shared_ptr<const Globals> currentGlobals(Interpreter &owner);
+    //Waits for the task and writes its output to interpreter
+    static void wait(Interpreter &interpreter, Task &task);
+    static LoxObject join(Interpreter &interpreter, const std::shared_ptr<Task> &task);
+    //Tasks that apply function to consecutive slices of items, each one returns what the call of chunk returns
+    static std::vector<std::shared_ptr<Task>> split(Interpreter &interpreter, const std::vector<LoxObject> &items, const SharedCallablePtr &function,
+            const std::function<LoxObject(Interpreter&, const LoxObject&, LoxArguments, size_t)> &chunk);
+    static LoxObject makeHandle(const std::shared_ptr<Task> &task);
+};
+
+
+#endif //JLOX_TASKPOOL_H
@@ -0,0 +1,212 @@
+#include "ValueCopier.h"
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "ClosureCompiler.h"
+#include "Interpreter.h"
+#include "LoxClass.h"
+#include "LoxError.h"
+#include "LoxFunction.h"
+#include "LoxList.h"
+#include "Memoize.h"
+#include "Token.h"
+
+namespace {
+    bool isNative(LoxCallable* callable) {
+        return dynamic_cast<LoxFunction*>(callable) == nullptr && dynamic_cast<LoxLambdaWrapper*>(callable) == nullptr &&
+               dynamic_cast<LoxClass*>(callable) == nullptr && dynamic_cast<MemoizedFunction*>(callable) == nullptr;
+    }
+}
+
+ValueCopier::ValueCopier(Interpreter &from, Interpreter &to)
+    : from(from), to(&to), toGlobalEnv(to.globalEnv), compiler(std::make_unique<ClosureCompiler>(to.globals)) {}
+
+ValueCopier::ValueCopier(Interpreter &from, Environment::SharedPtr toGlobalEnv, bool freeze)
+    : from(from), toGlobalEnv(std::move(toGlobalEnv)), freeze(freeze) {}
+
+ValueCopier::~ValueCopier() = default;
+
+LoxObject ValueCopier::copy(const LoxObject &value) {
+    switch (value.type) {
+        case LoxType::CALLABLE:
+            return LoxObject(copyCallable(value.getCallable()));
+        case LoxType::INSTANCE:
+            return LoxObject(copyInstance(value.getClassInstance()));
+        case LoxType::LIST:
+            return LoxObject(copyList(value.getList()));
+        default:
+            return value; //nil, booleans, numbers and strings are held by value
+    }
+}
+
+void ValueCopier::copyGlobals() {
+    for (const GlobalEnvironment::Cell &cell : from.globals.getCells()){
+        const GlobalEnvironment::Cell* existing = to->globals.find(cell.name);
+        if (!cell.defined || (existing != nullptr && existing->defined)) continue;
+        if (cell.value.isCallable() && isNative(cell.value.getCallable().get())) continue;
+
+        size_t mark = created.size();
+        try {
+            to->globals.define(cell.name, copy(cell.value));
+        } catch (const LoxRuntimeError&) {
+            //Forget the half copied objects, so a later copy of something they refer to doesn't return them
+            for (size_t i = mark; i < created.size(); i++){
+                copies.erase(created[i]);
+                environments.erase(static_cast<const Environment*>(created[i]));
+            }
+            created.resize(mark);
+        }
+    }
+}
+
+//Objects are registered in copies before their children are copied, so a child that refers back to its parent finds the copy
+SharedCallablePtr ValueCopier::copyCallable(const SharedCallablePtr &callable) {
+    auto it = copies.find(callable.get());
+    if (it != copies.end()){
+        return it->second.getCallable();
+    }
+
+    if (auto* function = dynamic_cast<LoxFunction*>(callable.get())){
+        auto functionCopy = std::make_shared<LoxFunction>(function->functionDeclStmt, nullptr, function->isConstructor);
+        remember(function, LoxObject(functionCopy));
+        functionCopy->closure = copyEnvironment(function->closure);
+        if (function->receiver){
+            functionCopy->receiver = copyInstance(function->receiver);
+        }
+        if (function->compiledBody && compiler){
+            SharedCompiledBlock &body = functionBodies[function->functionDeclStmt];
+            if (!body) body = compiler->compileFunctionBody(function->functionDeclStmt);
+            functionCopy->compiledBody = body;
+        }
+        return functionCopy;
+    }
+
+    if (auto* lambda = dynamic_cast<LoxLambdaWrapper*>(callable.get())){
+        auto lambdaCopy = std::make_shared<LoxLambdaWrapper>(lambda->lambdaExpr, nullptr);
+        remember(lambda, LoxObject(lambdaCopy));
+        lambdaCopy->closure = copyEnvironment(lambda->closure);
+        if (lambda->compiledBody && compiler){
+            SharedCompiledExpr &body = lambdaBodies[lambda->lambdaExpr];
+            if (!body) body = compiler->compileLambdaBody(lambda->lambdaExpr);
+            lambdaCopy->compiledBody = body;
+        }
+        return lambdaCopy;
+    }
+
+    if (auto* loxClass = dynamic_cast<LoxClass*>(callable.get())){
+        //Methods can refer back to their class, so it is created empty and filled in afterwards (like Snapshot does)
+        auto classCopy = std::make_shared<LoxClass>(loxClass->className, std::unordered_map<std::string, std::shared_ptr<LoxFunction>>(), std::nullopt);
+        remember(loxClass, LoxObject(std::static_pointer_cast<LoxCallable>(classCopy)));
+        std::optional<SharedCallablePtr> superclass = std::nullopt;
+        if (loxClass->superclass.has_value()){
+            superclass = copyCallable(loxClass->superclass.value());
+        }
+        std::unordered_map<std::string, std::shared_ptr<LoxFunction>> methods;
+        for (const auto &[name, method] : loxClass->methods){
+            methods[name] = std::static_pointer_cast<LoxFunction>(copyCallable(method));
+        }
+        classCopy->setMethods(methods, superclass);
+        return classCopy;
+    }
+
+    //The copy starts with an empty cache, the cached values belong to the other heap
+    if (auto* memoized = dynamic_cast<MemoizedFunction*>(callable.get())){
+        auto memoizedCopy = std::make_shared<MemoizedFunction>(nullptr, memoized->capacity);
+        remember(memoized, LoxObject(std::static_pointer_cast<LoxCallable>(memoizedCopy)));
+        memoizedCopy->function = copyCallable(memoized->function);
+        return memoizedCopy;
+    }
+
+    return copyNative(callable);
+}
+
+//Natives can hold state that belongs to their interpreter (e.g. the methods of an isolate handle), only stateless builtins are copied
+SharedCallablePtr ValueCopier::copyNative(const SharedCallablePtr &native) {
+    std::string name = native->name();
+    const GlobalEnvironment::Cell* builtin = to != nullptr && isBuiltin(native) ? to->globals.find(name) : nullptr;
+    if (builtin == nullptr || !builtin->defined || !builtin->value.isCallable()){
+        throw LoxRuntimeError("Cannot copy native function '" + name + "' to another isolate");
+    }
+
+    SharedCallablePtr copy = builtin->value.getCallable();
+    remember(native.get(), LoxObject(copy));
+    return copy;
+}
+
+SharedInstancePtr ValueCopier::copyInstance(const SharedInstancePtr &instance) {
+    auto it = copies.find(instance.get());
+    if (it != copies.end()){
+        return it->second.getClassInstance();
+    }
+
+    auto loxClass = std::static_pointer_cast<LoxClass>(copyCallable(instance->getClass()));
+    //The methods of the class may have reached this instance through their closure
+    it = copies.find(instance.get());
+    if (it != copies.end()){
+        return it->second.getClassInstance();
+    }
+
+    auto instanceCopy = std::make_shared<LoxClassInstance>(loxClass);
+    remember(instance.get(), LoxObject(instanceCopy));
+    for (const auto &[name, value] : instance->getFields()){
+        instanceCopy->setProperty(Token(TokenType::IDENTIFIER, name, -1), copy(value));
+    }
+    return instanceCopy;
+}
+
+SharedListPtr ValueCopier::copyList(const SharedListPtr &list) {
+    auto it = copies.find(list.get());
+    if (it != copies.end()){
+        return it->second.getList();
+    }
+
+    auto listCopy = std::make_shared<LoxList>(list->getDeclaration(), std::vector<LoxObject>());
+    remember(list.get(), LoxObject(listCopy));
+    for (const LoxObject &item : list->getItems()){
+        listCopy->append(copy(item));
+    }
+    return listCopy;
+}
+
+Environment::SharedPtr ValueCopier::copyEnvironment(const Environment::SharedPtr &environment) {
+    if (environment == nullptr){
+        return nullptr;
+    }
+    if (environment == from.globalEnv){
+        return toGlobalEnv;
+    }
+
+    auto it = environments.find(environment.get());
+    if (it != environments.end()){
+        return it->second;
+    }
+
+    Environment::SharedPtr parent = copyEnvironment(environment->parent());
+    //A function stored in an enclosing scope may close over this environment
+    it = environments.find(environment.get());
+    if (it != environments.end()){
+        return it->second;
+    }
+
+    auto environmentCopy = std::make_shared<Environment>(parent);
+    environments.emplace(environment.get(), environmentCopy);
+    created.push_back(environment.get());
+    for (const auto &[name, value] : environment->getVariables()){
+        environmentCopy->define(name, copy(value));
+    }
+    if (freeze){
+        environmentCopy->freeze();
+    }
+    return environmentCopy;
+}
+
+void ValueCopier::remember(const void *original, LoxObject copy) {
+    copies.emplace(original, std::move(copy));
+    created.push_back(original);
+}
+
+bool ValueCopier::isBuiltin(const SharedCallablePtr &callable) const {
+    const GlobalEnvironment::Cell* cell = from.globals.find(callable->name());
+    return cell != nullptr && cell->defined && cell->value.isCallable() && cell->value.getCallable() == callable;
+}
@@ -0,0 +1,66 @@
+#ifndef JLOX_VALUECOPIER_H
+#define JLOX_VALUECOPIER_H
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "Environment.h"
+#include "LoxObject.h"
+#include "typedefs.h"
+
+class ClosureCompiler;
+class FunctionDeclStmt;
+class Interpreter;
+class LambdaExpr;
+
+/*Deep copies values from the heap of one interpreter into the heap of another one, so interpreters running on different threads
+ * never share a LoxObject (see Isolate.h). Everything reachable from a value is copied: lists, instances, classes, functions and the
+ * environments they close over. An object reachable several times is copied once, so sharing and cycles are preserved between all
+ * the values copied by the same ValueCopier.
+ * The AST is immutable and is shared instead of copied (see Program.h), so the programs it belongs to must outlive both interpreters.
+ * Functions declared in the outermost scope are rebound to the global environment of the destination, so the globals they use are
+ * looked up in the destination when they run.
+ * */
+class ValueCopier {
+public:
+    /*Copies into to, which must not be running on another thread. Builtin native functions become the builtin with the same name in
+     * to, and functions compiled by the ClosureCompiler are compiled again for to (compiled code is bound to the globals of its interpreter).*/
+    ValueCopier(Interpreter &from, Interpreter &to);
+    /*Copies for an interpreter that may be running on another thread: only its global environment, which never changes, is used
+     * (nullptr if the copies aren't meant for a single interpreter). The copied functions run on the tree walker and native functions
+     * can't be copied. If freeze is true the copied environments are frozen, see Environment::freeze.*/
+    ValueCopier(Interpreter &from, Environment::SharedPtr toGlobalEnv, bool freeze = false);
+    ~ValueCopier();
+
+    //Throws LoxRuntimeError if the value refers to a native function that can't be copied
+    LoxObject copy(const LoxObject &value);
+    /*Defines in the destination every global of from that isn't defined there yet (needs the first constructor). Globals that can't be
+     * copied are left undefined: native functions that aren't builtins (e.g. registered by a program that embeds the interpreter) and
+     * values that refer to them, like the handle of an isolate.*/
+    void copyGlobals();
+
+private:
+    Interpreter &from;
+    Interpreter* to = nullptr;
+    Environment::SharedPtr toGlobalEnv;
+    std::unique_ptr<ClosureCompiler> compiler;
+    bool freeze = false;
+
+    std::unordered_map<const void*, LoxObject> copies;
+    std::unordered_map<const Environment*, Environment::SharedPtr> environments;
+    std::unordered_map<const FunctionDeclStmt*, SharedCompiledBlock> functionBodies;
+    std::unordered_map<const LambdaExpr*, SharedCompiledExpr> lambdaBodies;
+    //Originals in the order in which they were copied
+    std::vector<const void*> created;
+
+    SharedCallablePtr copyCallable(const SharedCallablePtr &callable);
+    SharedCallablePtr copyNative(const SharedCallablePtr &native);
+    SharedInstancePtr copyInstance(const SharedInstancePtr &instance);
+    SharedListPtr copyList(const SharedListPtr &list);
+    Environment::SharedPtr copyEnvironment(const Environment::SharedPtr &environment);
+    void remember(const void* original, LoxObject copy);
+    bool isBuiltin(const SharedCallablePtr &callable) const;
+};
+
+
+#endif //JLOX_VALUECOPIER_H
@@ -0,0 +1,124 @@
+#include "WorkerPool.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "Interpreter.h"
+#include "LoxError.h"
+
+
+WorkerPool::WorkerPool(Runner &zygote, int workers) : zygote(zygote), workers(std::max(workers, 1)) {}
+
+int WorkerPool::run(const std::vector<std::string> &scripts, std::ostream &output) {
+    if (!zygote.loadSnapshot()){
+        zygote.getInterpreter().flushOutput();
+        return 66;
+    }
+
+    std::vector<Job> jobs(scripts.size());
+    for (size_t i = 0; i < scripts.size(); i++){
+        jobs[i].script = scripts[i];
+    }
+
+    size_t next = 0, written = 0;
+    std::vector<Job*> running;
+    std::vector<pollfd> fds;
+    int exitCode = 0;
+    while (written < jobs.size()){
+        while ((int) running.size() < workers && next < jobs.size()){
+            start(jobs[next]);
+            running.push_back(&jobs[next++]);
+        }
+        running.erase(std::remove_if(running.begin(), running.end(), [](Job* job) { return job->finished; }), running.end());
+
+        fds.clear();
+        for (Job* job : running){
+            fds.push_back({job->pipe, POLLIN, 0});
+        }
+        if (!fds.empty() && ::poll(fds.data(), fds.size(), -1) < 0 && errno != EINTR){
+            break;
+        }
+
+        for (size_t i = 0; i < fds.size(); i++){
+            if (fds[i].revents == 0) continue;
+
+            char buffer[1 << 16];
+            ssize_t received = ::read(fds[i].fd, buffer, sizeof(buffer));
+            if (received > 0){
+                running[i]->output.append(buffer, received);
+            } else if (received == 0 || errno != EINTR){
+                finish(*running[i]);
+            }
+        }
+
+        //Write the output of the scripts that are done, in order
+        for (; written < jobs.size() && jobs[written].finished; written++){
+            output.write(jobs[written].output.data(), jobs[written].output.size());
+            std::string().swap(jobs[written].output);
+            if (exitCode == 0) exitCode = jobs[written].exitCode;
+        }
+        output.flush();
+    }
+
+    return exitCode;
+}
+
+void WorkerPool::start(Job &job) {
+    //Anything still buffered would be written again by every child
+    zygote.getInterpreter().flushOutput();
+    std::cout.flush();
+
+    int fds[2];
+    if (::pipe(fds) < 0){
+        job.output = "Could not create a pipe for " + job.script + "\n";
+        job.exitCode = 71;
+        job.finished = true;
+        return;
+    }
+
+    job.pid = ::fork();
+    if (job.pid == 0){
+        ::close(fds[0]);
+        ::dup2(fds[1], STDOUT_FILENO);
+        ::dup2(fds[1], STDERR_FILENO);
+        ::close(fds[1]);
+
+        int exitCode;
+        try {
+            exitCode = zygote.runScript(job.script);
+        } catch (const LoxError &exception) { //File not found
+            std::cout << exception.what() << "\n";
+            exitCode = 66;
+        }
+        std::cout.flush();
+        ::_exit(exitCode); //Skips the destructors of the zygote's copy, the output has already been flushed
+    }
+
+    ::close(fds[1]);
+    if (job.pid < 0){
+        ::close(fds[0]);
+        job.output = "Could not start a worker for " + job.script + "\n";
+        job.exitCode = 71;
+        job.finished = true;
+        return;
+    }
+    job.pipe = fds[0];
+}
+
+//Called once the child closed its end of the pipe
+void WorkerPool::finish(Job &job) {
+    ::close(job.pipe);
+    int status = 0;
+    while (::waitpid(job.pid, &status, 0) < 0 && errno == EINTR) {}
+
+    if (WIFEXITED(status)){
+        job.exitCode = WEXITSTATUS(status);
+    } else {
+        job.exitCode = 128 + WTERMSIG(status);
+        job.output += job.script + " was killed by signal " + std::to_string(WTERMSIG(status)) + "\n";
+    }
+    job.finished = true;
+}
@@ -0,0 +1,39 @@
+#ifndef JLOX_WORKERPOOL_H
+#define JLOX_WORKERPOOL_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Runner.h"
+
+/*Batch mode: "jlox --workers N script1.lox script2.lox ..." (or with the paths of the scripts on stdin).
+ * The runner is initialized once (builtins, snapshot) and acts as a zygote: every script runs in a process forked from it, so the
+ * scripts start from a copy-on-write copy of that state instead of paying for it again, and can't affect each other. At most N of
+ * them run at the same time. The output of every script is collected through a pipe and written in the order of the scripts.
+ * */
+class WorkerPool {
+public:
+    WorkerPool(Runner &zygote, int workers);
+
+    //Returns the first non zero exit code of the scripts (in their order), or 0 if they all succeeded
+    int run(const std::vector<std::string> &scripts, std::ostream &output);
+
+private:
+    struct Job {
+        std::string script;
+        int pid = -1;
+        int pipe = -1;
+        std::string output;
+        int exitCode = 0;
+        bool finished = false;
+    };
+
+    Runner &zygote;
+    int workers;
+
+    void start(Job &job);
+    void finish(Job &job);
+};
+
+
+#endif //JLOX_WORKERPOOL_H
@@ -1,33 +1,88 @@
-//#define DEBUG
-
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
 #include <memory>
+#include <string>
+#include <vector>
+#include "AstCache.h"
+#include "FileReader.h"
 #include "Runner.h"
+#include "Server.h"
+#include "WorkerPool.h"
 
-#ifdef DEBUG
-#include "gtest/gtest.h"
-#endif
+namespace {
+    Server* runningServer = nullptr;
 
-int main(int argc, char *argv[]) {
-#ifdef DEBUG
-    ::testing::InitGoogleTest(&argc, argv);
-#endif
+    //SIGINT and SIGTERM stop the server cleanly: the running jobs finish and the socket file is removed
+    int serve(Server &server) {
+        runningServer = &server;
+        struct sigaction action{};
+        action.sa_handler = [](int) { runningServer->stop(); };
+        sigaction(SIGINT, &action, nullptr);
+        sigaction(SIGTERM, &action, nullptr);
+        return server.run();
+    }
+}
 
+int main(int argc, char *argv[]) {
     int exitCode;
+    Runner runner;
+    std::string servePath, submitPath;
+    int workers = 0;
+
+    int firstArg = 1;
+    for (; firstArg < argc; firstArg++) {
+        std::string arg = argv[firstArg];
+        if (arg == "--compile") {
+            runner.backend = Runner::Backend::CLOSURES;
+        } else if (arg == "--unbuffered") {
+            runner.unbufferedOutput = true;
+        } else if (arg == "--ast-cache" && firstArg + 1 < argc) {
+            runner.programCache = std::make_shared<AstCache>(argv[++firstArg]);
+        } else if (arg == "--snapshot" && firstArg + 1 < argc) {
+            runner.snapshotPath = argv[++firstArg];
+        } else if (arg == "--snapshot-create" && firstArg + 1 < argc) {
+            runner.snapshotCreatePath = argv[++firstArg];
+        } else if (arg == "--serve" && firstArg + 1 < argc) {
+            servePath = argv[++firstArg];
+        } else if (arg == "--submit" && firstArg + 1 < argc) {
+            submitPath = argv[++firstArg];
+        } else if (arg == "--workers" && firstArg + 1 < argc) {
+            workers = std::atoi(argv[++firstArg]);
+        } else {
+            break;
+        }
+    }
 
-    if (argc > 2) {
+    int remainingArgs = argc - firstArg;
+    if (workers > 0) {
+        //Paths of the scripts are read from stdin if they aren't given as arguments
+        std::vector<std::string> scripts(argv + firstArg, argv + argc);
+        std::string line;
+        while (remainingArgs == 0 && std::getline(std::cin, line)) {
+            if (!line.empty()) scripts.push_back(line);
+        }
+        WorkerPool pool(runner, workers);
+        exitCode = pool.run(scripts, std::cout);
+    } else if (!servePath.empty() && remainingArgs == 0) {
+        Server server(servePath);
+        server.backend = runner.backend;
+        server.snapshotPath = runner.snapshotPath;
+        exitCode = serve(server);
+    } else if (!submitPath.empty() && remainingArgs >= 1) {
+        FileReader reader(argv[firstArg]);
+        std::vector<std::string> scriptArgs(argv + firstArg + 1, argv + argc);
+        exitCode = Server::submit(submitPath, reader.readAll(), scriptArgs, std::cout);
+    } else if (remainingArgs > 1 || !servePath.empty() || !submitPath.empty()) {
         Runner::displayLoxUsage();
         exitCode = 0;
-    } else if (argc == 2) {
-        exitCode = Runner::runScript(argv[1]);
+    } else if (remainingArgs == 1) {
+        exitCode = runner.runScript(argv[firstArg]);
     } else {
-        exitCode = Runner::runRepl();
+        exitCode = runner.runRepl();
     }
 
-#ifdef DEBUG
-    return RUN_ALL_TESTS();
-#else
     return exitCode;
-#endif
 }
 
 //TODO: add support for named parameters?
@@ -0,0 +1,215 @@
+#ifndef JLOX_NATIVEFUNCTION_H
+#define JLOX_NATIVEFUNCTION_H
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "../LoxCallable.h"
+#include "../LoxError.h"
+#include "../LoxObject.h"
+
+class Interpreter;
+
+/*Binding layer for native functions. Any C++ function or lambda can be exposed to Lox with makeNative, the arity and the conversion
+ * of every argument and of the return value are derived from its signature at compile time:
+ *
+ *      makeNative("sqrt", [](double x) { return std::sqrt(x); });
+ *
+ * Supported parameter types are double and other arithmetic types (Lox numbers), bool, std::string, LoxObject (any value) and the
+ * shared pointers held by LoxObject. An argument of the wrong type throws a LoxRuntimeError naming the function and the argument, so
+ * does a number passed to an integer parameter that isn't an integer in the range of that type (NaN, infinities, 1.5, 1e300).
+ * If the first parameter is an Interpreter& it receives the calling interpreter and does not count towards the arity.
+ * If the last parameter is LoxArguments the function is variadic: it receives every argument after the other parameters, which
+ * are the minimum number of arguments.
+ * The return value is converted the same way, void returns nil.
+ * */
+namespace standardFunctions {
+
+    namespace detail {
+
+        template<typename F>
+        struct FunctionTraits : FunctionTraits<decltype(&F::operator())> {};
+
+        template<typename R, typename... Args>
+        struct FunctionTraits<R(*)(Args...)> {
+            using Return = R;
+            using Arguments = std::tuple<Args...>;
+        };
+
+        template<typename R, typename... Args>
+        struct FunctionTraits<R(Args...)> : FunctionTraits<R(*)(Args...)> {};
+
+        template<typename R, typename C, typename... Args>
+        struct FunctionTraits<R(C::*)(Args...) const> : FunctionTraits<R(*)(Args...)> {};
+
+        template<typename R, typename C, typename... Args>
+        struct FunctionTraits<R(C::*)(Args...)> : FunctionTraits<R(*)(Args...)> {};
+
+        template<typename Tuple>
+        constexpr bool takesInterpreter() {
+            if constexpr (std::tuple_size_v<Tuple> == 0){
+                return false;
+            } else {
+                return std::is_same_v<std::tuple_element_t<0, Tuple>, Interpreter&>;
+            }
+        }
+
+        template<typename Tuple>
+        constexpr bool takesRemainingArguments() {
+            if constexpr (std::tuple_size_v<Tuple> == 0){
+                return false;
+            } else {
+                using Last = std::tuple_element_t<std::tuple_size_v<Tuple> - 1, Tuple>;
+                return std::is_same_v<std::remove_cv_t<std::remove_reference_t<Last>>, LoxArguments>;
+            }
+        }
+
+        [[noreturn]] inline void throwArgumentError(const std::string &function, size_t index, const char* expected, const LoxObject &arg) {
+            throw LoxRuntimeError("Function '" + function + "' expected " + expected + " as argument " + std::to_string(index + 1) +
+                                  " but got " + loxTypeToString(arg.type));
+        }
+
+        /*Casting a double that isn't finite or doesn't fit is undefined behaviour, so integer parameters only accept numbers that are
+         * integral and in the range of the type*/
+        template<typename Type>
+        Type toInteger(const LoxObject &arg, const std::string &function, size_t index) {
+            double number = arg.getNumber();
+            //min() is 0 or a power of two and the bound above max() is one too, both are exact doubles
+            double lower = static_cast<double>(std::numeric_limits<Type>::min());
+            double upper = (static_cast<double>(std::numeric_limits<Type>::max() / 2) + 1) * 2;
+            if (!std::isfinite(number) || number != std::trunc(number) || number < lower || number >= upper){
+                std::string got;
+                arg.format(got);
+                throw LoxRuntimeError("Function '" + function + "' expected an integer between " + std::to_string(std::numeric_limits<Type>::min()) +
+                                      " and " + std::to_string(std::numeric_limits<Type>::max()) + " as argument " + std::to_string(index + 1) +
+                                      " but got " + got);
+            }
+            return static_cast<Type>(number);
+        }
+
+        //Converts argument number index of function into a T
+        template<typename T>
+        decltype(auto) fromLox(LoxObject &arg, const std::string &function, size_t index) {
+            using Type = std::remove_cv_t<std::remove_reference_t<T>>;
+            if constexpr (std::is_same_v<Type, LoxObject>){
+                return (arg);
+            } else if constexpr (std::is_same_v<Type, bool>){
+                if (!arg.isBoolean()) throwArgumentError(function, index, "a boolean", arg);
+                return arg.getBoolean();
+            } else if constexpr (std::is_arithmetic_v<Type>){
+                if (!arg.isNumber()) throwArgumentError(function, index, "a number", arg);
+                if constexpr (std::is_integral_v<Type>){
+                    return toInteger<Type>(arg, function, index);
+                } else {
+                    return static_cast<Type>(arg.getNumber());
+                }
+            } else if constexpr (std::is_same_v<Type, std::string>){
+                if (!arg.isString()) throwArgumentError(function, index, "a string", arg);
+                return arg.getString();
+            } else if constexpr (std::is_same_v<Type, SharedCallablePtr>){
+                if (!arg.isCallable()) throwArgumentError(function, index, "a function", arg);
+                return arg.getCallable();
+            } else if constexpr (std::is_same_v<Type, SharedInstancePtr>){
+                if (!arg.isClassInstance()) throwArgumentError(function, index, "an instance", arg);
+                return arg.getClassInstance();
+            } else if constexpr (std::is_same_v<Type, SharedListPtr>){
+                if (!arg.isList()) throwArgumentError(function, index, "a list", arg);
+                return arg.getList();
+            } else {
+                static_assert(!sizeof(Type), "Unsupported parameter type for a native function");
+            }
+        }
+
+        template<typename T>
+        LoxObject toLox(T &&value) {
+            using Type = std::remove_cv_t<std::remove_reference_t<T>>;
+            if constexpr (std::is_same_v<Type, LoxObject>){
+                return std::forward<T>(value);
+            } else if constexpr (std::is_same_v<Type, bool>){
+                return LoxObject(value);
+            } else if constexpr (std::is_arithmetic_v<Type>){
+                return LoxObject(static_cast<double>(value));
+            } else {
+                //strings and the shared pointers held by LoxObject
+                return LoxObject(std::forward<T>(value));
+            }
+        }
+    }
+
+    template<typename F>
+    class NativeFunction : public LoxCallable {
+    public:
+        NativeFunction(std::string functionName, F function)
+            : LoxCallable(CallableType::FUNCTION), functionName(std::move(functionName)), function(std::move(function)) {}
+
+        LoxObject call(Interpreter &interpreter, LoxArguments arguments) override {
+            return invoke(interpreter, arguments, std::make_index_sequence<ARITY>());
+        }
+
+        int arity() override {
+            return ARITY;
+        }
+
+        bool isVariadic() override {
+            return VARIADIC;
+        }
+
+        std::string to_string() override {
+            return "<native function " + name() + ">";
+        }
+
+        std::string name() override {
+            return functionName;
+        }
+
+    private:
+        using Traits = detail::FunctionTraits<std::remove_pointer_t<F>>;
+        using Parameters = typename Traits::Arguments;
+        static constexpr bool TAKES_INTERPRETER = detail::takesInterpreter<Parameters>();
+        static constexpr size_t OFFSET = TAKES_INTERPRETER ? 1 : 0;
+        static constexpr bool VARIADIC = detail::takesRemainingArguments<Parameters>();
+        static constexpr int ARITY = std::tuple_size_v<Parameters> - OFFSET - (VARIADIC ? 1 : 0);
+
+        std::string functionName;
+        F function;
+
+        template<size_t... I>
+        LoxObject invoke(Interpreter &interpreter, LoxArguments arguments, std::index_sequence<I...>) {
+            //The interpreter already checked the number of arguments
+            auto apply = [&](auto... remaining) -> typename Traits::Return {
+                if constexpr (TAKES_INTERPRETER){
+                    return function(interpreter, detail::fromLox<std::tuple_element_t<I + OFFSET, Parameters>>(arguments[I], functionName, I)..., remaining...);
+                } else {
+                    return function(detail::fromLox<std::tuple_element_t<I + OFFSET, Parameters>>(arguments[I], functionName, I)..., remaining...);
+                }
+            };
+            auto call = [&]() -> typename Traits::Return {
+                if constexpr (VARIADIC){
+                    return apply(arguments.subspan(ARITY));
+                } else {
+                    return apply();
+                }
+            };
+
+            if constexpr (std::is_void_v<typename Traits::Return>){
+                call();
+                return LoxObject::Nil();
+            } else {
+                return detail::toLox(call());
+            }
+        }
+    };
+
+    template<typename F>
+    SharedCallablePtr makeNative(std::string name, F function) {
+        return std::make_shared<NativeFunction<F>>(std::move(name), std::move(function));
+    }
+
+}
+
+
+#endif //JLOX_NATIVEFUNCTION_H
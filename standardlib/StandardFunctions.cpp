@@ -1,77 +1,116 @@
 #include "StandardFunctions.h"
 #include <chrono>
-#include <iostream>
-#include <memory>
-#include <stdexcept>
+#include <string>
 #include <thread>
-#include <sstream>
+#include <utility>
+#include "NativeFunction.h"
+#include "../EventLoop.h"
+#include "../ForkMap.h"
+#include "../Generator.h"
+#include "../Interpreter.h"
+#include "../Isolate.h"
+#include "../LoxIterator.h"
 #include "../LoxError.h"
+#include "../Memoize.h"
+#include "../TaskPool.h"
 
-class Interpreter;
 
-standardFunctions::Clock::Clock() : LoxCallable(CallableType::FUNCTION) {}
-
-LoxObject standardFunctions::Clock::call(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
-    using namespace std::chrono;
-    double ms = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
-    return LoxObject(ms);
-}
-
-int standardFunctions::Clock::arity() {
-    return 0;
-}
-
-std::string standardFunctions::Clock::to_string() {
-    return "<native function " + name() + ">";
-}
-
-std::string standardFunctions::Clock::name() {
-    return "clock";
-}
-
-standardFunctions::Sleep::Sleep() : LoxCallable(CallableType::FUNCTION) {}
-
-LoxObject standardFunctions::Sleep::call(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
-    int time;
-    try {
-        time = (int) arguments[0].getNumber();
-    } catch (const std::runtime_error &error) {
-        throw LoxRuntimeError("Function 'sleep' expected an integer as its argument");
+namespace {
+    //The workers of the task pool never run an event loop, the callbacks would never be called
+    void checkEventLoop(const std::string &function) {
+        if (TaskPool::onWorker()){
+            throw LoxRuntimeError(function + "() can't be called inside a task");
+        }
     }
-
-    std::this_thread::sleep_for(std::chrono::milliseconds(time));
-    return LoxObject::Nil();
-}
-
-int standardFunctions::Sleep::arity() {
-    return 1;
-}
-
-std::string standardFunctions::Sleep::to_string() {
-    return "<native function " + name() + ">";
-}
-
-std::string standardFunctions::Sleep::name() {
-    return "sleep";
-}
-
-
-standardFunctions::Str::Str() : LoxCallable(CallableType::FUNCTION) {}
-
-LoxObject standardFunctions::Str::call(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
-    std::stringstream ss; //Use stringstream because LoxObject overrides operator '<<' for printing
-    ss << arguments[0];
-    return LoxObject(ss.str());
-}
-
-int standardFunctions::Str::arity() {
-    return 1;
-}
-
-std::string standardFunctions::Str::to_string() {
-    return "<native function " + name() + ">";
 }
 
-std::string standardFunctions::Str::name() {
-    return "str";
+std::vector<SharedCallablePtr> standardFunctions::builtins() {
+    return {
+        makeNative("clock", []() {
+            using namespace std::chrono;
+            return (double) duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+        }),
+
+        makeNative("sleep", [](int ms) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+        }),
+
+        makeNative("set_timeout", [](Interpreter &interpreter, const SharedCallablePtr &callback, double ms) {
+            checkEventLoop("set_timeout");
+            return EventLoop::of(interpreter).setTimeout(callback, ms);
+        }),
+
+        makeNative("clear_timeout", [](Interpreter &interpreter, double id) {
+            checkEventLoop("clear_timeout");
+            EventLoop::of(interpreter).clearTimeout(id);
+        }),
+
+        makeNative("read_file", [](Interpreter &interpreter, const std::string &path, const SharedCallablePtr &callback) {
+            checkEventLoop("read_file");
+            EventLoop::of(interpreter).readFile(path, callback);
+        }),
+
+        makeNative("str", [](const LoxObject &object) {
+            std::string formatted;
+            object.format(formatted);
+            return LoxObject(std::move(formatted));
+        }),
+
+        makeNative("flush", [](Interpreter &interpreter) {
+            interpreter.flushOutput();
+        }),
+
+        makeNative("spawn", [](Interpreter &interpreter, const SharedCallablePtr &function, LoxArguments arguments) {
+            return Isolate::spawn(interpreter, function, arguments);
+        }),
+
+        makeNative("task", [](Interpreter &interpreter, const SharedCallablePtr &function, LoxArguments arguments) {
+            return TaskPool::submit(interpreter, function, arguments);
+        }),
+
+        makeNative("parallel_map", [](Interpreter &interpreter, const SharedListPtr &list, const SharedCallablePtr &function) {
+            return TaskPool::map(interpreter, list, function);
+        }),
+
+        makeNative("parallel_reduce", [](Interpreter &interpreter, const SharedListPtr &list, const SharedCallablePtr &function, const LoxObject &initial) {
+            return TaskPool::reduce(interpreter, list, function, initial);
+        }),
+
+        makeNative("fork_map", [](Interpreter &interpreter, const SharedListPtr &list, const SharedCallablePtr &function, int workers) {
+            return ForkMap::run(interpreter, list, function, workers);
+        }),
+
+        makeNative("range", [](double first, LoxArguments rest) {
+            return LoxIterator::range(first, rest);
+        }),
+
+        makeNative("iter", [](const LoxObject &iterable) {
+            return LoxIterator::iter(iterable);
+        }),
+
+        makeNative("memoize", [](const SharedCallablePtr &function, LoxArguments rest) {
+            return MemoizedFunction::create(function, rest);
+        }),
+
+        makeNative("memo_stats", [](const SharedCallablePtr &memoized) {
+            return MemoizedFunction::stats(memoized);
+        }),
+
+        makeNative("generator", [](Interpreter &interpreter, const SharedCallablePtr &function, LoxArguments arguments) {
+            return Generator::create(interpreter, function, arguments);
+        }),
+
+        makeNative("yield", [](const LoxObject &value) {
+            Generator::yield(value);
+        }),
+
+        //Replaced inside isolates by functions that talk to the parent, see Isolate.h
+        makeNative("send", [](const LoxObject &) {
+            throw LoxRuntimeError("send() can only be called inside an isolate, use the send method of the handle returned by spawn");
+        }),
+
+        makeNative("receive", []() {
+            throw LoxRuntimeError("receive() can only be called inside an isolate, use the receive method of the handle returned by spawn");
+        }),
+    };
 }
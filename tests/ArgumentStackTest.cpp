@@ -0,0 +1,74 @@
+#include "gtest/gtest.h"
+#include <string>
+#include "../ArgumentStack.h"
+#include "../LoxObject.h"
+#include "LoxTestUtils.h"
+
+TEST(ArgumentStackTest, framesThatDontFitStartANewBlock){
+    ArgumentStack stack;
+    ArgumentStack::Frame outer(stack, 200);
+    for (size_t i = 0; i < outer.arguments.size(); i++){
+        outer.arguments[i] = LoxObject(static_cast<double>(i));
+    }
+    {
+        //Doesn't fit in the 56 slots left in the first block, and the next frame is bigger than a block
+        ArgumentStack::Frame inner(stack, 100);
+        ArgumentStack::Frame huge(stack, 300);
+        EXPECT_EQ(inner.arguments.size(), 100u);
+        EXPECT_EQ(huge.arguments.size(), 300u);
+        for (LoxObject &argument : inner.arguments) argument = LoxObject("inner");
+        for (LoxObject &argument : huge.arguments) argument = LoxObject("huge");
+        EXPECT_NE(inner.arguments.data(), outer.arguments.data() + 200);
+        EXPECT_TRUE(inner.arguments[99] == LoxObject("inner"));
+    }
+    for (size_t i = 0; i < outer.arguments.size(); i++){
+        EXPECT_TRUE(outer.arguments[i] == LoxObject(static_cast<double>(i))) << i;
+    }
+
+    //The released slots are reused, and were cleared so they don't keep objects alive
+    ArgumentStack::Frame reused(stack, 50);
+    EXPECT_EQ(reused.arguments.data(), outer.arguments.data() + 200);
+    EXPECT_TRUE(reused.arguments[0].isNil());
+}
+
+static std::string numbers(int from, int to, const std::string &prefix = "") {
+    std::string list;
+    for (int i = from; i <= to; i++){
+        list += (i > from ? ", " : "") + prefix + std::to_string(i);
+    }
+    return list;
+}
+
+class ArgumentStackBackendTest : public BackendTest {};
+
+TEST_P(ArgumentStackBackendTest, nestedCallsAcrossBlocks){
+    //The first 199 arguments of the outer call wait in the stack while the inner calls push 200 more each, past the end of a block
+    std::string sum = "fun sum(" + numbers(1, 200, "a") + ") { return " + numbers(1, 200, "a") + "; }\n";
+    for (size_t plus; (plus = sum.find(", ", sum.find("return"))) != std::string::npos;) sum.replace(plus, 2, " + ");
+    std::string source = sum +
+            "print sum(" + numbers(1, 199) + ", sum(" + numbers(1, 199) + ", sum(" + numbers(1, 200) + ")));\n"
+            //A variadic native with as many arguments, while a Lox call is half evaluated
+            "print sum(" + numbers(1, 199) + ", task(sum, " + numbers(1, 200) + ").join());\n";
+    EXPECT_EQ(run(source), "59900\n40000\n");
+}
+
+TEST_P(ArgumentStackBackendTest, argumentsOutliveTheCall){
+    //The arguments are moved out of the stack into the environment of the call, closures keep them after their slots are reused
+    std::string source =
+            "class Nothing {}\n"
+            "var setter = nil;\n"
+            "fun capture(a, b, c) { fun set(x) { b = x; } setter = set; fun get() { return [a, b, c]; } return get; }\n"
+            "fun makeAdder(n) { return lambda x: x + n; }\n"
+            "fun second(a, b) { return b; }\n"
+            "var get = capture(\"a\", [1, 2], Nothing);\n"
+            "var addOne = makeAdder(1);\n"
+            "var addTwo = makeAdder(2);\n"
+            "second(second(addOne(1), addTwo(2)), makeAdder(5)(5));\n"
+            "print [addOne(10), addTwo(10)];\n"
+            "print get();\n"
+            "setter(\"changed\");\n"
+            "print get();\n";
+    EXPECT_EQ(run(source), "[11, 12]\n[a, [1, 2], <class Nothing>]\n[a, changed, <class Nothing>]\n");
+}
+
+INSTANTIATE_BACKENDS(ArgumentStackBackendTest);
@@ -0,0 +1,97 @@
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include "../AstCache.h"
+#include "../Runner.h"
+#include "../tools/BinaryStream.h"
+#include "LoxTestUtils.h"
+
+class AstCacheTest : public BackendTest {
+protected:
+    std::string directory;
+    std::shared_ptr<AstCache> cache;
+
+    void SetUp() override {
+        std::string pattern = ::testing::TempDir() + "ast_cache_XXXXXX";
+        ASSERT_NE(mkdtemp(pattern.data()), nullptr);
+        directory = pattern;
+        cache = std::make_shared<AstCache>(directory);
+    }
+
+    std::string entryPath(const std::string &source) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.loxast", (unsigned long long) binary::fnv1a(source));
+        return directory + "/" + name;
+    }
+
+    std::shared_ptr<const Program> parse(const std::string &source) {
+        std::ostringstream output;
+        Runner runner(output);
+        return runner.loadProgram(source);
+    }
+};
+
+static std::string readFile(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void writeFile(const std::string &path, const std::string &bytes) {
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes;
+}
+
+TEST_P(AstCacheTest, hit){
+    std::string source = "fun twice(x) { return x * 2; }\nvar a = 1;\n{ var a = 20; print twice(a); }\nprint a;\n";
+    EXPECT_EQ(cache->load(source), nullptr);
+    EXPECT_EQ(run(source, 0, cache), "40\n1\n");
+    EXPECT_FALSE(readFile(entryPath(source)).empty());
+    EXPECT_NE(cache->load(source), nullptr);
+    EXPECT_EQ(run(source, 0, cache), "40\n1\n");
+
+    //The second run takes the program from the cache instead of parsing the source: an entry stored for it is what runs
+    cache->store(source, parse("print \"from the cache\";"));
+    EXPECT_EQ(run(source, 0, cache), "from the cache\n");
+}
+
+TEST_P(AstCacheTest, staleEntry){
+    //Same size, so only the hash of the source tells them apart
+    std::string before = "var x = 1;\nprint x + 1;\n";
+    std::string after = "var x = 5;\nprint x + 1;\n";
+    ASSERT_EQ(before.size(), after.size());
+    EXPECT_EQ(run(before, 0, cache), "2\n");
+
+    //An entry written for another source (renamed, or a hash collision) is ignored and replaced
+    writeFile(entryPath(after), readFile(entryPath(before)));
+    EXPECT_EQ(cache->load(after), nullptr);
+    EXPECT_EQ(run(after, 0, cache), "6\n");
+    EXPECT_NE(cache->load(after), nullptr);
+    EXPECT_EQ(run(after, 0, cache), "6\n");
+    EXPECT_EQ(run(before, 0, cache), "2\n");
+}
+
+TEST_P(AstCacheTest, corruptEntry){
+    std::string source = "class Point { init(x, y) { this.x = x; this.y = y; } }\nvar p = Point(3, 4);\nprint p.x * p.y;\n";
+    EXPECT_EQ(run(source, 0, cache), "12\n");
+    std::string entry = readFile(entryPath(source));
+    ASSERT_GT(entry.size(), 64u);
+
+    //A flipped byte in the payload, a truncated file, a different format version and garbage all fall back to parsing the source
+    std::string flipped = entry;
+    flipped[entry.size() - 10] ^= 0x5a;
+    std::string version = entry;
+    version[8] ^= 1;
+    for (const std::string &corrupt : {flipped, entry.substr(0, entry.size() / 2), version, std::string(entry.size(), '\x7f')}){
+        writeFile(entryPath(source), corrupt);
+        EXPECT_EQ(cache->load(source), nullptr);
+        EXPECT_EQ(run(source, 0, cache), "12\n");
+        //and the entry is written again
+        EXPECT_NE(cache->load(source), nullptr);
+    }
+}
+
+INSTANTIATE_BACKENDS(AstCacheTest);
@@ -0,0 +1,96 @@
+#include "gtest/gtest.h"
+#include <string>
+#include "LoxTestUtils.h"
+
+//The ClosureCompiler must run every script exactly like the tree walker: same output, same errors, same exit code
+class BackendParityTest : public BackendTest {};
+
+TEST_P(BackendParityTest, closuresAndUpvalues){
+    std::string source =
+            "fun makeCounter() {\n"
+            "    var count = 0;\n"
+            "    fun increment() { count = count + 1; return count; }\n"
+            "    fun get() { return count; }\n"
+            "    return [increment, get];\n"
+            "}\n"
+            "fun counter() { var count = 10; fun next() { count++; return count; } return next; }\n"
+            "var first = counter();\n"
+            "var second = counter();\n"
+            "first(); first();\n"
+            "print [first(), second()];\n"
+            //Two closures share the variable they captured
+            "var a = \"global\";\n"
+            "{\n"
+            "    var shared = 1;\n"
+            "    fun show() { print [a, shared]; }\n"
+            "    fun bump() { shared = shared * 2; }\n"
+            "    bump(); bump(); show();\n"
+            "    var a = \"block\";\n"
+            "    show();\n"
+            "}\n"
+            //Every iteration of the block creates a new variable, every closure keeps its own
+            "var adder = nil;\n"
+            "for (var i = 0; i < 3; i++) { var j = i; if (i == 1) adder = lambda x: x + j; }\n"
+            "print adder(10);\n"
+            "fun outer() { var x = \"outer\"; fun middle() { fun inner() { return x; } return inner; } return middle()(); }\n"
+            "print outer();\n";
+    EXPECT_EQ(run(source), "[13, 11]\n[global, 4]\n[global, 4]\n11\nouter\n");
+}
+
+TEST_P(BackendParityTest, classesAndSuper){
+    std::string source =
+            "class Shape {\n"
+            "    init(name) { this.name = name; }\n"
+            "    area() { return 0; }\n"
+            "    describe() { return this.name + \" \" + str(this.area()); }\n"
+            "}\n"
+            "class Square < Shape {\n"
+            "    init(side) { super.init(\"square\"); this.side = side; }\n"
+            "    area() { return this.side * this.side; }\n"
+            "}\n"
+            "class Cube < Square {\n"
+            "    area() { return 6 * super.area(); }\n"
+            "    describe() { return \"cube: \" + super.describe(); }\n"
+            "}\n"
+            "print Square(3).describe();\n"
+            "var cube = Cube(2);\n"
+            "print cube.describe();\n"
+            "var method = cube.area;\n"
+            "print method();\n"
+            "print Cube;\n"
+            "print cube.init(1) == cube;\n";
+    EXPECT_EQ(run(source), "square 9\ncube: square 24\n24\n<class Cube>\ntrue\n");
+}
+
+TEST_P(BackendParityTest, breakAndContinueInNestedLoops){
+    std::string source =
+            "var pairs = \"\";\n"
+            "for (var i = 0; i < 4; i++) {\n"
+            "    if (i == 1) continue;\n"
+            "    var j = 0;\n"
+            "    while (true) {\n"
+            "        j++;\n"
+            "        if (j == 2) continue;\n"
+            "        if (j > 3) break;\n"
+            "        pairs = pairs + str(i) + str(j) + \" \";\n"
+            "    }\n"
+            "    if (i == 2) break;\n"
+            "}\n"
+            "print pairs;\n"
+            //break and continue only leave the innermost loop, also from inside a block
+            "var count = 0;\n"
+            "for (var a = 0; a < 3; a++) for (var b = 0; b < 3; b++) { { if (b == a) continue; } if (b > a) break; count++; }\n"
+            "print count;\n";
+    EXPECT_EQ(run(source), "01 03 21 23 \n3\n");
+}
+
+TEST_P(BackendParityTest, runtimeErrors){
+    EXPECT_EQ(run("print \"before\";\nvar a = 1;\nfun f() {\n    return a + nil;\n}\nf();\nprint \"after\";", 70),
+              "before\n[Line 4] Runtime Error: Cannot apply operator '+' to operands of type number and nil\n");
+    EXPECT_EQ(run("var x = 1;\n\nprint y;", 70), "[Line 3] Runtime Error: Undefined variable 'y'\n");
+    EXPECT_EQ(run("fun f(a) {}\nf(1,\n  2);", 70), "[Line 3] Runtime Error: f expected 1 argument(s) but instead got 2\n");
+    EXPECT_EQ(run("class A {}\nA().missing;", 70), "[Line 2] Runtime Error: Undefined property 'missing'\n");
+    EXPECT_EQ(run("var notAFunction = 1;\nnotAFunction();", 70), "[Line 2] Runtime Error: Expression is not callable\n");
+}
+
+INSTANTIATE_BACKENDS(BackendParityTest);
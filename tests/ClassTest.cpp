@@ -0,0 +1,79 @@
+#include "gtest/gtest.h"
+#include <string>
+#include "LoxTestUtils.h"
+
+class ClassTest : public BackendTest {};
+
+TEST_P(ClassTest, overridesThreeLevelsDeep){
+    //Every class copies the flattened table of its superclass, the closest override must win at every level
+    std::string source =
+            "class A { name() { return \"A\"; } onlyA() { return \"onlyA\"; } shared() { return \"A.shared\"; } }\n"
+            "class B < A { name() { return \"B\"; } shared() { return \"B.shared\"; } }\n"
+            "class C < B { name() { return \"C\"; } }\n"
+            "class D < C {}\n"
+            "print [A().name(), B().name(), C().name(), D().name()];\n"
+            "print [D().onlyA(), D().shared(), C().shared(), A().shared()];\n"
+            //A field hides a method with the same name
+            "var d = D();\n"
+            "d.name = \"field\";\n"
+            "print [d.name, D().name()];\n";
+    EXPECT_EQ(run(source), "[A, B, C, C]\n[onlyA, B.shared, B.shared, A.shared]\n[field, C]\n");
+}
+
+TEST_P(ClassTest, superCallsFromOverriddenMethods){
+    std::string source =
+            "class A { describe() { return \"A\"; } greet() { return \"hello from \" + this.describe(); } }\n"
+            "class B < A { describe() { return \"B>\" + super.describe(); } }\n"
+            "class C < B { describe() { return \"C>\" + super.describe(); } }\n"
+            "class D < C { greet() { return super.greet() + \"!\"; } }\n"
+            "print C().describe();\n"
+            //super.greet() runs A's greet on the D instance, so this.describe() is still C's override
+            "print D().greet();\n"
+            "var method = D().greet;\n"
+            "print method();\n";
+    EXPECT_EQ(run(source), "C>B>A\nhello from C>B>A!\nhello from C>B>A!\n");
+
+    EXPECT_EQ(run("class A {}\nclass B < A { m() {\n  return super.missing();\n} }\nB().m();", 70),
+              "[Line 3] Runtime Error: Undefined property missing\n");
+}
+
+TEST_P(ClassTest, inheritedInitializer){
+    std::string source =
+            "class Point { init(x, y) { this.x = x; this.y = y; } sum() { return this.x + this.y; } }\n"
+            "class Named < Point { label() { return \"p\" + str(this.sum()); } }\n"
+            "class Deeper < Named {}\n"
+            "print Deeper(1, 2).label();\n"
+            //init returns the instance, also when called again on it
+            "var p = Named(3, 4);\n"
+            "print p.init(5, 6) == p;\n"
+            "print p.sum();\n";
+    EXPECT_EQ(run(source), "p3\ntrue\n11\n");
+
+    EXPECT_EQ(run("class Point { init(x, y) {} }\nclass Named < Point {}\nNamed(1);", 70),
+              "[Line 3] Runtime Error: Named expected 2 argument(s) but instead got 1\n");
+    EXPECT_EQ(run("class Empty {}\nEmpty(1);", 70), "[Line 2] Runtime Error: Empty expected 0 argument(s) but instead got 1\n");
+}
+
+TEST_P(ClassTest, thisInNestedClosures){
+    std::string source =
+            "class Counter {\n"
+            "    init() { this.count = 0; }\n"
+            //this is captured by a function two levels below the method and by a lambda, both outlive the call
+            "    incrementer() { fun outer() { fun inner() { this.count = this.count + 1; return this.count; } return inner; } return outer(); }\n"
+            "    reader() { return lambda : this.count; }\n"
+            "}\n"
+            "var first = Counter();\n"
+            "var second = Counter();\n"
+            "var increment = first.incrementer();\n"
+            "var read = first.reader();\n"
+            "increment(); increment();\n"
+            "second.incrementer()();\n"
+            "print [read(), second.reader()(), first.count];\n"
+            //A bound method keeps its receiver
+            "var method = second.incrementer;\n"
+            "method()();\n"
+            "print second.count;\n";
+    EXPECT_EQ(run(source), "[2, 1, 2]\n2\n");
+}
+
+INSTANTIATE_BACKENDS(ClassTest);
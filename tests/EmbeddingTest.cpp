@@ -0,0 +1,106 @@
+#include "gtest/gtest.h"
+#include <sstream>
+#include <string>
+#include "../Lox.h"
+#include "../LoxC.h"
+#include "../LoxError.h"
+
+TEST(EmbeddingTest, runAndFetchGlobals){
+    std::ostringstream output;
+    Lox lox(output);
+    EXPECT_EQ(lox.run("var answer = 6 * 7; print \"ran\";"), 0);
+    EXPECT_EQ(output.str(), "ran\n");
+
+    std::optional<LoxObject> answer = lox.getGlobal("answer");
+    ASSERT_TRUE(answer.has_value());
+    EXPECT_EQ(answer->getNumber(), 42);
+    EXPECT_FALSE(lox.getGlobal("missing").has_value());
+}
+
+TEST(EmbeddingTest, callLoxFromCpp){
+    std::ostringstream output;
+    Lox lox(output);
+    ASSERT_EQ(lox.run("fun greet(name, times) { var s = \"\"; for (var i = 0; i < times; i++) s = s + name; print s; return s; }"), 0);
+    LoxObject result = lox.call("greet", "ab", 2);
+    EXPECT_EQ(result.getString(), "abab");
+    EXPECT_EQ(output.str(), "abab\n");
+
+    EXPECT_THROW(lox.call("greet", "ab"), LoxRuntimeError);
+    EXPECT_THROW(lox.call("missing"), LoxRuntimeError);
+}
+
+TEST(EmbeddingTest, registerNativesAndGlobals){
+    std::ostringstream output;
+    Lox lox(output);
+    int calls = 0;
+    lox.registerNative("twice", [&calls](double x) { calls++; return 2 * x; });
+    lox.setGlobal("base", LoxObject(20.0));
+    EXPECT_EQ(lox.run("print twice(base) + 2;"), 0);
+    EXPECT_EQ(output.str(), "42\n");
+    EXPECT_EQ(calls, 1);
+
+    EXPECT_EQ(lox.run("twice(\"x\");"), 70);
+    EXPECT_NE(output.str().find("expected a number"), std::string::npos);
+}
+
+TEST(EmbeddingTest, compiledBackend){
+    std::ostringstream output;
+    Lox lox(output);
+    lox.getRunner().backend = Runner::Backend::CLOSURES;
+    ASSERT_EQ(lox.run("class A { init(x) { this.x = x; } get() { return this.x; } } fun make(x) { return A(x).get(); }"), 0);
+    EXPECT_EQ(lox.call("make", 5).getNumber(), 5);
+}
+
+namespace {
+    void appendOutput(const char* data, size_t size, void* userdata) {
+        static_cast<std::string*>(userdata)->append(data, size);
+    }
+
+    lox_value joinNative(lox_vm* vm, const lox_value* args, int argc, void* userdata) {
+        if (args[0].type != LOX_STRING || args[1].type != LOX_STRING){
+            lox_native_error(vm, "expected strings");
+            return lox_nil();
+        }
+        std::string* storage = static_cast<std::string*>(userdata);
+        *storage = std::string(args[0].string) + *storage + args[1].string;
+        return lox_string(storage->c_str());
+    }
+}
+
+TEST(EmbeddingTest, cApi){
+    std::string output;
+    lox_vm* vm = lox_new_with_output(appendOutput, &output);
+
+    std::string separator = "-";
+    lox_register_native(vm, "join", 2, joinNative, &separator);
+    ASSERT_EQ(lox_run(vm, "fun add(a, b) { return a + b; } var name = join(\"a\", \"b\"); print name;"), 0);
+    EXPECT_EQ(output, "a-b\n");
+
+    lox_value value;
+    ASSERT_TRUE(lox_get_global(vm, "name", &value));
+    ASSERT_EQ(value.type, LOX_STRING);
+    EXPECT_STREQ(value.string, "a-b");
+    EXPECT_FALSE(lox_get_global(vm, "missing", &value));
+
+    lox_value args[2] = {lox_number(1), lox_number(2)};
+    lox_value result;
+    ASSERT_EQ(lox_call(vm, "add", args, 2, &result), 0);
+    ASSERT_EQ(result.type, LOX_NUMBER);
+    EXPECT_EQ(result.number, 3);
+
+    ASSERT_EQ(lox_call(vm, "add", args, 1, &result), 70);
+    EXPECT_NE(std::string(lox_last_error(vm)).find("expected 2 argument(s)"), std::string::npos);
+
+    args[0] = lox_bool(1);
+    EXPECT_EQ(lox_call(vm, "join", args, 2, &result), 70);
+    EXPECT_NE(std::string(lox_last_error(vm)).find("expected strings"), std::string::npos);
+
+    ASSERT_EQ(lox_get_global(vm, "add", &value), 1);
+    EXPECT_EQ(value.type, LOX_OBJECT);
+    EXPECT_FALSE(lox_set_global(vm, "copy", value));
+    EXPECT_TRUE(lox_set_global(vm, "copy", lox_string("text")));
+    ASSERT_EQ(lox_run(vm, "print copy;"), 0);
+    EXPECT_EQ(output, "a-b\ntext\n");
+
+    lox_free(vm);
+}
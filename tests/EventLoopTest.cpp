@@ -0,0 +1,53 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <fstream>
+#include <string>
+#include "LoxTestUtils.h"
+
+class EventLoopTest : public BackendTest {};
+
+TEST_P(EventLoopTest, timersRunInDeadlineOrder){
+    std::string source =
+            "fun say(text) { fun callback() { print text; } return callback; }\n"
+            "set_timeout(say(\"third\"), 30);\n"
+            "set_timeout(say(\"first\"), 10);\n"
+            "set_timeout(say(\"second\"), 10);\n"
+            "clear_timeout(set_timeout(say(\"cleared\"), 20));\n"
+            "fun again() { print \"zero\"; set_timeout(say(\"from a callback\"), 0); }\n"
+            "set_timeout(again, 0);\n"
+            "print \"program\";\n";
+    EXPECT_EQ(run(source), "program\nzero\nfrom a callback\nfirst\nsecond\nthird\n");
+}
+
+TEST_P(EventLoopTest, waitsOverlap){
+    //Ten timers of 50ms cost 50ms, not 500ms
+    std::string source =
+            "var fired = 0;\n"
+            "fun tick() { fired = fired + 1; if (fired == 10) print \"done\"; }\n"
+            "for (var i = 0; i < 10; i++) set_timeout(tick, 50);\n";
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(run(source), "done\n");
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(400));
+}
+
+TEST_P(EventLoopTest, readFile){
+    std::string path = ::testing::TempDir() + "event_loop_test.txt";
+    std::ofstream(path) << "contents";
+    std::string source =
+            "fun show(text, error) { print [text, error]; }\n"
+            "read_file(\"" + path + "\", show);\n"
+            "read_file(\"" + path + ".missing\", show);\n"
+            "print \"reading\";\n";
+    EXPECT_EQ(run(source), "reading\n[contents, nil]\n[nil, Error: File " + path + ".missing not found]\n");
+}
+
+TEST_P(EventLoopTest, errorsInCallbacks){
+    std::string output = run("fun fail() { return 1 + nil; }\nset_timeout(fail, 0);\nprint \"before\";", 70);
+    EXPECT_EQ(output.substr(0, 7), "before\n");
+    EXPECT_NE(output.find("Runtime Error"), std::string::npos);
+
+    output = run("fun wait() { set_timeout(wait, 0); }\ntask(wait).join();", 70);
+    EXPECT_NE(output.find("can't be called inside a task"), std::string::npos);
+}
+
+INSTANTIATE_BACKENDS(EventLoopTest);
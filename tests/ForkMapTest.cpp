@@ -0,0 +1,37 @@
+#include "gtest/gtest.h"
+#include <string>
+#include "LoxTestUtils.h"
+
+class ForkMapTest : public BackendTest {};
+
+TEST_P(ForkMapTest, mapsInOrder){
+    //Unlike tasks, the function can read globals and modify captured variables, the changes stay in the children
+    std::string source =
+            "var offset = 100;\n"
+            "var calls = 0;\n"
+            "fun shift(x) { calls = calls + 1; print x; return x + offset; }\n"
+            "print fork_map([1, 2, 3, 4, 5, 6, 7], shift, 3);\n"
+            "print calls;\n"
+            "fun twice(x) { return [x, x]; }\n"
+            "print fork_map([\"a\", [true, nil]], twice, 4);\n"
+            "print fork_map([], shift, 2);\n";
+    EXPECT_EQ(run(source), "1\n2\n3\n4\n5\n6\n7\n[101, 102, 103, 104, 105, 106, 107]\n0\n[[a, a], [[true, nil], [true, nil]]]\n[]\n");
+}
+
+TEST_P(ForkMapTest, reportsTheFirstError){
+    std::string source =
+            "fun check(x) { print x; if (x == 2 or x == 3) return x + nil; return x; }\n"
+            "fork_map([0, 1, 2, 3, 4, 5], check, 2);\n";
+    std::string output = run(source, 70);
+    EXPECT_EQ(output.substr(0, 6), "0\n1\n2\n");
+    EXPECT_NE(output.find("fork_map failed on item 2"), std::string::npos) << output;
+    EXPECT_EQ(output.find("3\n"), std::string::npos) << output;
+
+    output = run("class A {}\nfork_map([1], lambda x : A(), 1);", 70);
+    EXPECT_NE(output.find("can only be nil, booleans, numbers, strings and lists"), std::string::npos) << output;
+
+    output = run("fork_map([1], lambda x : x, 0);", 70);
+    EXPECT_NE(output.find("at least one worker"), std::string::npos) << output;
+}
+
+INSTANTIATE_BACKENDS(ForkMapTest);
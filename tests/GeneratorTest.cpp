@@ -0,0 +1,81 @@
+#include "gtest/gtest.h"
+#include <string>
+#include "LoxTestUtils.h"
+
+class GeneratorTest : public BackendTest {};
+
+TEST_P(GeneratorTest, nextAndDone){
+    std::string source =
+            "fun count(from, to) { for (var i = from; i < to; i++) yield(i); return \"ignored\"; }\n"
+            "var numbers = generator(count, 0, 3);\n"
+            "print numbers.next();\n"
+            "print numbers.done();\n"
+            "print numbers.next();\n"
+            "print numbers.next();\n"
+            "print numbers.done();\n"
+            "print numbers.next();\n";
+    EXPECT_EQ(run(source), "0\nfalse\n1\n2\ntrue\nnil\n");
+}
+
+TEST_P(GeneratorTest, yieldFromNestedCalls){
+    //The generator has its own stack, so functions it calls can yield too
+    std::string source =
+            "fun pair(x) { yield(x); yield(-x); }\n"
+            "fun pairs() { pair(1); pair(2); }\n"
+            "var values = generator(pairs);\n"
+            "while (!values.done()) print values.next();\n";
+    EXPECT_EQ(run(source), "1\n-1\n2\n-2\n");
+}
+
+TEST_P(GeneratorTest, infiniteAndChained){
+    std::string source =
+            "fun naturals() { var n = 0; while (true) { yield(n); n++; } }\n"
+            "fun squares(source) { while (true) { var n = source.next(); yield(n * n); } }\n"
+            "var result = generator(squares, generator(naturals));\n"
+            "var total = 0;\n"
+            "for (var i = 0; i < 10000; i++) total = total + result.next();\n"
+            "print total;\n"
+            //Dropped while suspended, their stacks are unwound
+            "for (var i = 0; i < 1000; i++) { var g = generator(naturals); g.next(); }\n"
+            "print \"done\";\n";
+    EXPECT_EQ(run(source), "333283335000\ndone\n");
+}
+
+TEST_P(GeneratorTest, errors){
+    std::string output = run("fun bad() { yield(1); return 1 + nil; }\nvar b = generator(bad);\nprint b.next();\nb.next();", 70);
+    EXPECT_EQ(output.substr(0, 2), "1\n");
+    EXPECT_NE(output.find("Runtime Error"), std::string::npos);
+
+    output = run("yield(1);", 70);
+    EXPECT_NE(output.find("only be called inside a generator"), std::string::npos);
+
+    output = run("fun again() { yield(self.next()); }\nvar self = generator(again);\nself.next();", 70);
+    EXPECT_NE(output.find("already running"), std::string::npos);
+}
+
+TEST_P(GeneratorTest, deepRecursion){
+    //The stack of a generator is as big as the one of the main thread. 1000 calls crashed on the 1 MiB stacks generators used to have
+    std::string source =
+            "fun depth(n) { if (n == 0) { yield(\"bottom\"); return 0; } return 1 + depth(n - 1); }\n"
+            "fun deep() { yield(depth(1000)); yield(depth(1000)); }\n"
+            "for (value in generator(deep)) print value;\n";
+    EXPECT_EQ(run(source), "bottom\n1000\nbottom\n1000\n");
+
+    //Recursing without end is a runtime error reported by the call that resumed the generator, which can be resumed no more
+    source =
+            "fun forever(n) { return forever(n + 1) + 1; }\n"
+            "fun endless() { yield(1); forever(0); }\n"
+            "var g = generator(endless);\n"
+            "print g.next();\n"
+            "fun safely() { g.next(); }\n"
+            "safely();\n";
+    EXPECT_EQ(run(source, 70), "1\n[Line 1] Runtime Error: Stack overflow inside a generator\n");
+
+    source =
+            "fun forever(n) { return forever(n + 1) + 1; }\n"
+            "fun outer() { var inner = generator(forever, 0); yield(inner.next()); }\n"
+            "generator(outer).next();\n";
+    EXPECT_EQ(run(source, 70), "[Line 1] Runtime Error: Stack overflow inside a generator\n");
+}
+
+INSTANTIATE_BACKENDS(GeneratorTest);
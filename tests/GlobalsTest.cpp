@@ -0,0 +1,111 @@
+#include "gtest/gtest.h"
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include "../AstCache.h"
+#include "../Runner.h"
+#include "LoxTestUtils.h"
+
+class GlobalsTest : public BackendTest {};
+
+TEST_P(GlobalsTest, functionsSeeGlobalsDefinedAfterThem){
+    std::string source =
+            "fun show() { return later; }\n"
+            "fun change() { later = later + 1; }\n"
+            "var later = 1;\n"
+            "change();\n"
+            "print show();\n"
+            "print show() == later;\n";
+    EXPECT_EQ(run(source), "2\ntrue\n");
+
+    EXPECT_EQ(run("fun show() { return later; }\nprint show();\nvar later = 1;", 70), "[Line 1] Runtime Error: Undefined variable 'later'\n");
+}
+
+TEST_P(GlobalsTest, assigningAnUndefinedGlobal){
+    EXPECT_EQ(run("var a = 1;\nb = 2;", 70), "[Line 2] Runtime Error: Undefined variable 'b'\n");
+    EXPECT_EQ(run("fun set() {\n  missing = 1;\n}\nset();", 70), "[Line 2] Runtime Error: Undefined variable 'missing'\n");
+}
+
+TEST_P(GlobalsTest, redefiningAGlobal){
+    EXPECT_EQ(run("var a = 1;\nprint a;\nvar a = 2;", 70),
+              "1\n[Line 3] Runtime Error: Cannot redefine a variable. Variable 'a' has already been defined\n");
+    EXPECT_EQ(run("fun f() {}\nclass f {}", 70), "[Line 2] Runtime Error: Cannot redefine a variable. Variable 'f' has already been defined\n");
+    //Only the outermost scope shares one table, a block can shadow a global
+    EXPECT_EQ(run("var a = 1;\n{ var a = 2; print a; }\nprint a;"), "2\n1\n");
+}
+
+TEST_P(GlobalsTest, globalsOfCachedPrograms){
+    //Programs loaded from the AstCache find their globals like freshly resolved ones, including superclasses and ++/--
+    std::string source =
+            "class Base { name() { return \"base\"; } }\n"
+            "class Derived < Base {}\n"
+            "var count = 0;\n"
+            "fun bump() { count++; count = count + 10; count--; }\n"
+            "bump(); bump();\n"
+            "print [Derived().name(), count];\n";
+    std::string directory = ::testing::TempDir() + "globals_test_cache";
+    auto cache = std::make_shared<AstCache>(directory);
+    EXPECT_EQ(run(source, 0, cache), "[base, 20]\n");
+    ASSERT_NE(cache->load(source), nullptr);
+    EXPECT_EQ(run(source, 0, cache), "[base, 20]\n");
+}
+
+INSTANTIATE_BACKENDS(GlobalsTest);
+
+
+/*Variable references cache their global cell by the address of their node, so the programs run by a Runner (every line of the repl)
+ * are kept alive and the cache stays valid while later programs add globals*/
+static std::string runRepl(Runner::Backend backend, const std::string &lines) {
+    std::istringstream input(lines + "quit()\n");
+    std::ostringstream output, prompts;
+    Runner runner(output);
+    runner.backend = backend;
+    std::streambuf* stdinBuffer = std::cin.rdbuf(input.rdbuf());
+    std::streambuf* stdoutBuffer = std::cout.rdbuf(prompts.rdbuf());
+    int exitCode = runner.runRepl();
+    std::cin.rdbuf(stdinBuffer);
+    std::cout.rdbuf(stdoutBuffer);
+    EXPECT_EQ(exitCode, 0);
+    return output.str();
+}
+
+TEST(GlobalsReplTest, globalsLiveAcrossLines){
+    for (Runner::Backend backend : {Runner::Backend::TREE_WALKER, Runner::Backend::CLOSURES}){
+        std::string lines =
+                "fun bump() { count = count + 1; return count; }\n"
+                "bump();\n"
+                "var count = 10;\n"
+                "bump();\n"
+                "bump();\n"
+                "var count = 0;\n"
+                "count;\n"
+                "var other = \"defined later\";\n"
+                "fun read() { return other; }\n"
+                "read();\n"
+                "other = \"changed\";\n"
+                "read();\n";
+        EXPECT_EQ(runRepl(backend, lines),
+                  "[Line 1] Runtime Error: Undefined variable 'count'\n"
+                  "11\n"
+                  "12\n"
+                  "[Line 1] Runtime Error: Cannot redefine a variable. Variable 'count' has already been defined\n"
+                  "12\n"
+                  "defined later\n"
+                  "changed\n" //The repl prints the value of the assignment
+                  "changed\n");
+    }
+}
+
+TEST(GlobalsReplTest, scriptsOnOneRunnerShareGlobals){
+    for (Runner::Backend backend : {Runner::Backend::TREE_WALKER, Runner::Backend::CLOSURES}){
+        std::ostringstream output;
+        Runner runner(output);
+        runner.backend = backend;
+        EXPECT_EQ(runner.runSource("fun total() { return a + b; }\nvar a = 1;"), 0);
+        EXPECT_EQ(runner.runSource("print total();"), 70);
+        EXPECT_EQ(runner.runSource("var b = 2;\nprint total();"), 0);
+        EXPECT_EQ(runner.runSource("a = 40;\nprint total();"), 0);
+        EXPECT_EQ(output.str(), "[Line 1] Runtime Error: Undefined variable 'b'\n3\n42\n");
+    }
+}
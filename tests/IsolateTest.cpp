@@ -0,0 +1,57 @@
+#include "gtest/gtest.h"
+#include <string>
+#include "LoxTestUtils.h"
+
+class IsolateTest : public BackendTest {};
+
+TEST_P(IsolateTest, joinReturnsTheResult){
+    //The isolate starts with a copy of the globals, including functions and classes
+    std::string source =
+            "fun fib(n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+            "class Pair { init(a, b) { this.a = a; this.b = b; } sum() { return this.a + this.b; } }\n"
+            "fun work(n, offset) { print \"working\"; return Pair(fib(n), offset); }\n"
+            "var first = spawn(work, 15, 1);\n"
+            "var second = spawn(work, 16, 2);\n"
+            "print first.join().sum() + second.join().sum();\n";
+    EXPECT_EQ(run(source), "working\nworking\n1600\n");
+}
+
+TEST_P(IsolateTest, messagesAreCopied){
+    std::string source =
+            "class Box { init(value) { this.value = value; } }\n"
+            "fun bump() { var box = receive(); while (box != nil) { box.value = box.value + 1; send(box); box = receive(); } return \"done\"; }\n"
+            "var isolate = spawn(bump);\n"
+            "var box = Box(1);\n"
+            "isolate.send(box);\n"
+            "var reply = isolate.receive();\n"
+            "print [box.value, reply.value];\n"
+            "isolate.send(reply);\n"
+            "print isolate.receive().value;\n"
+            "isolate.send(nil);\n"
+            "print isolate.join();\n";
+    EXPECT_EQ(run(source), "[1, 2]\n3\ndone\n");
+}
+
+TEST_P(IsolateTest, closuresKeepTheirState){
+    std::string source =
+            "fun counter(start) { var count = start; fun next() { count = count + 1; return count; } return next; }\n"
+            "fun apply(f, times) { var last; for (var i = 0; i < times; i++) last = f(); return last; }\n"
+            "var next = counter(10);\n"
+            "next();\n"
+            "print spawn(apply, next, 5).join();\n"
+            "print next();\n";
+    EXPECT_EQ(run(source), "16\n12\n");
+}
+
+TEST_P(IsolateTest, errorsAreReportedByJoin){
+    std::string output = run("fun fail() { return 1 + nil; }\nspawn(fail).join();", 70);
+    EXPECT_NE(output.find("Isolate failed"), std::string::npos);
+
+    output = run("var h = spawn(lambda : 1);\nspawn(lambda x : x, h);", 70);
+    EXPECT_NE(output.find("Cannot copy native function"), std::string::npos);
+
+    output = run("send(1);", 70);
+    EXPECT_NE(output.find("only be called inside an isolate"), std::string::npos);
+}
+
+INSTANTIATE_BACKENDS(IsolateTest);
@@ -0,0 +1,126 @@
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+#include "../AstCache.h"
+#include "LoxTestUtils.h"
+
+class IteratorTest : public BackendTest {};
+
+TEST_P(IteratorTest, forInLists){
+    std::string source =
+            "var total = 0;\n"
+            "for (x in [1, 2, 3, 4]) { if (x == 2) continue; if (x == 4) break; total = total + x; }\n"
+            "print total;\n"
+            "for (x in [\"a\", [1]]) print x;\n"
+            "for (x in []) print x;\n";
+    EXPECT_EQ(run(source), "4\na\n[1]\n");
+}
+
+TEST_P(IteratorTest, inIsNotAKeyword){
+    //Scripts written before for-in can keep using in as a name
+    std::string source =
+            "var in = 1;\n"
+            "fun add(in, out) { return in + out; }\n"
+            "class Stream { in() { return \"method\"; } }\n"
+            "print add(in, 2);\n"
+            "print Stream().in();\n"
+            "for (in = 0; in < 2; in++) print in;\n"
+            "for (var i = in; i < 3; i++) print i;\n"
+            "for (in in [\"a\", \"b\"]) print in;\n"
+            "print in;\n";
+    EXPECT_EQ(run(source), "3\nmethod\n0\n1\n2\na\nb\n2\n");
+
+    EXPECT_EQ(run("for (x of [1]) print x;", 65), "[Line 1] Parsing Error: Expect ';' after value.\n");
+    EXPECT_NE(run("for (", 65).find("Parsing Error"), std::string::npos);
+}
+
+TEST_P(IteratorTest, ranges){
+    std::string source =
+            "for (i in range(3)) print i;\n"
+            "for (i in range(10, 0, -4)) print i;\n"
+            "for (i in range(0, 1, 0.5)) print i;\n"
+            "for (i in range(5, 2)) print i;\n"
+            //A range starts over in every loop, next() and done() walk it by hand
+            "var r = range(1, 3);\n"
+            "for (i in r) print i;\n"
+            "print [r.next(), r.done(), r.next(), r.done(), r.next()];\n";
+    EXPECT_EQ(run(source), "0\n1\n2\n10\n6\n2\n0\n0.5\n1\n2\n[1, false, 2, true, nil]\n");
+}
+
+TEST_P(IteratorTest, generatorsAndInstances){
+    std::string source =
+            "fun letters() { yield(\"a\"); yield(\"b\"); }\n"
+            "for (s in generator(letters)) print s;\n"
+            "class Countdown {\n"
+            "    init(n) { this.n = n; }\n"
+            "    done() { return this.n == 0; }\n"
+            "    next() { this.n = this.n - 1; return this.n + 1; }\n"
+            "}\n"
+            "for (n in Countdown(3)) print n;\n";
+    EXPECT_EQ(run(source), "a\nb\n3\n2\n1\n");
+}
+
+TEST_P(IteratorTest, errors){
+    std::string output = run("for (x in 5) print x;", 70);
+    EXPECT_NE(output.find("[Line 1] Runtime Error: Can only iterate over"), std::string::npos) << output;
+
+    output = run("range(1, 2, 0);", 70);
+    EXPECT_NE(output.find("can't be 0"), std::string::npos) << output;
+
+    output = run("for (x in [1]) print x;\nprint x;", 70);
+    EXPECT_NE(output.find("Undefined variable 'x'"), std::string::npos) << output;
+}
+
+TEST_P(IteratorTest, forInIsCached){
+    std::string directory = ::testing::TempDir() + "iterator_test_cache";
+    auto cache = std::make_shared<AstCache>(directory);
+    std::string source = "for (i in range(2)) for (x in [i, i * 10]) print x;\n";
+    EXPECT_EQ(run(source, 0, cache), "0\n0\n1\n10\n");
+    EXPECT_EQ(run(source, 0, cache), "0\n0\n1\n10\n");
+}
+
+TEST_P(IteratorTest, pipelines){
+    std::string source =
+            "print iter([1, 2, 3, 4, 5, 6]).map(lambda x: x * x).filter(lambda x: x > 4).take(2).collect();\n"
+            "print range(10).skip(7).enumerate().collect();\n"
+            "print range(3).zip([\"a\", \"b\"]).collect();\n"
+            "print range(1, 101).reduce(lambda total, x: total + x, 0);\n"
+            "for (pair in iter([\"x\"]).enumerate()) print pair;\n"
+            "print iter([]).collect();\n";
+    EXPECT_EQ(run(source), "[9, 16]\n[[0, 7], [1, 8], [2, 9]]\n[[0, a], [1, b]]\n5050\n[0, x]\n[]\n");
+}
+
+TEST_P(IteratorTest, pipelinesAreLazy){
+    std::string source =
+            "var calls = 0;\n"
+            "fun count(x) { calls = calls + 1; return x; }\n"
+            "var pipeline = range(1000).map(count).take(3);\n"
+            "print calls;\n"
+            "print pipeline.collect();\n"
+            "print calls;\n"
+            //take() doesn't ask an endless generator for more than it needs
+            "fun naturals() { var i = 0; while (true) { yield(i); i = i + 1; } }\n"
+            "print generator(naturals).filter(lambda x: x / 2 != 1).map(lambda x: x * 10).take(4).collect();\n"
+            //A step consumes the iterator it was created on, ranges start over
+            "var letters = iter([\"a\", \"b\", \"c\"]);\n"
+            "print [letters.next(), letters.map(lambda s: s).collect(), letters.done()];\n"
+            "var r = range(2);\n"
+            "print [r.map(lambda x: x).collect(), r.collect()];\n";
+    EXPECT_EQ(run(source), "0\n[0, 1, 2]\n3\n[0, 10, 30, 40]\n[a, [b, c], true]\n[[0, 1], [0, 1]]\n");
+}
+
+TEST_P(IteratorTest, pipelineErrors){
+    std::string output = run("range(3).map(lambda a, b: a);", 70);
+    EXPECT_NE(output.find("The function passed to map() must take 1 argument(s)"), std::string::npos) << output;
+
+    output = run("range(3).take(-1);", 70);
+    EXPECT_NE(output.find("non negative integer"), std::string::npos) << output;
+
+    output = run("iter(nil);", 70);
+    EXPECT_NE(output.find("Can only iterate over"), std::string::npos) << output;
+
+    output = run("print range(3).map(lambda x: x / nil).collect();", 70);
+    EXPECT_NE(output.find("Runtime Error"), std::string::npos) << output;
+}
+
+INSTANTIATE_BACKENDS(IteratorTest);
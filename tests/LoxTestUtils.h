@@ -0,0 +1,34 @@
+#ifndef JLOX_LOXTESTUTILS_H
+#define JLOX_LOXTESTUTILS_H
+
+#include "gtest/gtest.h"
+#include <memory>
+#include <sstream>
+#include <string>
+#include "../ProgramCache.h"
+#include "../Runner.h"
+
+//Runs source on a new Runner, checks its exit code and returns everything it wrote (the output and the error messages)
+inline std::string runLox(const std::string &source, Runner::Backend backend, int expectedExitCode = 0,
+                          const std::shared_ptr<ProgramCache> &cache = nullptr) {
+    std::ostringstream output;
+    Runner runner(output);
+    runner.backend = backend;
+    runner.programCache = cache;
+    EXPECT_EQ(runner.runSource(source), expectedExitCode) << output.str();
+    return output.str();
+}
+
+/*Fixture of the suites whose tests run on both backends, which must behave the same. A suite derives from it and is instantiated with
+ * INSTANTIATE_BACKENDS(Suite), every test then runs once per backend.*/
+class BackendTest : public ::testing::TestWithParam<Runner::Backend> {
+protected:
+    std::string run(const std::string &source, int expectedExitCode = 0, const std::shared_ptr<ProgramCache> &cache = nullptr) {
+        return runLox(source, GetParam(), expectedExitCode, cache);
+    }
+};
+
+#define INSTANTIATE_BACKENDS(Suite) \
+    INSTANTIATE_TEST_SUITE_P(Backends, Suite, ::testing::Values(Runner::Backend::TREE_WALKER, Runner::Backend::CLOSURES))
+
+#endif //JLOX_LOXTESTUTILS_H
@@ -0,0 +1,86 @@
+#include "gtest/gtest.h"
+#include <string>
+#include "LoxTestUtils.h"
+
+class MemoizeTest : public BackendTest {};
+
+TEST_P(MemoizeTest, recursiveCallsGoThroughTheCache){
+    std::string source =
+            "var calls = 0;\n"
+            "fun fib(n) { calls = calls + 1; if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+            "fib = memoize(fib);\n"
+            "print fib(70);\n"
+            "print calls;\n"
+            "print fib(70);\n"
+            "var stats = memo_stats(fib);\n"
+            "print [stats.hits, stats.misses, stats.size, stats.evictions, stats.capacity];\n";
+    EXPECT_EQ(run(source), "190392490709135\n71\n190392490709135\n[69, 71, 71, 0, nil]\n");
+}
+
+TEST_P(MemoizeTest, argumentKeys){
+    std::string source =
+            "var calls = 0;\n"
+            "fun describe(a, b) { calls = calls + 1; return [a, b]; }\n"
+            "var memo = memoize(describe);\n"
+            "var list = [1];\n"
+            "class Point {}\n"
+            "var point = Point();\n"
+            "memo(1, \"a\"); memo(1, \"a\"); memo(1, \"b\"); memo(0, true); memo(-0, true); memo(nil, false);\n"
+            "print calls;\n"
+            //Lists and instances are compared by identity
+            "memo(list, point); memo(list, point); memo([1], point); memo(list, Point());\n"
+            "print calls;\n"
+            //NaN isn't equal to itself, so it is never cached
+            "var infinity = 1;\n"
+            "for (i in range(400)) infinity = infinity * 10;\n"
+            "memo(infinity - infinity, 1); memo(infinity - infinity, 1);\n"
+            "print [calls, memo_stats(memo).size];\n"
+            "print memo;\n";
+    EXPECT_EQ(run(source), "4\n7\n[9, 7]\n<memoized <function describe>>\n");
+}
+
+TEST_P(MemoizeTest, leastRecentlyUsedEviction){
+    std::string source =
+            "var square = memoize(lambda x: x * x, 2);\n"
+            "print [square(1), square(2), square(1), square(3), square(2), square(1)];\n"
+            "var stats = memo_stats(square);\n"
+            "print [stats.hits, stats.misses, stats.size, stats.evictions, stats.capacity];\n"
+            //Many evictions in a small table, every result must still be right
+            "var cube = memoize(lambda x: x * x * x, 7);\n"
+            "var ok = true;\n"
+            "for (i in range(300)) for (x in [i, i - 3, i - 5, i, i - 20, 2, i * 0.5]) if (cube(x) != x * x * x) ok = false;\n"
+            "print ok;\n"
+            "print memo_stats(cube).size;\n";
+    EXPECT_EQ(run(source), "[1, 4, 1, 9, 4, 1]\n[1, 5, 2, 3, 2]\ntrue\n7\n");
+}
+
+TEST_P(MemoizeTest, copiesHaveTheirOwnCache){
+    std::string source =
+            "fun fib(n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+            "fib = memoize(fib);\n"
+            "var isolate = spawn(lambda: send(fib(60)));\n"
+            "print isolate.receive();\n"
+            "isolate.join();\n"
+            "print memo_stats(fib).size;\n"
+            //Globals are shared by the workers of the pool, a memoized function has to be captured or passed to a task
+            "fun inTask() {\n"
+            "    var twice = memoize(lambda x: x * 2);\n"
+            "    print task(lambda: twice(21)).join();\n"
+            "    print memo_stats(twice).size;\n"
+            "}\n"
+            "inTask();\n";
+    EXPECT_EQ(run(source), "1548008755920\n0\n42\n0\n");
+}
+
+TEST_P(MemoizeTest, errors){
+    std::string output = run("memoize(clock, 0);", 70);
+    EXPECT_NE(output.find("The capacity of memoize() must be a positive integer"), std::string::npos) << output;
+
+    output = run("memo_stats(clock);", 70);
+    EXPECT_NE(output.find("memo_stats() expects a function returned by memoize()"), std::string::npos) << output;
+
+    output = run("var f = memoize(lambda x: x); f(1, 2);", 70);
+    EXPECT_NE(output.find("expected 1 argument(s) but instead got 2"), std::string::npos) << output;
+}
+
+INSTANTIATE_BACKENDS(MemoizeTest);
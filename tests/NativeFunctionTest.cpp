@@ -0,0 +1,53 @@
+#include "gtest/gtest.h"
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include "../Lox.h"
+
+//Runs source on a Lox with natives that take each kind of parameter, returns the output and the exit code
+static std::string runNatives(const std::string &source, int expectedExitCode = 0) {
+    std::ostringstream output;
+    Lox lox(output);
+    lox.registerNative("takes", [](double number, const std::string &string, bool boolean, const SharedListPtr &) {
+        return string + std::to_string(static_cast<int>(number)) + (boolean ? "!" : "?");
+    });
+    lox.registerNative("int32", [](int32_t x) { return x; });
+    lox.registerNative("uint8", [](uint8_t x) { return x; });
+    lox.registerNative("int64", [](int64_t x) { return static_cast<double>(x); });
+    lox.registerNative("size", [](size_t x) { return static_cast<double>(x); });
+    EXPECT_EQ(lox.run("var infinity = 1;\nfor (var i = 0; i < 400; i++) infinity = infinity * 10;\n" + source), expectedExitCode) << output.str();
+    return output.str();
+}
+
+TEST(NativeFunctionTest, argumentTypes){
+    EXPECT_EQ(runNatives("print takes(4, \"x\", true, []);"), "x4!\n");
+    EXPECT_EQ(runNatives("takes(\"4\", \"x\", true, []);", 70), "Runtime Error: Function 'takes' expected a number as argument 1 but got string\n");
+    EXPECT_EQ(runNatives("takes(4, nil, true, []);", 70), "Runtime Error: Function 'takes' expected a string as argument 2 but got nil\n");
+    EXPECT_EQ(runNatives("takes(4, \"x\", 1, []);", 70), "Runtime Error: Function 'takes' expected a boolean as argument 3 but got number\n");
+    EXPECT_EQ(runNatives("takes(4, \"x\", true, clock);", 70), "Runtime Error: Function 'takes' expected a list as argument 4 but got callable\n");
+    EXPECT_EQ(runNatives("takes(4, \"x\", true);", 70), "[Line 3] Runtime Error: takes expected 4 argument(s) but instead got 3\n");
+}
+
+TEST(NativeFunctionTest, integerRanges){
+    EXPECT_EQ(runNatives("print [int32(2147483647), int32(-2147483648), uint8(0), uint8(255), int64(9007199254740992), size(0)];"),
+              "[2147483647, -2147483648, 0, 255, 9007199254740992, 0]\n");
+
+    const std::string int32Error = "Runtime Error: Function 'int32' expected an integer between -2147483648 and 2147483647 as argument 1 but got ";
+    EXPECT_EQ(runNatives("int32(2147483648);", 70), int32Error + "2147483648\n");
+    EXPECT_EQ(runNatives("int32(-2147483649);", 70), int32Error + "-2147483649\n");
+    EXPECT_EQ(runNatives("int32(1.5);", 70), int32Error + "1.5\n");
+    EXPECT_EQ(runNatives("int32(infinity);", 70), int32Error + "inf\n");
+    EXPECT_EQ(runNatives("int32(-infinity);", 70), int32Error + "-inf\n");
+    EXPECT_NE(runNatives("int32(infinity - infinity);", 70).find(int32Error), std::string::npos);
+
+    EXPECT_EQ(runNatives("uint8(256);", 70), "Runtime Error: Function 'uint8' expected an integer between 0 and 255 as argument 1 but got 256\n");
+    EXPECT_EQ(runNatives("size(-1);", 70).find("Runtime Error: Function 'size' expected an integer between 0 and "), 0u);
+    EXPECT_EQ(runNatives("int64(infinity);", 70).find("Runtime Error: Function 'int64' expected an integer between"), 0u);
+}
+
+TEST(NativeFunctionTest, builtinsCheckTheirIntegers){
+    //Script input used to reach the casts in sleep() and fork_map()
+    EXPECT_NE(runNatives("sleep(infinity - infinity);", 70).find("Function 'sleep' expected an integer"), std::string::npos);
+    EXPECT_NE(runNatives("fork_map([1], lambda x : x, infinity);", 70).find("Function 'fork_map' expected an integer"), std::string::npos);
+}
@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+#include <string>
+#include "../LoxObject.h"
+#include "../Token.h"
+#include "LoxTestUtils.h"
+
+static std::string formatted(double number) {
+    std::string out;
+    LoxObject(number).format(out);
+    return out;
+}
+
+static double parsed(const std::string &literal) {
+    return LoxObject(Token(TokenType::NUMBER, literal, 1)).getNumber();
+}
+
+TEST(NumberTest, shortestRoundTrip){
+    EXPECT_EQ(formatted(0.1), "0.1");
+    EXPECT_EQ(formatted(2.5), "2.5");
+    EXPECT_EQ(formatted(-2.5), "-2.5");
+    EXPECT_EQ(formatted(0.1 + 0.2), "0.30000000000000004");
+    EXPECT_EQ(formatted(1.0 / 3), "0.3333333333333333");
+    EXPECT_EQ(formatted(1e21), "1e+21");
+    EXPECT_EQ(formatted(0.000001), "1e-06");
+    EXPECT_EQ(formatted(0.00001234), "1.234e-05");
+    EXPECT_EQ(formatted(0.0001), "1e-04"); //Whichever of the fixed and the scientific form is shorter
+    EXPECT_EQ(formatted(0.001), "0.001");
+}
+
+TEST(NumberTest, integers){
+    //The small integers come from a cache, the others from to_chars
+    EXPECT_EQ(formatted(0), "0");
+    EXPECT_EQ(formatted(-0.0), "0");
+    EXPECT_EQ(formatted(1023), "1023");
+    EXPECT_EQ(formatted(1024), "1024");
+    EXPECT_EQ(formatted(-1), "-1");
+    EXPECT_EQ(formatted(-1024), "-1024");
+    //Up to 2^53 every integer is exact and printed in full, past it the shortest double form is used
+    EXPECT_EQ(formatted(9007199254740992.0), "9007199254740992");
+    EXPECT_EQ(formatted(-9007199254740992.0), "-9007199254740992");
+    EXPECT_EQ(formatted(9007199254740994.0), "9007199254740994");
+    EXPECT_EQ(formatted(1e300), "1e+300");
+}
+
+TEST(NumberTest, literals){
+    EXPECT_EQ(parsed("0"), 0);
+    EXPECT_EQ(parsed("2.5"), 2.5);
+    EXPECT_EQ(parsed("0.1"), 0.1);
+    //2^53 + 1 isn't a double, it rounds to the nearest even one
+    EXPECT_EQ(parsed("9007199254740993"), 9007199254740992.0);
+    EXPECT_EQ(parsed("1" + std::string(400, '0')), std::numeric_limits<double>::infinity());
+    EXPECT_EQ(parsed("1" + std::string(400, '0') + ".5"), std::numeric_limits<double>::infinity());
+    EXPECT_EQ(parsed("0." + std::string(400, '0') + "1"), 0.0);
+    EXPECT_EQ(parsed("0000." + std::string(400, '0') + "1"), 0.0);
+    EXPECT_GT(parsed("0." + std::string(320, '0') + "1"), 0.0); //Denormal, still representable
+}
+
+class NumberBackendTest : public BackendTest {};
+
+TEST_P(NumberBackendTest, printedNumbers){
+    std::string source =
+            "print [0.1, 2.5, 0.1 + 0.2, 1000000000000000000000, 0.000001, 9007199254740993];\n"
+            "print [1023, 1024, 1023 + 1, -1024, 1024 / 2];\n"
+            "print 1" + std::string(400, '0') + ";\n"
+            "print -1" + std::string(400, '0') + ";\n";
+    EXPECT_EQ(run(source), "[0.1, 2.5, 0.30000000000000004, 1e+21, 1e-06, 9007199254740992]\n[1023, 1024, 1024, -1024, 512]\ninf\n-inf\n");
+}
+
+INSTANTIATE_BACKENDS(NumberBackendTest);
@@ -0,0 +1,166 @@
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "../Runner.h"
+#include "../standardlib/NativeFunction.h"
+
+//Every thread declares the same globals with different values, so any state shared between runners shows up in the output
+static std::string scriptFor(int id) {
+    std::string n = std::to_string(id);
+    return "var id = " + n + ";\n"
+           "class Counter {\n"
+           "  init(start) { this.count = start; }\n"
+           "  next() { this.count = this.count + id; return this.count; }\n"
+           "}\n"
+           "fun fib(n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+           "var counter = Counter(0);\n"
+           "for (var i = 0; i < 1000; i++) counter.next();\n"
+           "var add = lambda a, b : a + b;\n"
+           "print add(counter.count, fib(15));\n"
+           "print [id, str(id)];\n";
+}
+
+static std::string expectedFor(int id) {
+    std::ostringstream expected;
+    expected << (1000 * id + 610) << "\n[" << id << ", " << id << "]\n";
+    return expected.str();
+}
+
+TEST(RunnerTest, runnersDontShareState){
+    std::ostringstream first, second;
+    Runner runner1(first), runner2(second);
+    EXPECT_EQ(runner1.runSource("var x = 1; print x;"), 0);
+    EXPECT_EQ(runner2.runSource("print x;"), 70);
+    EXPECT_EQ(first.str(), "1\n");
+    EXPECT_NE(second.str().find("Undefined variable"), std::string::npos);
+}
+
+TEST(RunnerTest, errorsGoToTheRunnerOutput){
+    std::ostringstream output;
+    Runner runner(output);
+    EXPECT_EQ(runner.runSource("print 1;\nvar = 1;"), 65);
+    EXPECT_NE(output.str().find("Parsing Error"), std::string::npos);
+}
+
+TEST(RunnerTest, runnersRunConcurrently){
+    const int threadCount = 8;
+    for (Runner::Backend backend : {Runner::Backend::TREE_WALKER, Runner::Backend::CLOSURES}){
+        std::vector<std::ostringstream> outputs(threadCount);
+        std::vector<int> exitCodes(threadCount, -1);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < threadCount; i++){
+            threads.emplace_back([&, i] {
+                for (int repeat = 0; repeat < 5 && exitCodes[i] <= 0; repeat++){
+                    Runner runner(outputs[i]);
+                    runner.backend = backend;
+                    exitCodes[i] = runner.runSource(scriptFor(i + 1));
+                }
+            });
+        }
+        for (std::thread &thread : threads){
+            thread.join();
+        }
+
+        for (int i = 0; i < threadCount; i++){
+            EXPECT_EQ(exitCodes[i], 0);
+            std::string expected;
+            for (int repeat = 0; repeat < 5; repeat++) expected += expectedFor(i + 1);
+            EXPECT_EQ(outputs[i].str(), expected);
+        }
+    }
+}
+
+TEST(RunnerTest, runnersShareResolvedPrograms){
+    const int threadCount = 8;
+    std::ostringstream errors;
+    std::shared_ptr<const Program> program = Runner(errors).loadProgram(
+            "fun makeCounter() { var count = 0; fun next() { count = count + 1; return count; } return next; }\n"
+            "var counter = makeCounter();\n"
+            "for (var i = 0; i < 1000; i++) counter();\n"
+            "print counter();\n");
+    ASSERT_NE(program, nullptr) << errors.str();
+
+    for (Runner::Backend backend : {Runner::Backend::TREE_WALKER, Runner::Backend::CLOSURES}){
+        std::vector<std::ostringstream> outputs(threadCount);
+        std::vector<int> exitCodes(threadCount, -1);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < threadCount; i++){
+            threads.emplace_back([&, i] {
+                Runner runner(outputs[i]);
+                runner.backend = backend;
+                exitCodes[i] = runner.runProgram(program);
+            });
+        }
+        for (std::thread &thread : threads){
+            thread.join();
+        }
+
+        for (int i = 0; i < threadCount; i++){
+            EXPECT_EQ(exitCodes[i], 0);
+            EXPECT_EQ(outputs[i].str(), "1001\n");
+        }
+    }
+}
+
+TEST(RunnerTest, flushAndUnbufferedOutput){
+    for (bool unbuffered : {false, true}){
+        std::ostringstream output;
+        Runner runner(output);
+        runner.unbufferedOutput = unbuffered;
+        //What reached the sink so far, seen from inside the script
+        runner.getInterpreter().globals.define("written", LoxObject(standardFunctions::makeNative("written", [&output]() {
+            return output.str();
+        })));
+        EXPECT_EQ(runner.runSource("print \"a\";\nvar before = written();\nflush();\nvar after = written();\nprint [before, after];"), 0);
+        EXPECT_EQ(output.str(), unbuffered ? "a\n[a\n, a\n]\n" : "a\n[, a\n]\n");
+    }
+}
+
+//The buffered output, the runtime errors and the text the Runner writes through std::cout all end up on stdout in the order they happened
+TEST(RunnerTest, outputErrorsAndPromptsStayInOrder){
+    char path[] = "/tmp/lox_runner_test_XXXXXX";
+    int file = mkstemp(path);
+    ASSERT_GE(file, 0);
+    std::istringstream input("print \"first\";\n1 + nil;\nprint \"second\";\nquit()\n");
+    std::streambuf* stdinBuffer = std::cin.rdbuf(input.rdbuf());
+    std::cout.flush();
+    int stdoutCopy = dup(STDOUT_FILENO);
+    dup2(file, STDOUT_FILENO);
+
+    int replExitCode, scriptExitCode;
+    {
+        Runner runner;
+        replExitCode = runner.runRepl();
+    }
+    {
+        Runner runner;
+        scriptExitCode = runner.runSource("print \"script\";\nprint nil + 1;");
+    }
+
+    std::cout.flush();
+    dup2(stdoutCopy, STDOUT_FILENO);
+    close(stdoutCopy);
+    close(file);
+    std::cin.rdbuf(stdinBuffer);
+
+    std::ifstream written(path);
+    std::string contents((std::istreambuf_iterator<char>(written)), std::istreambuf_iterator<char>());
+    std::remove(path);
+    EXPECT_EQ(replExitCode, 0);
+    EXPECT_EQ(scriptExitCode, 70);
+    EXPECT_EQ(contents, "Interactive Repl mode. Type \"quit()\" or press CTRL-C to exit\n"
+                        "< first\n"
+                        "< [Line 1] Runtime Error: Cannot apply operator '+' to operands of type number and nil\n"
+                        "< second\n"
+                        "< "
+                        "script\n"
+                        "[Line 2] Runtime Error: Cannot apply operator '+' to operands of type nil and number\n");
+}
@@ -0,0 +1,79 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "../Server.h"
+
+class ServerTest : public ::testing::Test {
+protected:
+    std::string socketPath = "/tmp/jlox-server-test-" + std::to_string(::getpid()) + ".sock";
+    Server server{socketPath};
+    std::thread serverThread;
+
+    void SetUp() override {
+        serverThread = std::thread([this] { server.run(); });
+        //Wait until the socket accepts connections
+        for (int i = 0; i < 100 && ::access(socketPath.c_str(), F_OK) != 0; i++){
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    void TearDown() override {
+        server.stop();
+        serverThread.join();
+    }
+
+    int submit(const std::string &source, const std::vector<std::string> &args, std::string &output) {
+        std::ostringstream stream;
+        int exitCode = Server::submit(socketPath, source, args, stream);
+        output = stream.str();
+        return exitCode;
+    }
+};
+
+TEST_F(ServerTest, runsJobsWithArguments){
+    std::string output;
+    EXPECT_EQ(submit("print args; print 1 + 2;", {"a", "b c"}, output), 0);
+    EXPECT_EQ(output, "[a, b c]\n3\n");
+
+    EXPECT_EQ(submit("print undefined;", {}, output), 70);
+    EXPECT_NE(output.find("Undefined variable"), std::string::npos);
+    EXPECT_EQ(submit("var = 1;", {}, output), 65);
+}
+
+TEST_F(ServerTest, jobsAreIsolated){
+    std::string source = "var x = 1; fun f() { return x; } print f();";
+    std::vector<std::thread> clients;
+    std::vector<std::string> outputs(8);
+    std::vector<int> exitCodes(8);
+    for (int i = 0; i < 8; i++){
+        clients.emplace_back([&, i] { exitCodes[i] = submit(source, {}, outputs[i]); });
+    }
+    for (std::thread &client : clients){
+        client.join();
+    }
+
+    for (int i = 0; i < 8; i++){
+        EXPECT_EQ(exitCodes[i], 0);
+        EXPECT_EQ(outputs[i], "1\n");
+    }
+}
+
+TEST_F(ServerTest, largeOutputKeepsItsOrder){
+    //More output than fits in one message, flushed in the middle and followed by an error
+    std::string source =
+            "for (var i = 0; i < 20000; i++) print i;\n"
+            "flush();\n"
+            "print \"last\";\n"
+            "print nil + 1;\n";
+    std::string expected;
+    for (int i = 0; i < 20000; i++) expected += std::to_string(i) + "\n";
+    expected += "last\n[Line 4] Runtime Error: Cannot apply operator '+' to operands of type nil and number\n";
+
+    std::string output;
+    EXPECT_EQ(submit(source, {}, output), 70);
+    EXPECT_EQ(output, expected);
+}
@@ -0,0 +1,123 @@
+#include "gtest/gtest.h"
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include "../Runner.h"
+#include "LoxTestUtils.h"
+
+class SnapshotTest : public BackendTest {
+protected:
+    std::string directory;
+
+    void SetUp() override {
+        std::string pattern = ::testing::TempDir() + "snapshot_XXXXXX";
+        ASSERT_NE(mkdtemp(pattern.data()), nullptr);
+        directory = pattern;
+    }
+
+    //Runs the prelude and stores the globals it leaves in image
+    std::string create(const std::string &image, const std::string &prelude, int expectedExitCode = 0) {
+        std::ostringstream output;
+        Runner runner(output);
+        runner.backend = GetParam();
+        runner.snapshotCreatePath = image;
+        EXPECT_EQ(runner.runSource(prelude), expectedExitCode) << output.str();
+        return output.str();
+    }
+
+    std::string runWith(const std::string &image, const std::string &source, Runner::Backend backend, int expectedExitCode = 0) {
+        std::ostringstream output;
+        Runner runner(output);
+        runner.backend = backend;
+        runner.snapshotPath = image;
+        EXPECT_EQ(runner.runSource(source), expectedExitCode) << output.str();
+        return output.str();
+    }
+};
+
+static std::string readFile(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void writeFile(const std::string &path, const std::string &bytes) {
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes;
+}
+
+TEST_P(SnapshotTest, roundTrip){
+    std::string image = directory + "/prelude.img";
+    std::string prelude =
+            "print \"prelude runs once\";\n"
+            "class Shape { init(name) { this.name = name; } area() { return 0; } describe() { return this.name + \" \" + str(this.area()); } }\n"
+            "class Square < Shape { init(side) { super.init(\"square\"); this.side = side; } area() { return this.side * this.side; } }\n"
+            "fun counter() { var count = 0; fun next() { count = count + 1; return count; } return next; }\n"
+            "var next = counter();\n"
+            "next();\n"
+            "var shared = [1, 2];\n"
+            "var unit = Square(1);\n"
+            "var alias = unit;\n"
+            "unit.self = unit;\n"
+            "var double = lambda x: x * 2;\n"
+            "var limits = [nil, true, 2.5, \"text\"];\n";
+    EXPECT_EQ(create(image, prelude), "prelude runs once\n");
+
+    std::string script =
+            "print Square(3).describe();\n"
+            "print next();\n"
+            "print next();\n"
+            "alias.side = 5;\n"
+            "print unit.area();\n"
+            "print unit.self.self == unit;\n"
+            "print shared;\n"
+            "print double(21);\n"
+            "print limits;\n"
+            "print clock() > 0;\n";
+    std::string expected = "square 9\n2\n3\n25\ntrue\n[1, 2]\n42\n[nil, true, 2.5, text]\ntrue\n";
+    //The image doesn't depend on the backend that created it, and every run starts from the same state
+    EXPECT_EQ(runWith(image, script, Runner::Backend::TREE_WALKER), expected);
+    EXPECT_EQ(runWith(image, script, Runner::Backend::CLOSURES), expected);
+    EXPECT_EQ(runWith(image, "var shared = 1;", GetParam(), 70),
+              "[Line 1] Runtime Error: Cannot redefine a variable. Variable 'shared' has already been defined\n");
+}
+
+TEST_P(SnapshotTest, rejectsWhatIsNotASnapshot){
+    std::string image = directory + "/prelude.img";
+    std::string prelude = "fun greet(name) { return \"hello \" + name; }\nvar greeting = greet(\"prelude\");\n";
+    create(image, prelude);
+    std::string bytes = readFile(image);
+    ASSERT_FALSE(bytes.empty());
+
+    std::string missing = directory + "/missing.img";
+    EXPECT_EQ(runWith(missing, "print 1;", GetParam(), 66), "Error: Could not open snapshot " + missing + "\n");
+
+    //The prelude source, an image from another version of the format and a modified image are all refused before anything runs
+    std::string source = directory + "/prelude.lox";
+    writeFile(source, prelude);
+    EXPECT_EQ(runWith(source, "print 1;", GetParam(), 66), "Error: " + source + " is not a snapshot created by this version of jlox\n");
+
+    std::string version = bytes;
+    version[8] ^= 1;
+    writeFile(image, version);
+    EXPECT_EQ(runWith(image, "print 1;", GetParam(), 66), "Error: " + image + " is not a snapshot created by this version of jlox\n");
+
+    std::string modified = bytes;
+    modified[bytes.size() - 5] ^= 0x5a;
+    writeFile(image, modified);
+    EXPECT_EQ(runWith(image, "print 1;", GetParam(), 66), "Error: Snapshot " + image + " is corrupted\n");
+
+    writeFile(image, bytes.substr(0, bytes.size() - 3));
+    EXPECT_EQ(runWith(image, "print 1;", GetParam(), 66), "Error: Snapshot " + image + " is corrupted\n");
+
+    writeFile(image, bytes);
+    EXPECT_EQ(runWith(image, "print greeting;", GetParam()), "hello prelude\n");
+}
+
+TEST_P(SnapshotTest, failedPreludesAreNotStored){
+    std::string image = directory + "/prelude.img";
+    EXPECT_EQ(create(image, "var a = 1;\nprint a + nil;", 70), "[Line 2] Runtime Error: Cannot apply operator '+' to operands of type number and nil\n");
+    EXPECT_TRUE(readFile(image).empty());
+}
+
+INSTANTIATE_BACKENDS(SnapshotTest);
@@ -0,0 +1,87 @@
+#include "gtest/gtest.h"
+#include <string>
+#include "LoxTestUtils.h"
+
+class TaskPoolTest : public BackendTest {};
+
+TEST_P(TaskPoolTest, recursiveTasks){
+    //Tasks created by tasks run on the same pool, joining them runs other tasks meanwhile
+    std::string source =
+            "fun fib(n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+            "fun parallelFib(n) {\n"
+            "    if (n < 12) return fib(n);\n"
+            "    var left = task(parallelFib, n - 1);\n"
+            "    var right = task(parallelFib, n - 2);\n"
+            "    return left.join() + right.join();\n"
+            "}\n"
+            "print task(parallelFib, 18).join();\n"
+            "print fib(18);\n";
+    EXPECT_EQ(run(source), "2584\n2584\n");
+}
+
+TEST_P(TaskPoolTest, argumentsAndResultsAreCopied){
+    std::string source =
+            "class Box { init(value) { this.value = value; } }\n"
+            "fun bump(box) { box.value = box.value + 1; return box; }\n"
+            "var box = Box(1);\n"
+            "var result = task(bump, box).join();\n"
+            "print [box.value, result.value];\n"
+            "fun adder(n) { return lambda x : x + n; }\n"
+            "print task(adder(10), 5).join();\n";
+    EXPECT_EQ(run(source), "[1, 2]\n15\n");
+}
+
+TEST_P(TaskPoolTest, outputGoesToTheJoiner){
+    std::string source =
+            "fun hello(name) { print \"hello \" + name; return name; }\n"
+            "var first = task(hello, \"a\");\n"
+            "var second = task(hello, \"b\");\n"
+            "print second.join();\n"
+            "print first.join();\n";
+    EXPECT_EQ(run(source), "hello b\nb\nhello a\na\n");
+}
+
+TEST_P(TaskPoolTest, tasksMustBePure){
+    std::string output = run("fun fail() { return 1 + nil; }\ntask(fail).join();", 70);
+    EXPECT_NE(output.find("Task failed"), std::string::npos);
+
+    output = run("fun counter() { var count = 0; fun next() { count = count + 1; return count; } return next; }\n"
+                 "task(counter()).join();", 70);
+    EXPECT_NE(output.find("tasks can only modify their own variables"), std::string::npos);
+
+    output = run("var total = 1;\nfun read() { return total; }\ntask(read).join();", 70);
+    EXPECT_NE(output.find("Undefined variable"), std::string::npos);
+
+    output = run("fun f() { return 1; }\nfun replace() { f = nil; }\ntask(replace).join();", 70);
+    EXPECT_NE(output.find("tasks can only modify their own variables"), std::string::npos);
+}
+
+TEST_P(TaskPoolTest, parallelMap){
+    std::string source =
+            "fun square(x) { return x * x; }\n"
+            "print parallel_map([0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19], square);\n"
+            "print parallel_map([\"a\", \"b\", \"c\"], lambda s : s + \"!\");\n"
+            "print parallel_map([], square);\n";
+    EXPECT_EQ(run(source), "[0, 1, 4, 9, 16, 25, 36, 49, 64, 81, 100, 121, 144, 169, 196, 225, 256, 289, 324, 361]\n[a!, b!, c!]\n[]\n");
+}
+
+TEST_P(TaskPoolTest, parallelReduce){
+    std::string source =
+            "print parallel_reduce([1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20], lambda a, b : a + b, 0);\n"
+            "print parallel_reduce([\"a\", \"b\", \"c\", \"d\"], lambda a, b : a + b, \">\");\n"
+            "print parallel_reduce([], lambda a, b : a + b, 42);\n";
+    EXPECT_EQ(run(source), "210\n>abcd\n42\n");
+}
+
+TEST_P(TaskPoolTest, parallelMapReportsTheFirstError){
+    //Items 3 and 5 both fail, the output of the items before the first error is kept
+    std::string source =
+            "fun check(x) { print x; if (x == 3 or x == 5) return x + nil; return x; }\n"
+            "parallel_map([0, 1, 2, 3, 4, 5, 6], check);\n";
+    std::string output = run(source, 70);
+    EXPECT_EQ(output.substr(0, 8), "0\n1\n2\n3\n");
+    EXPECT_NE(output.find("parallel_map failed on item 3"), std::string::npos) << output;
+    EXPECT_EQ(output.find("4\n"), std::string::npos) << output;
+}
+
+INSTANTIATE_BACKENDS(TaskPoolTest);
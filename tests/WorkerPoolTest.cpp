@@ -0,0 +1,56 @@
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "../Runner.h"
+#include "../WorkerPool.h"
+
+class WorkerPoolTest : public ::testing::Test {
+protected:
+    std::vector<std::string> scripts;
+
+    std::string writeScript(const std::string &source) {
+        std::string path = "/tmp/jlox-worker-test-" + std::to_string(::getpid()) + "-" + std::to_string(scripts.size()) + ".lox";
+        std::ofstream(path) << source;
+        scripts.push_back(path);
+        return path;
+    }
+
+    void TearDown() override {
+        for (const std::string &script : scripts){
+            std::remove(script.c_str());
+        }
+    }
+};
+
+TEST_F(WorkerPoolTest, outputIsInScriptOrder){
+    //The first scripts are the slowest, so they finish last
+    for (int i = 0; i < 6; i++){
+        writeScript("sleep(" + std::to_string((6 - i) * 10) + "); print " + std::to_string(i) + ";");
+    }
+
+    Runner zygote;
+    WorkerPool pool(zygote, 3);
+    std::ostringstream output;
+    EXPECT_EQ(pool.run(scripts, output), 0);
+    EXPECT_EQ(output.str(), "0\n1\n2\n3\n4\n5\n");
+}
+
+TEST_F(WorkerPoolTest, scriptsStartFromTheZygoteState){
+    Runner zygote;
+    ASSERT_EQ(zygote.runSource("var counter = 0; fun next() { counter = counter + 1; return counter; }"), 0);
+    writeScript("print next();");
+    writeScript("print next();");
+    writeScript("print undefinedVariable;");
+    writeScript("print next();");
+
+    WorkerPool pool(zygote, 2);
+    std::ostringstream output;
+    EXPECT_EQ(pool.run(scripts, output), 70);
+    EXPECT_EQ(output.str().substr(0, 4), "1\n1\n");
+    EXPECT_NE(output.str().find("Undefined variable"), std::string::npos);
+    EXPECT_EQ(output.str().substr(output.str().size() - 2), "1\n");
+}
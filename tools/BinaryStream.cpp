@@ -0,0 +1,184 @@
+#include "BinaryStream.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+void binary::Writer::u8(uint8_t value) {
+    bytes.push_back(value);
+}
+
+void binary::Writer::u32(uint32_t value) {
+    for (int i = 0; i < 4; i++){
+        bytes.push_back((value >> (8 * i)) & 0xff);
+    }
+}
+
+void binary::Writer::u64(uint64_t value) {
+    for (int i = 0; i < 8; i++){
+        bytes.push_back((value >> (8 * i)) & 0xff);
+    }
+}
+
+void binary::Writer::varint(uint64_t value) {
+    while (value >= 0x80){
+        bytes.push_back((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    bytes.push_back(value);
+}
+
+void binary::Writer::number(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    u64(bits);
+}
+
+void binary::Writer::string(std::string_view value) {
+    varint(value.size());
+    raw(value.data(), value.size());
+}
+
+void binary::Writer::raw(const void *data, size_t size) {
+    const auto* begin = static_cast<const uint8_t*>(data);
+    bytes.insert(bytes.end(), begin, begin + size);
+}
+
+
+binary::Reader::Reader(const uint8_t *data, size_t size) : current(data), end(data + size) {}
+
+uint8_t binary::Reader::u8() {
+    return *raw(1);
+}
+
+uint32_t binary::Reader::u32() {
+    const uint8_t* data = raw(4);
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++){
+        value |= (uint32_t) data[i] << (8 * i);
+    }
+    return value;
+}
+
+uint64_t binary::Reader::u64() {
+    const uint8_t* data = raw(8);
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++){
+        value |= (uint64_t) data[i] << (8 * i);
+    }
+    return value;
+}
+
+uint64_t binary::Reader::varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7){
+        uint8_t byte = u8();
+        value |= (uint64_t) (byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+
+    throw FormatError("Malformed varint");
+}
+
+double binary::Reader::number() {
+    uint64_t bits = u64();
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+std::string_view binary::Reader::string() {
+    uint64_t size = varint();
+    return std::string_view(reinterpret_cast<const char*>(raw(size)), size);
+}
+
+const uint8_t *binary::Reader::raw(size_t size) {
+    if (size > (size_t) (end - current)){
+        throw FormatError("Unexpected end of data");
+    }
+
+    const uint8_t* data = current;
+    current += size;
+    return data;
+}
+
+bool binary::Reader::atEnd() const {
+    return current == end;
+}
+
+
+uint64_t binary::fnv1a(std::string_view data) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : data){
+        hash ^= (uint8_t) c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t binary::fnv1a(const std::vector<uint8_t> &data) {
+    return fnv1a(std::string_view(reinterpret_cast<const char*>(data.data()), data.size()));
+}
+
+
+binary::MappedFile::MappedFile(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat info{};
+    if (fstat(fd, &info) == 0 && info.st_size > 0){
+        void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED){
+            mapping = data;
+            length = info.st_size;
+        }
+    }
+
+    close(fd); //The mapping stays valid after closing the descriptor
+}
+
+binary::MappedFile::~MappedFile() {
+    if (mapping != nullptr){
+        munmap(mapping, length);
+    }
+}
+
+bool binary::MappedFile::isOpen() const {
+    return mapping != nullptr;
+}
+
+const uint8_t *binary::MappedFile::data() const {
+    return static_cast<const uint8_t*>(mapping);
+}
+
+size_t binary::MappedFile::size() const {
+    return length;
+}
+
+
+bool binary::writeFileAtomically(const std::string &path, const std::vector<uint8_t> &bytes) {
+    std::string temporaryPath = path + ".tmp" + std::to_string(getpid());
+    int fd = open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    size_t written = 0;
+    while (written < bytes.size()){
+        ssize_t result = write(fd, bytes.data() + written, bytes.size() - written);
+        if (result < 0){
+            if (errno == EINTR) continue;
+            break;
+        }
+        written += result;
+    }
+    close(fd);
+
+    if (written != bytes.size() || rename(temporaryPath.c_str(), path.c_str()) != 0){
+        unlink(temporaryPath.c_str());
+        return false;
+    }
+
+    return true;
+}
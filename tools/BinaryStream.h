@@ -0,0 +1,83 @@
+#ifndef JLOX_BINARYSTREAM_H
+#define JLOX_BINARYSTREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*Helpers to write and read compact binary data (used by the AST cache). Unsigned integers are stored as LEB128 varints so the
+ * small numbers that make up most of the data (lines, distances, indices, lengths) take a single byte. Doubles are stored as their
+ * 8 raw bytes, so they are read back exactly.
+ * */
+namespace binary {
+
+    //Thrown by Reader when the data is truncated or malformed
+    class FormatError : public std::runtime_error {
+    public:
+        explicit FormatError(const std::string &message) : std::runtime_error(message) {}
+    };
+
+    class Writer {
+    public:
+        std::vector<uint8_t> bytes;
+
+        void u8(uint8_t value);
+        void u32(uint32_t value); //fixed width, little endian
+        void u64(uint64_t value); //fixed width, little endian
+        void varint(uint64_t value);
+        void number(double value);
+        void string(std::string_view value);
+        void raw(const void* data, size_t size);
+    };
+
+    //Reads from a buffer that it doesn't own, e.g. a mmaped file. Every read is bounds checked.
+    class Reader {
+    public:
+        Reader(const uint8_t* data, size_t size);
+
+        uint8_t u8();
+        uint32_t u32();
+        uint64_t u64();
+        uint64_t varint();
+        double number();
+        //The returned view points into the buffer
+        std::string_view string();
+        const uint8_t* raw(size_t size);
+        bool atEnd() const;
+
+    private:
+        const uint8_t* current;
+        const uint8_t* end;
+    };
+
+    uint64_t fnv1a(std::string_view data);
+    uint64_t fnv1a(const std::vector<uint8_t> &data);
+
+    //Read only memory mapping of a whole file, unmapped when it goes out of scope
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::string &path);
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        //False if the file doesn't exist, is empty or couldn't be mapped
+        bool isOpen() const;
+        const uint8_t* data() const;
+        size_t size() const;
+
+    private:
+        void* mapping = nullptr;
+        size_t length = 0;
+    };
+
+    /*Writes bytes to a temporary file in the same directory and renames it to path, so readers see either the old file or the
+     * complete new one. Returns false if it couldn't write the file.*/
+    bool writeFileAtomically(const std::string &path, const std::vector<uint8_t> &bytes);
+}
+
+
+#endif //JLOX_BINARYSTREAM_H
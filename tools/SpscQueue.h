@@ -0,0 +1,64 @@
+#ifndef JLOX_SPSCQUEUE_H
+#define JLOX_SPSCQUEUE_H
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+/*Unbounded lock-free queue for exactly one producer thread and one consumer thread. It is a linked list that always starts with a
+ * dummy node: the producer only touches tail and the consumer only touches head, a node is handed over by storing the pointer to it
+ * in the next field of the previous one. Popping a value turns its node into the new dummy and frees the old one.
+ * The handover is sequentially consistent so a consumer can safely go to sleep after seeing the queue empty, see Mailbox in Isolate.h.
+ * */
+template<typename T>
+class SpscQueue {
+public:
+    SpscQueue() : head(new Node()), tail(head) {}
+
+    ~SpscQueue() {
+        while (head != nullptr){
+            Node* next = head->next.load(std::memory_order_relaxed);
+            delete head;
+            head = next;
+        }
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    //Producer only
+    void push(T value) {
+        Node* node = new Node(std::move(value));
+        tail->next.store(node, std::memory_order_seq_cst);
+        tail = node;
+    }
+
+    //Consumer only. nullopt if the queue is empty
+    std::optional<T> pop() {
+        Node* next = head->next.load(std::memory_order_seq_cst);
+        if (next == nullptr){
+            return std::nullopt;
+        }
+
+        std::optional<T> value = std::move(next->value);
+        next->value.reset();
+        delete head;
+        head = next;
+        return value;
+    }
+
+private:
+    struct Node {
+        std::optional<T> value;
+        std::atomic<Node*> next{nullptr};
+
+        Node() = default;
+        explicit Node(T value) : value(std::move(value)) {}
+    };
+
+    Node* head;
+    Node* tail;
+};
+
+
+#endif //JLOX_SPSCQUEUE_H
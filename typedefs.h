@@ -1,4 +1,6 @@
+#include <functional>
 #include <memory>
+#include <vector>
 
 #ifndef JLOX_TYPEDEFS_H
 #define JLOX_TYPEDEFS_H
@@ -6,9 +8,18 @@
 
 class Stmt;
 class Expr;
+class Interpreter;
+class LoxObject;
 
 using UniqueExprPtr = std::unique_ptr<Expr>;
 using UniqueStmtPtr = std::unique_ptr<Stmt>;
 
+//Output of the ClosureCompiler. See ClosureCompiler.h
+using CompiledExpr = std::function<LoxObject(Interpreter&)>;
+using CompiledStmt = std::function<void(Interpreter&)>;
+using CompiledBlock = std::vector<CompiledStmt>;
+using SharedCompiledBlock = std::shared_ptr<const CompiledBlock>;
+using SharedCompiledExpr = std::shared_ptr<const CompiledExpr>;
+
 
 #endif //JLOX_TYPEDEFS_H